@@ -103,6 +103,7 @@ static Uint32 spiwriter()
   Int32	appFileSize = 0;
   Int8	fileName[256];
   Uint32  baseAddress = 0,i;
+  Uint32  eraseSize, unitSize;
 
   DEBUG_printString( "Starting C672x_SPIWriter.\r\n");
 
@@ -164,14 +165,18 @@ static Uint32 spiwriter()
 
     fclose (fPtr);
 
-    // Erase the SPI flash to accomodate the file size
-#if (0)
-    if (SPI_MEM_erase( hSpiMemInfo, baseAddress, appFileSize ) != E_PASS)
+    // Erase the SPI flash to accomodate the file size, in whole erase units
+    eraseSize = appFileSize;
+    if (hSpiMemInfo->eraseTypeCnt > 0)
+    {
+      unitSize  = hSpiMemInfo->eraseTypes[hSpiMemInfo->eraseTypeCnt - 1].size;
+      eraseSize = (appFileSize + unitSize - 1) & ~(unitSize - 1);
+    }
+    if (SPI_MEM_eraseBytes( hSpiMemInfo, baseAddress, eraseSize ) != E_PASS)
     {
       DEBUG_printString("\tERROR: Erasing SPI failed.\r\n");
       return E_FAIL;
     }
-#endif
 
     // Write the application data to the flash (32 bytes at a time)
     for (i = 0; i<appFileSize; i+=32)
@@ -359,6 +359,26 @@ namespace AISGenLib
     
     private List<MemoryRange> sectionMemory;
     
+    // Scratch buffer that section data is converted through on its way to the
+    // AIS stream and the CRC, reused for every section of every file
+    private Byte[] sectionBuffer;
+    private const Int32 SectionBufferWords = 16384;
+    
+    // Fills buffer, from its start, with count words of the data being loaded,
+    // starting wordOffset words in, in the device's byte order
+    private delegate void AISDataReader(UInt32 wordOffset, Int32 count, Byte[] buffer);
+    
+    // Section load optimizer settings (see AISOptimizedLoad)
+    private Boolean optimizeLoads;
+    private UInt32 fillThreshold;
+    private UInt32 mergeGap;
+    private UInt32 gapFill;
+    
+    // Throughput of the boot interface in bytes/sec, for the boot time estimate
+    private UInt32 bootBandwidth;
+    
+    // Print the symbol map of each object file loaded
+    private Boolean dumpSymbols;
     
     #endregion
     
@@ -397,6 +417,12 @@ namespace AISGenLib
       
       // Set defaults
       devAISGen.finalFxnName              = null;
+      devAISGen.optimizeLoads             = false;
+      devAISGen.fillThreshold             = 256;
+      devAISGen.mergeGap                  = 0;
+      devAISGen.gapFill                   = 0x00000000;
+      devAISGen.bootBandwidth             = 0;
+      devAISGen.dumpSymbols               = false;
       // List to keep track of loadable sections and their occupied memory ranges
       devAISGen.sectionMemory = new List<MemoryRange>();
       
@@ -450,6 +476,40 @@ namespace AISGenLib
             // Read entrypoint value
             if (((String)de.Key).Equals("ENTRYPOINT", StringComparison.OrdinalIgnoreCase))
               entryPoint = (UInt32)sec.sectionValues["ENTRYPOINT"];
+            
+            // Section load optimizer ENABLE
+            if (((String)de.Key).Equals("OPTIMIZE", StringComparison.OrdinalIgnoreCase))
+            {
+              if (((String)sec.sectionValues["OPTIMIZE"]).Equals("ON", StringComparison.OrdinalIgnoreCase))
+                devAISGen.optimizeLoads = true;
+              if (((String)sec.sectionValues["OPTIMIZE"]).Equals("TRUE", StringComparison.OrdinalIgnoreCase))
+                devAISGen.optimizeLoads = true;
+            }
+            
+            // Smallest constant run (in bytes) sent as a fill command
+            if (((String)de.Key).Equals("FILLTHRESHOLD", StringComparison.OrdinalIgnoreCase))
+              devAISGen.fillThreshold = (UInt32)sec.sectionValues["FILLTHRESHOLD"];
+            
+            // Largest gap (in bytes) between sections that are merged
+            if (((String)de.Key).Equals("MERGEGAP", StringComparison.OrdinalIgnoreCase))
+              devAISGen.mergeGap = (UInt32)sec.sectionValues["MERGEGAP"];
+            
+            // Word written into the gaps between merged sections
+            if (((String)de.Key).Equals("GAPFILL", StringComparison.OrdinalIgnoreCase))
+              devAISGen.gapFill = (UInt32)sec.sectionValues["GAPFILL"];
+            
+            // Boot interface throughput for the boot time estimate
+            if (((String)de.Key).Equals("BOOTBANDWIDTH", StringComparison.OrdinalIgnoreCase))
+              devAISGen.bootBandwidth = (UInt32)sec.sectionValues["BOOTBANDWIDTH"];
+            
+            // Symbol map dump ENABLE
+            if (((String)de.Key).Equals("DUMPSYMBOLS", StringComparison.OrdinalIgnoreCase))
+            {
+              if (((String)sec.sectionValues["DUMPSYMBOLS"]).Equals("ON", StringComparison.OrdinalIgnoreCase))
+                devAISGen.dumpSymbols = true;
+              if (((String)sec.sectionValues["DUMPSYMBOLS"]).Equals("TRUE", StringComparison.OrdinalIgnoreCase))
+                devAISGen.dumpSymbols = true;
+            }
           }
         }
         
@@ -859,6 +919,9 @@ namespace AISGenLib
           
           if (cf != null)
           {
+            if (devAISGen.dumpSymbols)
+              cf.dumpSymbolMap();
+            
             // Load the object file contents
             AISCOFFLoad(cf, devAISGen);
           }
@@ -925,6 +988,7 @@ namespace AISGenLib
       
       // Console output
       Console.WriteLine("AIS file generation was successful.");
+      AISReportSize(devAISGen);
       
       // ---------------------------------------------------------
       // ******************* END AIS GENERATION ******************
@@ -945,11 +1009,9 @@ namespace AISGenLib
       
       Debug.DebugMSG("Number of words in the stream is {0}", numWords);
 
-      // Copy the data to the output Byte array
-      for (UInt32 i = 0; i < numWords; i++)
-      {
-        BitConverter.GetBytes(tempAIS_br.ReadUInt32()).CopyTo(devAISGen.AISData, i * 4);
-      }
+      // Copy the data to the output Byte array (the stream was written in the
+      // final byte order, so this is a straight copy)
+      tempAIS_br.BaseStream.Read(devAISGen.AISData, 0, devAISGen.AISData.Length);
 
       // Close the binary reader
       tempAIS_br.Close();
@@ -1064,7 +1126,6 @@ namespace AISGenLib
       UInt32 loadAddr = loadAddress;
       UInt32 secSize = (UInt32) (((new FileInfo(fileName)).Length + 3) >> 2) << 2;
       Byte[] secData = new Byte[secSize];
-      Byte[] srcCRCData = new Byte[secSize + 8];
       UInt32 numWords = secSize >> 2;
 
       // Read file data
@@ -1119,14 +1180,66 @@ namespace AISGenLib
                     Hashtable secHeader,
                     AISGen devAISGen)
     {
-      UInt32 secSize = (UInt32)secHeader["byteSize"];
-      String secName = (String)secHeader["name"];
-      UInt32 runAddr = (UInt32)secHeader["phyAddr"];
-      UInt32 loadAddr = (UInt32)secHeader["virAddr"];
-      UInt32 numWords = (UInt32)secHeader["wordSize"];
-      UInt32[] secData = cf[secName];
-      UInt32 crcVal;
-      Byte[] srcCRCData = new Byte[secSize + 8];
+      // The section data is streamed straight from the file a block at a time
+      return AISDataLoad( delegate(UInt32 wordOffset, Int32 count, Byte[] buffer)
+                          {
+                            AISSectionRead(cf, secHeader, devAISGen, wordOffset, count, buffer, 0);
+                          },
+                          (UInt32)secHeader["wordSize"],
+                          (UInt32)secHeader["virAddr"],
+                          (UInt32)secHeader["phyAddr"],
+                          devAISGen );
+    }
+
+    /// <summary>
+    /// Read count words of a section, starting wordOffset words in, into buffer
+    /// at offset, in the device's byte order
+    /// </summary>
+    private static void AISSectionRead(
+                    COFFFile cf,
+                    Hashtable secHeader,
+                    AISGen devAISGen,
+                    UInt32 wordOffset,
+                    Int32 count,
+                    Byte[] buffer,
+                    Int32 offset)
+    {
+      cf.secRead(secHeader, wordOffset << 2, buffer, offset, count << 2);
+      
+      // The file holds the words in its own byte order
+      if (!cf.Endianness.Equals(devAISGen.devEndian.ToString()))
+        Endian.swapEndian(buffer, offset, count << 2, 4);
+    }
+
+    /// <summary>
+    /// AIS Section Load command generation for data supplied a block at a time
+    /// </summary>
+    /// <param name="readData">Delegate that supplies each block of the data.</param>
+    /// <param name="numWords">Number of words to load.</param>
+    /// <param name="loadAddr">Address the data is loaded to.</param>
+    /// <param name="runAddr">Address the data runs from (IDMA relocated if different).</param>
+    /// <param name="devAISGen">The specific device AIS generator object.</param>
+    /// <returns>retType enumerator indicating success or failure.</returns>
+    private static retType AISDataLoad(
+                    AISDataReader readData,
+                    UInt32 numWords,
+                    UInt32 loadAddr,
+                    UInt32 runAddr,
+                    AISGen devAISGen)
+    {
+      UInt32 secSize = numWords << 2;
+      UInt32 crcVal = 0;
+      Byte[] buffer;
+      Int32 blockCnt;
+      
+      // The CRC covers the words as the ROM sees them, which is little endian
+      // unless the AIS stream is in the other byte order from the device
+      Endian crcEndian = (devAISGen.devEndian == devAISGen.devAISEndian) ? Endian.LittleEndian : Endian.BigEndian;
+      Boolean crcSwap = (crcEndian != devAISGen.devEndian);
+      
+      if (devAISGen.sectionBuffer == null)
+        devAISGen.sectionBuffer = new Byte[SectionBufferWords * 4];
+      buffer = devAISGen.sectionBuffer;
 
       EndianBinaryWriter ebw = new EndianBinaryWriter(
           devAISGen.devAISStream,
@@ -1141,37 +1254,27 @@ namespace AISGenLib
       ebw.Write(loadAddr);
       ebw.Write(secSize);
       
-      // Copy bytes to byte array for future CRC calculation
+      // Start the CRC with the load address and size
       if (devAISGen.crcType != CRCCheckType.NO_CRC)
       {
-        if (devAISGen.devEndian != devAISGen.devAISEndian)
-        {
-          Endian.swapEndian(BitConverter.GetBytes(loadAddr)).CopyTo(srcCRCData, 0);
-          Endian.swapEndian(BitConverter.GetBytes(secSize)).CopyTo(srcCRCData, 4);
-        }
-        else
-        {
-          BitConverter.GetBytes(loadAddr).CopyTo(srcCRCData, 0);
-          BitConverter.GetBytes(secSize).CopyTo(srcCRCData, 4);
-        }
-        
+        crcEndian.GetBytes(loadAddr, buffer, 0);
+        crcEndian.GetBytes(secSize, buffer, 4);
+        crcVal = devAISGen.devCRC.CalculateCRC(buffer, 0, 8);
       }
 
-      // Now write contents
-      for (int k = 0; k < numWords; k++)
+      // Now write contents, a block at a time, feeding each block to the CRC
+      // as it goes out
+      for (int k = 0; k < numWords; k += blockCnt)
       {
-        ebw.Write(secData[k]);
-        // Copy bytes to array for future CRC calculation
+        blockCnt = (Int32) Math.Min(numWords - k, SectionBufferWords);
+        readData((UInt32)k, blockCnt, buffer);
+        ebw.Write(buffer, 0, blockCnt * 4);
+        
         if (devAISGen.crcType != CRCCheckType.NO_CRC)
         {
-          if (devAISGen.devEndian != devAISGen.devAISEndian)
-          {
-            Endian.swapEndian(BitConverter.GetBytes(secData[k])).CopyTo(srcCRCData, (8 + k * 4));
-          }
-          else
-          {
-            BitConverter.GetBytes(secData[k]).CopyTo(srcCRCData, (8 + k * 4));
-          }
+          if (crcSwap)
+            Endian.swapEndian(buffer, 0, blockCnt * 4, 4);
+          crcVal = devAISGen.devCRC.AppendCRC(buffer, 0, blockCnt * 4);
         }
       }
         
@@ -1246,7 +1349,6 @@ namespace AISGenLib
       // Perform CRC calculation of the sub-section's contents
       if (devAISGen.crcType != CRCCheckType.NO_CRC)
       {
-        crcVal = devAISGen.devCRC.CalculateCRC(srcCRCData);
         if (devAISGen.crcType == CRCCheckType.SECTION_CRC)
         {
           // Write CRC request command, value, and jump value to temp AIS file
@@ -1271,8 +1373,9 @@ namespace AISGenLib
                     COFFFile cf,
                     AISGen devAISGen)
     {
-        UInt32 numSymbols, numSections, numTargetSections;
-        Hashtable[] symbols, sections, targetSections;
+        UInt32 numSections, numTargetSections;
+        Hashtable[] sections, targetSections;
+        Hashtable TIBootSetupSym;
         UInt32 totalLoadableSize = 0;
         UInt32 TIBootSetupAddr = 0x00000000;
 
@@ -1292,10 +1395,6 @@ namespace AISGenLib
         numSections = (UInt32)cf.Header["numSectionHdrs"];
         sections = cf.Sections;
 
-        // Get COFF file symbol info
-        numSymbols = (UInt32)cf.Header["numEntriesInSymTable"];
-        symbols = cf.Symbols;
-
         // Make sure the .TIBoot section is first (if it exists)
         Hashtable firstSection = sections[0];
         for (Int32 i = 1; i < numSections; i++)
@@ -1309,13 +1408,11 @@ namespace AISGenLib
         }
 
         // Look for the _TIBootSetup symbol (if it exists)
-        for (Int32 i = 0; i < numSymbols; i++)
+        TIBootSetupSym = cf.symFind("_TIBootSetup");
+        if (TIBootSetupSym != null)
         {
-            if (((String)symbols[i]["name"]).Equals("_TIBootSetup"))
-            {
-                TIBootSetupAddr = (UInt32)symbols[i]["value"];
-                Debug.DebugMSG("Symbol :{0}:", (String)symbols[i]["name"]);
-            }
+            TIBootSetupAddr = (UInt32)TIBootSetupSym["value"];
+            Debug.DebugMSG("Symbol :{0}:", (String)TIBootSetupSym["name"]);
         }
         
 
@@ -1343,6 +1440,31 @@ namespace AISGenLib
         
 
         // Do all SECTION_LOAD commands
+        if (devAISGen.optimizeLoads)
+        {
+            Int64 loadStart = devAISGen.devAISStream.Position;
+            
+            if (AISOptimizedLoad(cf, targetSections, TIBootSetupAddr, devAISGen) != retType.SUCCESS)
+                return retType.FAIL;
+            
+            // Re-run everything from the first load command if the single CRC fails
+            if (devAISGen.crcType == CRCCheckType.SINGLE_CRC)
+            {
+                ebw.Write((UInt32)AIS.RequestCRC);
+                ebw.Write(devAISGen.devCRC.CurrentCRC);
+                ebw.Write( (Int32)(-1) * (Int32)(devAISGen.devAISStream.Position - loadStart + 4) );
+            }
+            
+            if (devAISGen.crcType != CRCCheckType.NO_CRC)
+            {
+                ebw.Write((UInt32)AIS.DisableCRC);
+            }
+            
+            Debug.DebugMSG("AISCOFFLoad Complete");
+            
+            return retType.SUCCESS;
+        }
+        
         for (Int32 i = 0; i < numTargetSections; i++)
         {
             if (AISSectionLoad(cf,targetSections[i],devAISGen) != retType.SUCCESS)
@@ -1379,6 +1501,295 @@ namespace AISGenLib
 
         return retType.SUCCESS;
     }     
+    
+    /// <summary>
+    /// Optimized AIS load of the loadable sections of a COFF file.  Sections go
+    /// out in load address order (a section followed by the TIBootSetup jump
+    /// stays first), sections that touch or are at most mergeGap bytes apart are
+    /// merged into one load with the gap filled by gapFill, and runs of one
+    /// repeated word at least fillThreshold bytes long are sent as Section_Fill
+    /// commands instead of data.  Every command saved also saves the CRC request
+    /// and UARTSendDONE jump that would follow it.
+    /// </summary>
+    /// <param name="cf">The COFFfile object that the sections come from.</param>
+    /// <param name="sections">The loadable section headers.</param>
+    /// <param name="TIBootSetupAddr">Address to jump to after the first section (0 for none).</param>
+    /// <param name="devAISGen">The specific device AIS generator object.</param>
+    /// <returns>retType enumerator indicating success or failure.</returns>
+    private static retType AISOptimizedLoad(
+                    COFFFile cf,
+                    Hashtable[] sections,
+                    UInt32 TIBootSetupAddr,
+                    AISGen devAISGen)
+    {
+        List<Hashtable> ordered = new List<Hashtable>();
+        List<Hashtable> group = new List<Hashtable>();
+        UInt32 groupAddr = 0, groupEnd = 0;
+        Int32 numLoads = 0, numFills = 0;
+        UInt32 numFillBytes = 0;
+
+        EndianBinaryWriter ebw = new EndianBinaryWriter(
+            devAISGen.devAISStream,
+            devAISGen.devEndian);
+
+        // Empty sections need no command at all
+        foreach (Hashtable sec in sections)
+        {
+            if ((UInt32)sec["wordSize"] != 0)
+                ordered.Add(sec);
+        }
+        
+        // The first section stays first if the TIBootSetup jump follows it
+        if ((TIBootSetupAddr != 0) && (sections.Length > 0))
+        {
+            if (ordered.Remove(sections[0]))
+            {
+                if ((UInt32)sections[0]["virAddr"] != (UInt32)sections[0]["phyAddr"])
+                {
+                    if (AISSectionLoad(cf, sections[0], devAISGen) != retType.SUCCESS)
+                        return retType.FAIL;
+                    numLoads++;
+                }
+                else
+                {
+                    AISOptimizedGroupLoad(cf, new Hashtable[] { sections[0] }, devAISGen, ref numLoads, ref numFills, ref numFillBytes);
+                }
+            }
+            ebw.Write((UInt32)AIS.Jump);
+            ebw.Write(TIBootSetupAddr);
+        }
+        
+        ordered.Sort(delegate(Hashtable a, Hashtable b)
+        {
+            return ((UInt32)a["virAddr"]).CompareTo((UInt32)b["virAddr"]);
+        });
+        
+        // Gather runs of mergeable sections and load each run as one block
+        foreach (Hashtable sec in ordered)
+        {
+            UInt32 loadAddr = (UInt32)sec["virAddr"];
+            Boolean relocated = (loadAddr != (UInt32)sec["phyAddr"]);
+            
+            if ( (group.Count > 0) && !relocated &&
+                 (loadAddr >= groupEnd) &&
+                 ((loadAddr - groupEnd) <= devAISGen.mergeGap) &&
+                 (((loadAddr - groupEnd) & 0x3) == 0) )
+            {
+                group.Add(sec);
+                groupEnd = loadAddr + (UInt32)sec["byteSize"];
+                continue;
+            }
+            
+            if (group.Count > 0)
+            {
+                AISOptimizedGroupLoad(cf, group.ToArray(), devAISGen, ref numLoads, ref numFills, ref numFillBytes);
+                group.Clear();
+            }
+            
+            if (relocated)
+            {
+                // IDMA relocated sections are sent whole
+                if (AISSectionLoad(cf, sec, devAISGen) != retType.SUCCESS)
+                    return retType.FAIL;
+                numLoads++;
+            }
+            else
+            {
+                group.Add(sec);
+                groupAddr = loadAddr;
+                groupEnd = groupAddr + (UInt32)sec["byteSize"];
+            }
+        }
+        
+        if (group.Count > 0)
+        {
+            AISOptimizedGroupLoad(cf, group.ToArray(), devAISGen, ref numLoads, ref numFills, ref numFillBytes);
+        }
+        
+        Console.WriteLine("Optimized {0} sections into {1} loads and {2} fills ({3} bytes filled).",
+            sections.Length, numLoads, numFills, numFillBytes);
+
+        return retType.SUCCESS;
+    }
+    
+    /// <summary>
+    /// Load a run of address ordered sections, which do not need relocation, as
+    /// one block, sending long runs of a repeated word as Section_Fill commands.
+    /// The group is scanned a block at a time, and each load streams its data
+    /// from the file again, so the group is never held in memory as a whole.
+    /// </summary>
+    private static void AISOptimizedGroupLoad(
+                    COFFFile cf,
+                    Hashtable[] group,
+                    AISGen devAISGen,
+                    ref Int32 numLoads,
+                    ref Int32 numFills,
+                    ref UInt32 numFillBytes)
+    {
+        UInt32 addr = (UInt32)group[0]["virAddr"];
+        Hashtable last = group[group.Length - 1];
+        Int32 numWords = (Int32)(((UInt32)last["virAddr"] + (UInt32)last["byteSize"] - addr) >> 2);
+        Int32 scanWords = Math.Min(numWords, SectionBufferWords);
+        Byte[] scanBytes = new Byte[scanWords << 2];
+        UInt32[] words = new UInt32[scanWords];
+        Int32 pos, run, blockStart = 0, blockEnd = 0, runStart = 0, loadStart = 0;
+        UInt32 word = 0, runWord = 0;
+        
+        // Split the block around runs long enough to be worth a fill command.
+        // Going one past the end closes the last run.
+        for (pos = 0; pos <= numWords; pos++)
+        {
+            if (pos < numWords)
+            {
+                if (pos == blockEnd)
+                {
+                    blockStart = pos;
+                    blockEnd = Math.Min(numWords, pos + scanWords);
+                    AISGroupRead(cf, group, devAISGen, (UInt32)blockStart, blockEnd - blockStart, scanBytes);
+                    devAISGen.devEndian.GetWords(scanBytes, 0, words, 0, blockEnd - blockStart);
+                }
+                word = words[pos - blockStart];
+                if ((pos > runStart) && (word == runWord))
+                    continue;
+            }
+            
+            // The run of runWord from runStart ends here
+            run = pos - runStart;
+            if ((run > 0) && (devAISGen.fillThreshold != 0) && ((UInt32)(run << 2) >= devAISGen.fillThreshold))
+            {
+                if (runStart > loadStart)
+                {
+                    AISGroupDataLoad(cf, group, devAISGen, loadStart, runStart - loadStart);
+                    numLoads++;
+                }
+                AISSectionFill(devAISGen, addr + (UInt32)(runStart << 2), (UInt32)(run << 2), runWord);
+                numFills++;
+                numFillBytes += (UInt32)(run << 2);
+                loadStart = pos;
+            }
+            runStart = pos;
+            runWord = word;
+        }
+        
+        if (numWords > loadStart)
+        {
+            AISGroupDataLoad(cf, group, devAISGen, loadStart, numWords - loadStart);
+            numLoads++;
+        }
+    }
+    
+    /// <summary>
+    /// Section_Load of count words of a group, starting wordOffset words in
+    /// </summary>
+    private static void AISGroupDataLoad(
+                    COFFFile cf,
+                    Hashtable[] group,
+                    AISGen devAISGen,
+                    Int32 wordOffset,
+                    Int32 count)
+    {
+        UInt32 loadAddr = (UInt32)group[0]["virAddr"] + (UInt32)(wordOffset << 2);
+        
+        AISDataLoad( delegate(UInt32 offset, Int32 n, Byte[] buffer)
+                     {
+                       AISGroupRead(cf, group, devAISGen, (UInt32)wordOffset + offset, n, buffer);
+                     },
+                     (UInt32)count,
+                     loadAddr,
+                     loadAddr,
+                     devAISGen );
+    }
+    
+    /// <summary>
+    /// Read count words of a group, starting wordOffset words from its start,
+    /// into buffer in the device's byte order.  Gaps between the sections read
+    /// as the gap fill word.
+    /// </summary>
+    private static void AISGroupRead(
+                    COFFFile cf,
+                    Hashtable[] group,
+                    AISGen devAISGen,
+                    UInt32 wordOffset,
+                    Int32 count,
+                    Byte[] buffer)
+    {
+        UInt32 groupAddr = (UInt32)group[0]["virAddr"];
+        UInt32 end = wordOffset + (UInt32)count;
+        UInt32 pos = wordOffset;
+        
+        foreach (Hashtable sec in group)
+        {
+            UInt32 secStart = ((UInt32)sec["virAddr"] - groupAddr) >> 2;
+            UInt32 from = Math.Max(secStart, pos);
+            UInt32 to = Math.Min(secStart + (UInt32)sec["wordSize"], end);
+            
+            if (from >= to)
+                continue;
+            for (; pos < from; pos++)
+                devAISGen.devEndian.GetBytes(devAISGen.gapFill, buffer, (Int32)(pos - wordOffset) << 2);
+            AISSectionRead(cf, sec, devAISGen, from - secStart, (Int32)(to - from), buffer, (Int32)(from - wordOffset) << 2);
+            pos = to;
+        }
+        for (; pos < end; pos++)
+            devAISGen.devEndian.GetBytes(devAISGen.gapFill, buffer, (Int32)(pos - wordOffset) << 2);
+    }
+    
+    /// <summary>
+    /// AIS Section Fill command generation (32-bit pattern)
+    /// </summary>
+    /// <param name="devAISGen">The specific device AIS generator object.</param>
+    /// <param name="addr">Start address of the fill.</param>
+    /// <param name="size">Size of the fill in bytes.</param>
+    /// <param name="pattern">Word to fill with.</param>
+    private static void AISSectionFill(
+                    AISGen devAISGen,
+                    UInt32 addr,
+                    UInt32 size,
+                    UInt32 pattern)
+    {
+        EndianBinaryWriter ebw = new EndianBinaryWriter(
+            devAISGen.devAISStream,
+            devAISGen.devEndian);
+        
+        // Write Section_Fill AIS command, address, size, type and pattern
+        ebw.Write((UInt32)AIS.Section_Fill);
+        ebw.Write(addr);
+        ebw.Write(size);
+        ebw.Write((UInt32)0x2);
+        ebw.Write(pattern);
+        
+        // Add this fill's memory range, checking for overlap
+        AddMemoryRange(devAISGen, addr, addr+size-1);
+        
+        // Check if we need to output DONE to the UART
+        if (devAISGen.SendUARTSendDONE)
+        {
+            ebw.Write((UInt32)AIS.Jump);
+            ebw.Write(devAISGen.UARTSendDONEAddr);
+        }
+    }
+    
+    /// <summary>
+    /// Print the size of the generated AIS image and, if the throughput of the
+    /// boot interface is known, an estimate of how long it takes to send.
+    /// </summary>
+    /// <param name="devAISGen">The specific device AIS generator object.</param>
+    private static void AISReportSize(AISGen devAISGen)
+    {
+        Int64 size = devAISGen.devAISStream.Length;
+        UInt32 bandwidth = devAISGen.bootBandwidth;
+        
+        // Without a configured rate assume UART boot at 115200 baud, 8N1
+        if ((bandwidth == 0) && (devAISGen.bootMode == BootModes.UART))
+            bandwidth = 115200 / 10;
+        
+        Console.WriteLine("AIS image size is {0} bytes.", size);
+        if (bandwidth != 0)
+        {
+            Console.WriteLine("Estimated boot time at {0} bytes/sec is {1:F3} sec.",
+                bandwidth, ((Double)size) / bandwidth);
+        }
+    }
     #endregion 
     
     /**
@@ -1432,6 +1843,7 @@ namespace AISGenLib
       Int32 i = 0;
       Int32 numBytesToSend;
       AIS AIScmd;
+      SerialEngine engine = SerialEngine.GetEngine(sp);
       //SerialDataReceivedEventHandler DREH = new SerialDataReceivedEventHandler(SerialReadCallBack);
       
       while (i < len)
@@ -1446,49 +1858,49 @@ namespace AISGenLib
         {
           case AIS.MagicNumber:
             numBytesToSend = 8;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           case AIS.RequestCRC:
             numBytesToSend = 8*3;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           case AIS.EnableCRC:
             numBytesToSend = 8;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           case AIS.DisableCRC:
             numBytesToSend = 8;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           case AIS.FunctionExec:
             UInt16 numParams = UInt16.Parse(ASCIIEncoding.ASCII.GetString(AISdata, i + 8, 4), NumberStyles.HexNumber);
             UInt16 funcIndex = UInt16.Parse(ASCIIEncoding.ASCII.GetString(AISdata, i + 12, 4), NumberStyles.HexNumber);
             Debug.DebugMSG("numParams: {0}, funcIndex: {1}", numParams, funcIndex);
             numBytesToSend = 8*(2 + numParams);
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           case AIS.Section_Load:
             Int32 secSize = Int32.Parse(ASCIIEncoding.ASCII.GetString(AISdata, i + 16, 8), NumberStyles.HexNumber);
             Int32 secAddr = Int32.Parse(ASCIIEncoding.ASCII.GetString(AISdata, i + 8, 8), NumberStyles.HexNumber);
             numBytesToSend = 8*3 + (secSize << 1);
             Debug.DebugMSG("Loading {0} bytes to address 0x{1:X8}.", secSize, secAddr);
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Write(AISdata, i, numBytesToSend);
             //Thread.Sleep(1);
             break;
           case AIS.Section_Fill:
             numBytesToSend = 8*5;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           case AIS.Get:
             numBytesToSend = 8 * 5;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             Byte[] buf = new Byte[4];
-            sp.Read(buf, 0, 4);
+            engine.Read(buf, 0, 4);
             Debug.DebugMSG("0x{3:X2}{2:X2}{1:X2}{0:X2}", buf[0], buf[1], buf[2], buf[3]);
             break;
           case AIS.Set:
             numBytesToSend = 8*5;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             //Thread.Sleep(1);
             break;
           case AIS.Jump:
@@ -1498,10 +1910,10 @@ namespace AISGenLib
             Debug.DebugMSG("Jump Address: {0:X8}", jumpAddr);
             if (jumpAddr !=0)
             {
-                sp.Write(AISdata, i, numBytesToSend);
+                engine.Queue(AISdata, i, numBytesToSend);
                 if ((jumpAddr == devAISGen.UARTSendDONEAddr))
                 {
-                    if (SerialIO.waitForSequence("   DONE\0", "BOOTME ", sp, false))
+                    if (engine.WaitForSequence("   DONE\0", "BOOTME ", false))
                     {
                         Debug.DebugMSG("DONE found!!");
                     }
@@ -1515,19 +1927,20 @@ namespace AISGenLib
             break;
           case AIS.Jump_Close:
             numBytesToSend = 8*4;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
             break;
           default:
             Debug.DebugMSG("Default");
             numBytesToSend = 8;
-            sp.Write(AISdata, i, numBytesToSend);
+            engine.Queue(AISdata, i, numBytesToSend);
 
             break;
         }                
         // Increment to Byte array pointer
         i += numBytesToSend;
       }
-      sp.Write(AISdata, i, len - i);
+      engine.Queue(AISdata, i, len - i);
+      engine.Flush();
       Thread.Sleep(10);
       return retType.SUCCESS;
       //Console.Out.Flush();
@@ -0,0 +1,466 @@
+/****************************************************************
+ *  TI Binary AIS UART Boot Host
+ *  (C) 2010, Texas Instruments, Inc.
+ *
+ *  Sends a binary AIS image to the UART boot loader of devices
+ *  whose ROM takes binary AIS (OMAP-L13x, C642x).  Self-contained
+ *  apart from the SerialEngine, so it can be linked into GUI hosts.
+ ****************************************************************/
+
+using System;
+using System.IO;
+using System.IO.Ports;
+using System.Collections.Generic;
+using UtilLib.IO;
+
+namespace AISGenLib
+{
+  /// <summary>
+  /// Host side of the binary AIS UART boot protocol.  The image is walked one
+  /// command at a time; each opcode is synchronized with the ROM and its
+  /// arguments and payload follow straight away, with no fixed delays and the
+  /// payload sent as bulk writes through the port's SerialEngine.  A command
+  /// that follows one the ROM is finished with as soon as it has been received
+  /// (section loads, CRC enable/disable) is sent without waiting for its opcode
+  /// acknowledgement; those acknowledgements are checked, in order, before the
+  /// next reply from the ROM is read.
+  /// </summary>
+  public class AISUartHost
+  {
+    #region Public Types
+
+    /// <summary>
+    /// Progress and status messages
+    /// </summary>
+    public delegate void LogHandler(String line);
+
+    #endregion
+
+    #region Private Variables
+
+    private const UInt32 AIS_magicWord      = 0x41504954;
+    private const UInt32 AIS_OP_sectionLoad = 0x58535901;
+    private const UInt32 AIS_OP_crcReq      = 0x58535902;
+    private const UInt32 AIS_OP_crcEn       = 0x58535903;
+    private const UInt32 AIS_OP_crcDis      = 0x58535904;
+    private const UInt32 AIS_OP_jump        = 0x58535905;
+    private const UInt32 AIS_OP_jumpClose   = 0x58535906;
+    private const UInt32 AIS_OP_set         = 0x58535907;
+    private const UInt32 AIS_OP_startOver   = 0x58535908;
+    private const UInt32 AIS_OP_cSectionLoad= 0x58535909;
+    private const UInt32 AIS_OP_sectionFill = 0x5853590A;
+    private const UInt32 AIS_OP_ping        = 0x5853590B;
+    private const UInt32 AIS_OP_get         = 0x5853590C;
+    private const UInt32 AIS_OP_fxnExec     = 0x5853590D;
+    private const UInt32 AIS_OP_readWait    = 0x58535914;
+    private const UInt32 AIS_OP_finalFxnReg = 0x58535915;
+    private const UInt32 AIS_OP_seqReadEn   = 0x58535963;
+
+    // Start-word sync bytes (top byte of the XSTA/RSTT words)
+    private const Byte XmtStartByte = 0x58;
+    private const Byte RcvStartByte = 0x52;
+
+    private const Int32 SyncRetries = 10;
+
+    private SerialEngine engine;
+    private LogHandler log;
+    private Byte[] ais;
+    private Int32 cursor;
+    private Queue<UInt32> pendingAcks = new Queue<UInt32>();
+    private Byte[] wordBuf = new Byte[4];
+
+    private Boolean waitForBOOTME = true;
+    private Boolean pipelined = true;
+    private Int32 timeout = 5000;
+    private Int32 pingCount = 2;
+    private UInt32 doneAddress = 0;
+
+    #endregion
+
+    #region Public Properties
+
+    /// <summary>
+    /// Wait for the ROM's "BOOTME" before starting
+    /// </summary>
+    public Boolean WaitForBOOTME
+    {
+      get { return waitForBOOTME; }
+      set { waitForBOOTME = value; }
+    }
+
+    /// <summary>
+    /// Send commands that follow section loads and CRC enable/disable without
+    /// waiting for their opcode acknowledgement first
+    /// </summary>
+    public Boolean Pipelined
+    {
+      get { return pipelined; }
+      set { pipelined = value; }
+    }
+
+    /// <summary>
+    /// Timeout for each reply from the ROM, in milliseconds
+    /// </summary>
+    public Int32 Timeout
+    {
+      get { return timeout; }
+      set { timeout = value; }
+    }
+
+    /// <summary>
+    /// Number of words exchanged in the ping opcode sync
+    /// </summary>
+    public Int32 PingCount
+    {
+      get { return pingCount; }
+      set { pingCount = value; }
+    }
+
+    /// <summary>
+    /// Address of a UARTSendDONE routine loaded by the image (0 if none).  A
+    /// jump to it is followed by a wait for the "   DONE" it sends.
+    /// </summary>
+    public UInt32 DoneAddress
+    {
+      get { return doneAddress; }
+      set { doneAddress = value; }
+    }
+
+    #endregion
+
+    #region Class Constructors
+
+    public AISUartHost(SerialPort sp, LogHandler logHandler)
+    {
+      engine = SerialEngine.GetEngine(sp);
+      log = logHandler;
+    }
+
+    #endregion
+
+    #region Public functions
+
+    /// <summary>
+    /// Boot the target with a binary AIS image
+    /// </summary>
+    /// <param name="AISdata">The binary (little endian) AIS image.</param>
+    /// <returns>True if the ROM accepted the whole image.</returns>
+    public Boolean Boot(Byte[] AISdata)
+    {
+      UInt32 command, addr, size, crc, crcGuess, args;
+      Int32 seek;
+      Boolean syncNext = true;
+      Int32 opsRead = 0;
+      DateTime startTime;
+
+      ais = AISdata;
+      cursor = 0;
+      pendingAcks.Clear();
+
+      try
+      {
+        if ((ais.Length < 4) || (NextWord() != AIS_magicWord))
+        {
+          Log("Input is not a binary AIS image.");
+          return false;
+        }
+
+        if (waitForBOOTME)
+        {
+          Log("Waiting for BOOTME...");
+          engine.WaitForSequence("BOOTME ", "BOOTME ", false, timeout * 10);
+        }
+
+        startTime = DateTime.Now;
+
+        Log("Performing start-word sync...");
+        if (!StartWordSync())
+        {
+          Log("Start-word sync failed.");
+          return false;
+        }
+
+        Log("Performing ping opcode sync...");
+        if (!PingOpcodeSync())
+        {
+          Log("Ping opcode sync failed.");
+          return false;
+        }
+
+        while (true)
+        {
+          if ((cursor + 4) > ais.Length)
+          {
+            Log("AIS image ended without a Jump_Close command.");
+            return false;
+          }
+
+          command = NextWord();
+          opsRead++;
+
+          // The ROM answers in order, so acknowledgements still owed come first
+          if (syncNext || !pipelined)
+          {
+            DrainAcks();
+            if (!OpcodeSync(command))
+            {
+              Log(String.Format("Opcode sync failed for command {0} (0x{1:X8}).", opsRead, command));
+              return false;
+            }
+          }
+          else
+          {
+            QueueWord(command);
+            pendingAcks.Enqueue(command);
+          }
+          syncNext = true;
+
+          switch (command)
+          {
+            case AIS_OP_sectionLoad:
+            case AIS_OP_cSectionLoad:
+              addr = SendWord();
+              size = SendWord();
+              SendData((Int32)((size + 3) & ~3u));
+              Log(String.Format("Loaded {0}-byte section to address 0x{1:X8}.", size, addr));
+              syncNext = false;
+              break;
+
+            case AIS_OP_crcEn:
+            case AIS_OP_crcDis:
+            case AIS_OP_seqReadEn:
+              syncNext = false;
+              break;
+
+            case AIS_OP_finalFxnReg:
+              SendWord();
+              syncNext = false;
+              break;
+
+            case AIS_OP_sectionFill:
+              // address, size, type, pattern
+              SendWords(4);
+              break;
+
+            case AIS_OP_set:
+              // type, address, data, sleep
+              SendWords(4);
+              break;
+
+            case AIS_OP_readWait:
+              // address, mask, value
+              SendWords(3);
+              break;
+
+            case AIS_OP_fxnExec:
+              args = SendWord();
+              SendWords((Int32)(args >> 16));
+              break;
+
+            case AIS_OP_get:
+              SendWords(4);
+              Log(String.Format("Get returned 0x{0:X8}.", ReadReply()));
+              break;
+
+            case AIS_OP_crcReq:
+              crcGuess = ReadReply();
+              crc = NextWord();
+              seek = (Int32)NextWord();
+              if (crcGuess == crc)
+              {
+                Log("CRC passed.");
+              }
+              else
+              {
+                Log(String.Format("CRC failed (0x{0:X8} != 0x{1:X8}), sending STARTOVER.", crcGuess, crc));
+                if (!OpcodeSync(AIS_OP_startOver))
+                  return false;
+                cursor += seek;
+              }
+              break;
+
+            case AIS_OP_jump:
+              addr = SendWord();
+              if ((doneAddress != 0) && (addr == doneAddress))
+              {
+                DrainAcks();
+                engine.WaitForSequence("   DONE", "   DONE", false, timeout);
+              }
+              break;
+
+            case AIS_OP_jumpClose:
+              addr = SendWord();
+              DrainAcks();
+              Log("Waiting for DONE...");
+              engine.WaitForSequence("   DONE", "   DONE", false, timeout);
+              Log(String.Format("Boot completed, {0} bytes in {1:F1} sec. Jump to address 0x{2:X8}.",
+                cursor, (DateTime.Now - startTime).TotalSeconds, addr));
+              return true;
+
+            default:
+              Log(String.Format("Unhandled opcode (0x{0:X8}).", command));
+              return false;
+          }
+        }
+      }
+      catch (TimeoutException e)
+      {
+        Log(e.Message);
+        return false;
+      }
+      catch (IOException e)
+      {
+        Log("I/O error: " + e.Message);
+        return false;
+      }
+    }
+
+    #endregion
+
+    #region Private helper functions
+
+    private void Log(String line)
+    {
+      if (log != null)
+        log("(AIS UART): " + line);
+    }
+
+    // Keep sending the start byte until the ROM answers with its own
+    private Boolean StartWordSync()
+    {
+      wordBuf[0] = XmtStartByte;
+
+      for (Int32 i = 0; i < SyncRetries; i++)
+      {
+        engine.Queue(wordBuf, 0, 1);
+        try
+        {
+          while (true)
+          {
+            engine.Read(wordBuf, 0, 1, timeout);
+            if (wordBuf[0] == RcvStartByte)
+              return true;
+          }
+        }
+        catch (TimeoutException)
+        {
+          wordBuf[0] = XmtStartByte;
+        }
+      }
+      return false;
+    }
+
+    // Ping opcode, then the count, then 1..count, each echoed by the ROM
+    private Boolean PingOpcodeSync()
+    {
+      if (!OpcodeSync(AIS_OP_ping))
+        return false;
+
+      QueueWord((UInt32)pingCount);
+      if (ReadWord() != (UInt32)pingCount)
+        return false;
+
+      for (UInt32 i = 1; i <= pingCount; i++)
+      {
+        QueueWord(i);
+        if (ReadWord() != i)
+          return false;
+      }
+      return true;
+    }
+
+    // Send an opcode and wait for its acknowledgement, resending on timeout
+    private Boolean OpcodeSync(UInt32 command)
+    {
+      for (Int32 i = 0; i < SyncRetries; i++)
+      {
+        QueueWord(command);
+        try
+        {
+          WaitForAck(command);
+          return true;
+        }
+        catch (TimeoutException)
+        {
+        }
+      }
+      return false;
+    }
+
+    // Check the acknowledgements of every command sent without waiting
+    private void DrainAcks()
+    {
+      while (pendingAcks.Count > 0)
+      {
+        WaitForAck(pendingAcks.Dequeue());
+      }
+    }
+
+    // Skip received bytes until the acknowledgement of the opcode turns up
+    private void WaitForAck(UInt32 command)
+    {
+      UInt32 ack = (command & 0xF0FFFFFF) | 0x02000000;
+      UInt32 window = 0;
+
+      for (Int32 i = 0; ; i++)
+      {
+        engine.Read(wordBuf, 0, 1, timeout);
+        window = (window >> 8) | ((UInt32)wordBuf[0] << 24);
+        if ((i >= 3) && (window == ack))
+          return;
+      }
+    }
+
+    private UInt32 NextWord()
+    {
+      UInt32 word = (UInt32)(ais[cursor] | (ais[cursor + 1] << 8) | (ais[cursor + 2] << 16) | (ais[cursor + 3] << 24));
+      cursor += 4;
+      return word;
+    }
+
+    private void QueueWord(UInt32 word)
+    {
+      wordBuf[0] = (Byte)word;
+      wordBuf[1] = (Byte)(word >> 8);
+      wordBuf[2] = (Byte)(word >> 16);
+      wordBuf[3] = (Byte)(word >> 24);
+      engine.Queue(wordBuf, 0, 4);
+    }
+
+    // Pass the next word of the image on to the ROM
+    private UInt32 SendWord()
+    {
+      UInt32 word = NextWord();
+      QueueWord(word);
+      return word;
+    }
+
+    private void SendWords(Int32 count)
+    {
+      for (Int32 i = 0; i < count; i++)
+        SendWord();
+    }
+
+    private void SendData(Int32 count)
+    {
+      engine.Write(ais, cursor, count);
+      cursor += count;
+    }
+
+    // Read a command's reply word; the ROM sends it after the acknowledgements
+    // still owed, including that of the command itself if it was not synced
+    private UInt32 ReadReply()
+    {
+      DrainAcks();
+      return ReadWord();
+    }
+
+    private UInt32 ReadWord()
+    {
+      engine.Read(wordBuf, 0, 4, timeout);
+      return (UInt32)(wordBuf[0] | (wordBuf[1] << 8) | (wordBuf[2] << 16) | (wordBuf[3] << 24));
+    }
+
+    #endregion
+  }
+}
@@ -73,6 +73,59 @@ namespace AISGenLib
     public Boolean encrypt;
   }
   
+  /// <summary>
+  /// Encrypts one section on a pool thread, so all the sections of an object
+  /// file to be encrypted are done in parallel ahead of being written out.
+  /// Each section is encrypted on its own from the CEK initial value, so the
+  /// result is the same as encrypting them in turn.
+  /// </summary>
+  internal class SecureEncryptJob
+  {
+    private Byte[] plainData, key, iv;
+    private Byte[] encData;
+    private Exception error;
+    private ManualResetEvent done = new ManualResetEvent(false);
+    
+    public SecureEncryptJob(Byte[] plainData, Byte[] key, Byte[] iv)
+    {
+      this.plainData = plainData;
+      this.key = key;
+      this.iv = iv;
+      ThreadPool.QueueUserWorkItem(new WaitCallback(this.Run));
+    }
+    
+    private void Run(Object state)
+    {
+      try
+      {
+        encData = AesManagedUtil.AesCTSEncrypt(plainData, key, iv);
+      }
+      catch (Exception e)
+      {
+        error = e;
+      }
+      finally
+      {
+        plainData = null;
+        done.Set();
+      }
+    }
+    
+    /// <summary>
+    /// Wait for the encrypted data; rethrows any exception from encryption
+    /// </summary>
+    public Byte[] Result
+    {
+      get
+      {
+        done.WaitOne();
+        if (error != null)
+          throw error;
+        return encData;
+      }
+    }
+  }
+  
   /// <summary>
   /// Public abstract class (with static parts) to handle generic activities
   /// for device specific AISGen objects.
@@ -105,7 +158,7 @@ namespace AISGenLib
       }
     }
     
-    public Stream signatureStream;
+    public HashStream signatureStream;
     
     // Encryption Key
     public Byte[] customerEncryptionKey;
@@ -185,7 +238,7 @@ namespace AISGenLib
       EndianBinaryWriter tempAIS_bw       = new EndianBinaryWriter( devAISGen.devAISStream, devAISGen.devEndian);
       
       // Setup the binary writer to store data for signing
-      devAISGen.signatureStream           = new MemoryStream();                                                    
+      devAISGen.signatureStream           = new HashStream();                                                    
       EndianBinaryWriter sig_bw           = new EndianBinaryWriter( devAISGen.signatureStream, devAISGen.devEndian);
 
       #region INI Data parsing
@@ -563,6 +616,7 @@ namespace AISGenLib
       try
       {
         devAISGen.currHashAlgorithm = HashAlgorithm.Create(currHashAlgorithmString);
+        devAISGen.signatureStream.HashAlgorithm = HashAlgorithm.Create(currHashAlgorithmString);
         Console.WriteLine("INFO: Current SHA algorithm is {0}.",devAISGen.currHashAlgorithmValue);
       }
       catch (Exception e)
@@ -1004,8 +1058,8 @@ namespace AISGenLib
           CRCCheckType tempCRCType = devAISGen.crcType;
           devAISGen.crcType = CRCCheckType.NO_CRC;
           devAISGen.SendUARTSendDONE = false;
-          SecureAISSectionLoad(AISExtrasCF, UARTSendDONE_TextSection, devAISGen, false);
-          SecureAISSectionLoad(AISExtrasCF, UARTSendDONE_DataSection, devAISGen, false);
+          SecureAISSectionLoad(AISExtrasCF, UARTSendDONE_TextSection, devAISGen, null);
+          SecureAISSectionLoad(AISExtrasCF, UARTSendDONE_DataSection, devAISGen, null);
           devAISGen.SendUARTSendDONE = true;
           devAISGen.crcType = tempCRCType;
         }
@@ -1342,11 +1396,9 @@ namespace AISGenLib
 
       Debug.DebugMSG("Number of words in the stream is {0}", numWords);
 
-      // Copy the data to the output Byte array
-      for (UInt32 i = 0; i < numWords; i++)
-      {
-        BitConverter.GetBytes(tempAIS_br.ReadUInt32()).CopyTo(devAISGen.AISData, i * 4);
-      }
+      // Copy the data to the output Byte array (the stream was written in the
+      // final byte order, so this is a straight copy)
+      tempAIS_br.BaseStream.Read(devAISGen.AISData, 0, devAISGen.AISData.Length);
 
       // Close the binary reader
       tempAIS_br.Close();
@@ -1442,23 +1494,17 @@ namespace AISGenLib
     /// <summary>
     /// Signature insertion creation and insertion routine
     /// </summary>
-    public static retType SecureAISInsertSignature( Stream sigStream, AISGen devAISGen )
+    public static retType SecureAISInsertSignature( HashStream sigStream, AISGen devAISGen )
     {
       EndianBinaryWriter ebw = new EndianBinaryWriter(
           devAISGen.devAISStream,
           devAISGen.devEndian);
       
-      // Make sure all data is present for signature calculation
-      sigStream.Flush();
-      
-      // Reset stream to start
-      sigStream.Position = 0;
-      
       // Increment signature count
       devAISGen.signatureCnt++;
 
-      // Calculate hash of data
-      Byte[] hash = devAISGen.currHashAlgorithm.ComputeHash(sigStream);
+      // Finish the hash of the data written since the last signature
+      Byte[] hash = sigStream.FinishHash();
       Console.WriteLine("Signature #{0}",devAISGen.signatureCnt);
       Console.WriteLine("\tSignature Hash: {0}",BitConverter.ToString(hash));
       Console.WriteLine("\tSignature Byte Count = {0}",sigStream.Length);
@@ -1494,7 +1540,7 @@ namespace AISGenLib
         RSAPKCS1SignatureFormatter rsaFormatter = new RSAPKCS1SignatureFormatter(devAISGen.rsaObject);
 
         // Create a signature for HashValue and return it.
-        signatureData = rsaFormatter.CreateSignature(devAISGen.currHashAlgorithm);
+        signatureData = rsaFormatter.CreateSignature(sigStream.HashAlgorithm);
         
         // Signature info needs to be revered to work with RSA functionality in ROM
         Array.Reverse(signatureData);
@@ -1503,9 +1549,8 @@ namespace AISGenLib
       // Write the signature data to the output AIS binary writer
       ebw.Write(signatureData);
         
-      // Clear the signature stream now that we have used the data for signature generation
+      // Start a new hash for the next signature
       sigStream.SetLength(0);
-      sigStream.Position = 0;
       
       return retType.SUCCESS;
     }
@@ -1527,7 +1572,6 @@ namespace AISGenLib
       UInt32 loadAddr = loadAddress;
       UInt32 secSize = (UInt32) (((new FileInfo(fileName)).Length + 3) >> 2) << 2;
       Byte[] secData = new Byte[secSize];
-      Byte[] srcCRCData = new Byte[secSize + 8];
       UInt32 numWords = secSize >> 2;
 
       // Read file data
@@ -1629,20 +1673,19 @@ namespace AISGenLib
     /// <param name="cf">The COFFfile object that the section comes from.</param>
     /// <param name="secHeader">The Hashtable object of the section header to load.</param>
     /// <param name="devAISGen">The specific device AIS generator object.</param>
+    /// <param name="encryptJob">Encryption of the section's data, or null to load it unencrypted.</param>
     /// <returns>retType enumerator indicating success or failure.</returns>
     private static retType SecureAISSectionLoad(
                     COFFFile cf,
                     Hashtable secHeader,
                     AISGen devAISGen,
-                    Boolean encryptSection)
+                    SecureEncryptJob encryptJob)
     {
       UInt32 secSize = (UInt32)secHeader["byteSize"];
-      String secName = (String)secHeader["name"];
       UInt32 runAddr = (UInt32)secHeader["phyAddr"];
       UInt32 loadAddr = (UInt32)secHeader["virAddr"];
       UInt32 numWords = (UInt32)secHeader["wordSize"];
-      UInt32[] secData = cf[secName];
-      Byte[] srcCRCData = new Byte[secSize + 8];
+      Boolean encryptSection = (encryptJob != null);
 
       EndianBinaryWriter ebw = new EndianBinaryWriter(
           devAISGen.devAISStream,
@@ -1678,38 +1721,21 @@ namespace AISGenLib
       if (!encryptSection)
       {
         // Non-encrypted section
-        for (int k = 0; k < numWords; k++)
-        {
-          ebw.Write(secData[k]);
-          sig_bw.Write(secData[k]);
-          devAISGen.signatureByteCnt += 4;
-        }
+        SecureAISWriteSectionData(cf, secHeader, devAISGen, ebw, sig_bw);
+        devAISGen.signatureByteCnt += (Int32)numWords * 4;
       }
       else
       {
         // Encrypted section
         // Write unencrypted data to the signature buffer
-        for (int k = 0; k < numWords; k++)
-        {
-          sig_bw.Write(secData[k]);
-          devAISGen.signatureByteCnt += 4;
-        }
+        SecureAISWriteSectionData(cf, secHeader, devAISGen, null, sig_bw);
+        devAISGen.signatureByteCnt += (Int32)numWords * 4;
         Console.WriteLine("Wrote {0} bytes to signature buffer.", numWords *4);
       
-        Byte[] tempData = new Byte[numWords * 4];
-        EndianBinaryWriter tempEbw = new EndianBinaryWriter(new MemoryStream(tempData), devAISGen.devEndian);
-        
-        // Write data to the tempData through the endian binary writer/memory stream
-        for (int k = 0; k < numWords; k++)
-        {
-          tempEbw.Write(secData[k]);
-        }
-        tempEbw.Close();   
-        
-        // Encrypt data using CTS algorithm
+        // Collect the data encrypted (CTS algorithm) by the section's job
         try
         {
-          Byte[] encData = AesManagedUtil.AesCTSEncrypt(tempData,devAISGen.customerEncryptionKey,devAISGen.CEKInitialValue);
+          Byte[] encData = encryptJob.Result;
           
           // Write encrypted section data out to AIS data stream
           ebw.Write(encData);
@@ -1830,6 +1856,43 @@ namespace AISGenLib
       return retType.SUCCESS;
     }
 
+    /// <summary>
+    /// Write a section's data to the AIS stream (if ebw is not null) and the
+    /// signature stream.  When the file is in the device's byte order the data
+    /// is streamed straight from it a block at a time.
+    /// </summary>
+    private static void SecureAISWriteSectionData(
+                    COFFFile cf,
+                    Hashtable secHeader,
+                    AISGen devAISGen,
+                    EndianBinaryWriter ebw,
+                    EndianBinaryWriter sig_bw)
+    {
+      UInt32 numWords = (UInt32)secHeader["wordSize"];
+      Int32 blockCnt;
+      
+      if (!cf.Endianness.Equals(devAISGen.devEndian.ToString()))
+      {
+        UInt32[] secData = cf[(String)secHeader["name"]];
+        if (ebw != null)
+          ebw.Write(secData, 0, (Int32)numWords);
+        sig_bw.Write(secData, 0, (Int32)numWords);
+        return;
+      }
+      
+      if (devAISGen.sectionBuffer == null)
+        devAISGen.sectionBuffer = new Byte[SectionBufferWords * 4];
+      
+      for (UInt32 k = 0; k < numWords; k += (UInt32)blockCnt)
+      {
+        blockCnt = (Int32) Math.Min(numWords - k, SectionBufferWords);
+        cf.secRead(secHeader, k << 2, devAISGen.sectionBuffer, 0, blockCnt << 2);
+        if (ebw != null)
+          ebw.Write(devAISGen.sectionBuffer, 0, blockCnt << 2);
+        sig_bw.Write(devAISGen.sectionBuffer, 0, blockCnt << 2);
+      }
+    }
+
     /// <summary>
     /// AIS COFF file Load command generation (loads all sections)
     /// </summary>
@@ -1840,8 +1903,9 @@ namespace AISGenLib
                     COFFFile cf,
                     AISGen devAISGen)
     {
-      UInt32 numSymbols, numSections, numTargetSections;
-      Hashtable[] symbols, sections, targetSections;
+      UInt32 numSections, numTargetSections;
+      Hashtable[] sections, targetSections;
+      Hashtable TIBootSetupSym;
       UInt32 totalLoadableSize = 0;
       UInt32 TIBootSetupAddr = 0x00000000;
 
@@ -1867,10 +1931,6 @@ namespace AISGenLib
       numSections = (UInt32)cf.Header["numSectionHdrs"];
       sections = cf.Sections;
 
-      // Get COFF file symbol info
-      numSymbols = (UInt32)cf.Header["numEntriesInSymTable"];
-      symbols = cf.Symbols;
-
       // Make sure the .TIBoot section is first (if it exists)
       Hashtable firstSection = sections[0];
       for (Int32 i = 1; i < numSections; i++)
@@ -1884,13 +1944,11 @@ namespace AISGenLib
       }
 
       // Look for the _TIBootSetup symbol (if it exists)
-      for (Int32 i = 0; i < numSymbols; i++)
+      TIBootSetupSym = cf.symFind("_TIBootSetup");
+      if (TIBootSetupSym != null)
       {
-        if (((String)symbols[i]["name"]).Equals("_TIBootSetup"))
-        {
-          TIBootSetupAddr = (UInt32)symbols[i]["value"];
-          Debug.DebugMSG("Symbol :{0}:", (String)symbols[i]["name"]);
-        }
+        TIBootSetupAddr = (UInt32)TIBootSetupSym["value"];
+        Debug.DebugMSG("Symbol :{0}:", (String)TIBootSetupSym["name"]);
       }
 
       // Create array of Hashtable describing loadable sections
@@ -1910,7 +1968,9 @@ namespace AISGenLib
       
       // If the devAISGen.sectionsToEncrypt just says "ALL", then rebuild it with all loadable sections
 
-      // Do all SECTION_LOAD commands (encrypted and/or secure)
+      // Start encrypting every section to be encrypted, so they are done in
+      // parallel while the loads are written out in order below
+      SecureEncryptJob[] encryptJobs = new SecureEncryptJob[numTargetSections];
       for (Int32 i = 0; i < numTargetSections; i++)
       {
         Boolean encryptSection = false;
@@ -1931,7 +1991,23 @@ namespace AISGenLib
           }
         }
       
-        if (SecureAISSectionLoad(cf, targetSections[i], devAISGen, encryptSection) != retType.SUCCESS)
+        if (encryptSection)
+        {
+          UInt32 numWords = (UInt32)targetSections[i]["wordSize"];
+          Byte[] plainData = new Byte[numWords * 4];
+          cf.secRead(targetSections[i], 0, plainData, 0, plainData.Length);
+          
+          // The file holds the words in its own byte order
+          if (!cf.Endianness.Equals(devAISGen.devEndian.ToString()))
+            Endian.swapEndian(plainData, 0, plainData.Length, 4);
+          encryptJobs[i] = new SecureEncryptJob(plainData, devAISGen.customerEncryptionKey, devAISGen.CEKInitialValue);
+        }
+      }
+
+      // Do all SECTION_LOAD commands (encrypted and/or secure)
+      for (Int32 i = 0; i < numTargetSections; i++)
+      {
+        if (SecureAISSectionLoad(cf, targetSections[i], devAISGen, encryptJobs[i]) != retType.SUCCESS)
           return retType.FAIL;
         totalLoadableSize += (UInt32)targetSections[i]["byteSize"];
         
@@ -13,6 +13,7 @@ using System.Reflection;
 using System.Threading;
 using System.Globalization;
 using System.Collections;
+using System.Collections.Generic;
 using UtilLib;
 
 namespace UtilLib.IO
@@ -60,6 +61,12 @@ namespace UtilLib.IO
         private Hashtable headerRef;
         private Hashtable[] sectionRef;       
         private Hashtable[] symRef;
+        private Dictionary<String,UInt32> sectionIndex;
+        private Dictionary<String,UInt32> symbolIndex;
+        private String[] sectionNames;
+
+        // Words read from the file per transfer when a whole section is read
+        private const UInt32 SecReadBlockWords = 16384;
         #endregion
 
         #region Public properties and indexers
@@ -132,8 +139,10 @@ namespace UtilLib.IO
             FileInfo fi = new FileInfo(filename);
             try
             {
+                // Section data is read on demand, a window at a time, so the
+                // file is opened for random access rather than read up front
                 if (fi.Exists)
-                    binFile = new FileStream(filename, FileMode.Open, FileAccess.Read);
+                    binFile = new FileStream(filename, FileMode.Open, FileAccess.Read, FileShare.Read, 4096, FileOptions.RandomAccess);
             }
             catch (Exception e)
             {
@@ -218,6 +227,42 @@ namespace UtilLib.IO
             }
         }
 
+        /// <summary>
+        /// Print the named symbols sorted by address, with the section each
+        /// one belongs to
+        /// </summary>
+        public void dumpSymbolMap()
+        {
+            List<Hashtable> named = new List<Hashtable>(symbolIndex.Count);
+            foreach (UInt32 symNum in symbolIndex.Values)
+                named.Add(symRef[symNum]);
+            named.Sort(delegate(Hashtable a, Hashtable b)
+            {
+                return ((UInt32)a["value"]).CompareTo((UInt32)b["value"]);
+            });
+
+            Console.WriteLine("Symbol map of {0}:", (String)headerRef["fullName"]);
+            Console.WriteLine("\tAddress   \tSection         \tName");
+            Console.WriteLine("\t==========\t================\t========");
+            foreach (Hashtable sym in named)
+            {
+                UInt32 secNum = (UInt32)sym["secNum"];
+                String secName;
+                
+                // Section numbers are one-based; 0 is undefined, 0xFFFF absolute
+                // and 0xFFFE debug
+                if ((secNum > 0) && (secNum <= sectionNames.Length))
+                    secName = sectionNames[secNum - 1];
+                else if (secNum == 0)
+                    secName = "(undef)";
+                else if (secNum == 0xFFFE)
+                    secName = "(debug)";
+                else
+                    secName = "(abs)";
+                Console.WriteLine("\t0x{0:X8}\t{1,-16}\t{2}", (UInt32)sym["value"], secName, (String)sym["name"]);
+            }
+        }
+
         public void dumpFileHeader()
         {
             foreach (DictionaryEntry de in headerRef)
@@ -277,15 +322,23 @@ namespace UtilLib.IO
         public Hashtable secFind(String secName)
         {
             //Debug.DebugMSG("secFind("+secName+")");
-            UInt32 numSections = ((UInt32)headerRef["numSectionHdrs"]);
-            for (UInt32 i = 0; i < numSections; i++)
+            UInt32 secNum;
+            if (sectionIndex.TryGetValue(secName, out secNum))
             {
-                
-                if ( ((String)sectionRef[i]["name"]).Equals(secName))
+                // Callers may reorder the array returned by Sections, so fall
+                // back to a scan if the indexed slot no longer holds the section
+                if ( !((String)sectionRef[secNum]["name"]).Equals(secName) )
                 {
-                    currSecNum = i;
-                    return sectionRef[currSecNum];
+                    UInt32 numSections = ((UInt32)headerRef["numSectionHdrs"]);
+                    for (secNum = 0; secNum < numSections; secNum++)
+                    {
+                        if ( ((String)sectionRef[secNum]["name"]).Equals(secName))
+                            break;
+                    }
+                    sectionIndex[secName] = secNum;
                 }
+                currSecNum = secNum;
+                return sectionRef[currSecNum];
             }
             return null;
         }
@@ -308,32 +361,58 @@ namespace UtilLib.IO
             Hashtable section = sectionRef[currSecNum];
             UInt32 flags = (UInt32)headerRef["flags"];
             UInt32 ws = (UInt32) section["wordSize"];
-            UInt32 dp = (UInt32) section["dataPtr"];
             UInt32[] dataArr = new UInt32[ws];
-            EndianBinaryReader COFFbr;
-            
-            binFile.Seek(dp,SeekOrigin.Begin);
+            Byte[] block = new Byte[Math.Min(ws, SecReadBlockWords) << 2];
+            Endian secEndian;
+            UInt32 n;
             
             if ( (flags & 0x0200) != 0)
             {
                 // Big Endian DSP
-                COFFbr = new EndianBinaryReader(binFile,Endian.BigEndian);
+                secEndian = Endian.BigEndian;
             }
             else
             {
                 // Little Endian DSP
-                COFFbr = new EndianBinaryReader(binFile,Endian.LittleEndian);
+                secEndian = Endian.LittleEndian;
             }
-            //Debug.DebugMSG("secRead(): " + COFFbr.endianness.ToString());
-                            
-            for ( int i = 0; i<ws; i++)
+            //Debug.DebugMSG("secRead(): " + secEndian.ToString());
+            
+            for (UInt32 i = 0; i < ws; i += n)
             {
-                dataArr[i] = COFFbr.ReadUInt32();
+                n = Math.Min(ws - i, SecReadBlockWords);
+                secRead(section, i << 2, block, 0, (Int32)(n << 2));
+                secEndian.GetWords(block, 0, dataArr, (Int32)i, (Int32)n);
             }
 
             return dataArr;
         }
 
+        /// <summary>
+        /// Read part of a section's raw data, in the file's byte order, straight
+        /// into the caller's buffer.  Only the requested window is read, so
+        /// loaders can stream large sections without holding them in memory.
+        /// </summary>
+        /// <param name="section">Section header Hashtable (from Sections or secFind)</param>
+        /// <param name="byteOffset">Offset of the window from the start of the section</param>
+        /// <param name="buffer">Output byte array</param>
+        /// <param name="offset">Offset in the output array of the first byte</param>
+        /// <param name="count">Number of bytes to read</param>
+        public void secRead(Hashtable section, UInt32 byteOffset, Byte[] buffer, Int32 offset, Int32 count)
+        {
+            Int32 n;
+            
+            binFile.Seek((Int64)(UInt32)section["dataPtr"] + byteOffset, SeekOrigin.Begin);
+            while (count > 0)
+            {
+                n = binFile.Read(buffer, offset, count);
+                if (n <= 0)
+                    throw new EndOfStreamException("Section " + (String)section["name"] + " runs past the end of the file.");
+                offset += n;
+                count -= n;
+            }
+        }
+
         public UInt32[] secRead(UInt32 secNum)
         {
             secSeek(secNum);
@@ -371,14 +450,11 @@ namespace UtilLib.IO
         public Hashtable symFind( String symName)
         {
             //Debug.DebugMSG("symFind("+symName+")");
-            UInt32 numSymbols = (UInt32)headerRef["numEntriesInSymTable"];
-            for(UInt16 i = 0; i < numSymbols; i++)
+            UInt32 symNum;
+            if (symbolIndex.TryGetValue(symName, out symNum))
             {
-                if ( ((String)symRef[i]["name"]).Equals(symName))
-                {
-                    currSymNum = i;
-                    return symRef[currSymNum];
-                }
+                currSymNum = symNum;
+                return symRef[currSymNum];
             }
             return null;
         }
@@ -544,12 +620,19 @@ namespace UtilLib.IO
                         
             numSections = (UInt32)headerRef["numSectionHdrs"];
             sectionRef = new Hashtable[numSections];
+            sectionIndex = new Dictionary<String,UInt32>((Int32)numSections);
+            sectionNames = new String[numSections];
             for (UInt16 secNum = 0; secNum < numSections; secNum++)
             {
                 sectionRef[secNum] = new Hashtable();
 
                 COFFbr.BaseStream.Seek(numBytesInSectionHdr * secNum + numBytesInHdr + numBytesInOptHdr, SeekOrigin.Begin);
                 sectionRef[secNum]["name"] = COFF_getName();
+                sectionNames[secNum] = (String)sectionRef[secNum]["name"];
+                
+                // Index by name for secFind; the first section of a name wins
+                if (!sectionIndex.ContainsKey((String)sectionRef[secNum]["name"]))
+                    sectionIndex.Add((String)sectionRef[secNum]["name"], secNum);
                 Debug.DebugMSG("sectionRef[" + secNum.ToString() + "][\"name\"]: " + ((String)sectionRef[secNum]["name"]).ToString());
 
                 COFFbr.BaseStream.Seek(numBytesInSectionHdr * secNum + numBytesInHdr + numBytesInOptHdr + 8, SeekOrigin.Begin);
@@ -655,21 +738,28 @@ namespace UtilLib.IO
         /// </summary>
         private void ParseSymbolTable()
         {
-            EndianBinaryReader COFFbr = new EndianBinaryReader(binFile, endian);
             UInt32 numSymbols = (UInt32) headerRef["numEntriesInSymTable"];
+            UInt32 symbolTableAddr = (UInt32) headerRef["symbolTableAddr"];
+            Byte[] symTable, strTable;
             
             symRef = new Hashtable[numSymbols];
+            symbolIndex = new Dictionary<String,UInt32>((Int32)numSymbols);
+
+            // Read the symbol table, and the string table after it, in one go
+            // each rather than seeking in the file for every symbol field
+            symTable = ReadFileBlock(symbolTableAddr, 18 * numSymbols);
+            strTable = ReadStringTable(symbolTableAddr + (18 * numSymbols));
+            EndianBinaryReader COFFbr = new EndianBinaryReader(new MemoryStream(symTable, false), endian);
 
             // Read the symbol table
             for (UInt32 symNum = 0; symNum < numSymbols; symNum++)
             {
                 symRef[symNum] = new Hashtable();
                 
-                COFFbr.BaseStream.Seek(((UInt32)headerRef["symbolTableAddr"]) + (18 * symNum),SeekOrigin.Begin);
-                symRef[symNum]["name"] = COFF_getName();
+                symRef[symNum]["name"] = COFF_getName(symTable, (Int32)(18 * symNum), strTable);
                 //Debug.DebugMSG("symRef[" + symNum.ToString() + "][\"name\"]: " + ((String)symRef[symNum]["name"]).ToString());
                 
-                COFFbr.BaseStream.Seek(((UInt32)headerRef["symbolTableAddr"]) + (18 * symNum) + 8,SeekOrigin.Begin);
+                COFFbr.BaseStream.Position = (18 * symNum) + 8;
                 
                 symRef[symNum]["value"] = COFFbr.ReadUInt32();
                 //Debug.DebugMSG("symRef[" + symNum.ToString() + "][\"value\"]: " + ((UInt32)symRef[symNum]["value"]).ToString("X8"));
@@ -685,12 +775,90 @@ namespace UtilLib.IO
 
                 symRef[symNum]["auxNum"] = (UInt32) COFFbr.ReadByte();
                 //Debug.DebugMSG("symRef[" + symNum.ToString() + "][\"auxNum\"]: " + ((Byte)symRef[symNum]["auxNum"]).ToString("X2"));
+                
+                // Index by name for symFind; the first symbol of a name wins
+                String name = (String)symRef[symNum]["name"];
+                if ((name.Length != 0) && !symbolIndex.ContainsKey(name))
+                    symbolIndex.Add(name, symNum);
             }
             Debug.DebugMSG("Parse Symbol Table Done");
         } // end of ParseSymbolTable()
         #endregion
 
         #region Private helper and debug functions
+        /// <summary>
+        /// Read a block of the file
+        /// </summary>
+        private Byte[] ReadFileBlock(UInt32 addr, UInt32 count)
+        {
+            Byte[] data = new Byte[count];
+            Int32 n;
+            
+            binFile.Seek(addr, SeekOrigin.Begin);
+            for (Int32 done = 0; done < count; done += n)
+            {
+                n = binFile.Read(data, done, (Int32)count - done);
+                if (n <= 0)
+                    throw new EndOfStreamException("COFF file is truncated.");
+            }
+            return data;
+        }
+
+        /// <summary>
+        /// Read the string table, including its leading length word so that
+        /// name offsets index straight into the returned array.
+        /// </summary>
+        private Byte[] ReadStringTable(UInt32 addr)
+        {
+            Int64 avail = binFile.Length - addr;
+            UInt32 length;
+            
+            if (avail < 4)
+                return new Byte[0];
+            
+            binFile.Seek(addr, SeekOrigin.Begin);
+            length = (new EndianBinaryReader(binFile, endian)).ReadUInt32();
+            if ((length < 4) || (length > avail))
+                length = (UInt32)avail;
+            return ReadFileBlock(addr, length);
+        }
+
+        /// <summary>
+        /// Function to retrieve a symbol's name, either inline in its entry or
+        /// from the string table.
+        /// </summary>
+        /// <param name="entries">Symbol table bytes</param>
+        /// <param name="offset">Offset of the symbol's entry</param>
+        /// <param name="strTable">String table bytes (from ReadStringTable)</param>
+        /// <returns>String containing name.</returns>
+        private String COFF_getName(Byte[] entries, Int32 offset, Byte[] strTable)
+        {
+            UInt32[] ints = new UInt32[2];
+            Byte[] src;
+            Int32 start, end, limit;
+            
+            endian.GetWords(entries, offset, ints, 0, 2);
+            if (ints[0] == 0x00000000)
+            {
+                // The name is stored in the string table
+                src = strTable;
+                start = (Int32)Math.Min(ints[1], (UInt32)strTable.Length);
+                limit = strTable.Length;
+            }
+            else
+            {
+                // The name is stored in the entry itself (up to 8 characters)
+                src = entries;
+                start = offset;
+                limit = offset + 8;
+            }
+            
+            end = start;
+            while ((end < limit) && (src[end] != 0))
+                end++;
+            return ASCIIEncoding.ASCII.GetString(src, start, end - start);
+        }
+
         /// <summary>
         /// Function to retrieve name string either from string table or from current stream pointer.
         /// </summary>
@@ -30,6 +30,7 @@ namespace UtilLib.CRC
     #region Data members
 
     private UInt32[] lut;
+    private UInt32[] sliceLut;  // 8 tables of 256 entries for slice-by-8, table 0 is the byte table
     private UInt32 poly = 0x04C11DB7; //Bit32 is 1 is always 1 and therefore not needed
     private UInt32 initReg = 0xFFFFFFFF;
     private UInt32 finalReg = 0xFFFFFFFF;
@@ -146,8 +147,9 @@ namespace UtilLib.CRC
       this.CrcType = CrcType;
       this.CrcCalcMethod = CrcCalcMethod;
       
-      // Build the look up table
+      // Build the look up tables
       BuildTable();
+      BuildSliceTable();
       
       // Call reset to set initial value for currCRC;
       ResetCRC();
@@ -204,10 +206,106 @@ namespace UtilLib.CRC
         }
       }
     }
+    
+    /// <summary>
+    /// Function to generate the slice-by-8 tables. Entry i of table k is the
+    /// register contribution of byte value i followed by k zero bytes.
+    /// </summary>
+    private void BuildSliceTable()
+    {
+      UInt32 crcAccum;
+      sliceLut = new UInt32[8*256];
+
+      // Table 0 is the one byte table (the 16-bit shift table can't be reused)
+      for (UInt32 i = 0; i < 256; i++)
+      {
+        crcAccum = reflected ? (ReflectNum(i, 8) << 24) : (i << 24);
+        for (Byte j = 0; j < 8; j++)
+        {
+          if ((crcAccum & 0x80000000) != 0x00000000)
+          {
+            crcAccum = (crcAccum << 1) ^ poly;
+          }
+          else
+          {
+            crcAccum = (crcAccum << 1);
+          }
+        }
+        sliceLut[i] = reflected ? ReflectNum(crcAccum, 32) : crcAccum;
+      }
+      
+      for (Int32 k = 1; k < 8; k++)
+      {
+        for (Int32 i = 0; i < 256; i++)
+        {
+          sliceLut[(k * 256) + i] = ShiftZeroByte(sliceLut[((k - 1) * 256) + i]);
+        }
+      }
+    }
+    #endregion
+    
+    #region Private helpers
+    
+    /// <summary>
+    /// Advance the CRC register over one zero byte
+    /// </summary>
+    private UInt32 ShiftZeroByte(UInt32 crc)
+    {
+      if (reflected)
+        return (crc >> 8) ^ sliceLut[crc & 0xFF];
+      else
+        return (crc << 8) ^ sliceLut[crc >> 24];
+    }
+    
+    /// <summary>
+    /// Apply a linear operator over GF(2), given as the images of the 32 unit vectors
+    /// </summary>
+    private static UInt32 Gf2MatrixTimes(UInt32[] mat, UInt32 vec)
+    {
+      UInt32 sum = 0;
+      for (Int32 i = 0; vec != 0; i++, vec >>= 1)
+      {
+        if ((vec & 0x1) != 0)
+          sum ^= mat[i];
+      }
+      return sum;
+    }
+    
+    /// <summary>
+    /// Advance the CRC register over byteCnt zero bytes in O(log(byteCnt)) steps
+    /// by repeated squaring of the one zero byte operator
+    /// </summary>
+    private UInt32 ShiftZeroBytes(UInt32 crc, Int64 byteCnt)
+    {
+      UInt32[] op = new UInt32[32];
+      UInt32[] square = new UInt32[32];
+      
+      for (Int32 i = 0; i < 32; i++)
+      {
+        op[i] = ShiftZeroByte((UInt32)0x1 << i);
+      }
+      
+      while (byteCnt != 0)
+      {
+        if ((byteCnt & 0x1) != 0)
+          crc = Gf2MatrixTimes(op, crc);
+        byteCnt >>= 1;
+        if (byteCnt == 0)
+          break;
+          
+        for (Int32 i = 0; i < 32; i++)
+        {
+          square[i] = Gf2MatrixTimes(op, op[i]);
+        }
+        Array.Copy(square, op, 32);
+      }
+      return crc;
+    }
+    
     #endregion
                                        
     #region Public Methods
-    
+        
     /// <summary>
     /// Calculate the CRC-32 checksum on the given array of bytes
     /// </summary>
@@ -233,7 +331,7 @@ namespace UtilLib.CRC
         if ( CrcCalcMethod == CRCCalcMethod.LUT)
           currCRC = LUTBasedCRC(Data, offset, count);
         else
-          currCRC = BitWiseCRC(Data, offset, count);
+          currCRC = BitWiseCRC(Data, offset, count, initReg);
       }
       else
       {
@@ -241,7 +339,7 @@ namespace UtilLib.CRC
         if ( CrcCalcMethod == CRCCalcMethod.LUT)
           currCRC = LUTBasedCRC(Data, offset, count);
         else
-          currCRC = BitWiseCRC(Data, offset, count);
+          currCRC = BitWiseCRC(Data, offset, count, initReg);
       }
       
       // Prep CRC for output
@@ -250,6 +348,31 @@ namespace UtilLib.CRC
       return (currCRC);
     }
     
+    /// <summary>
+    /// Continue the CRC of the last CalculateCRC()/AppendCRC() call over more
+    /// data, as if that data had been part of the same call.  This lets a large
+    /// block be checksummed in pieces, whatever the CRC type.
+    /// </summary>
+    /// <param name="Data">The input byte array.</param>
+    /// <param name="offset">The offset into the Byte array.</param>
+    /// <param name="count">The number of bytes to use for the CRC calculation.</param>
+    /// <returns>CRC32 value of all the data so far.</returns>
+    public UInt32 AppendCRC(Byte[] Data, int offset, int count)
+    {
+      // Both methods resume from the raw register, so undo the final XOR
+      // that the last calculation applied to currCRC
+      currCRC = currCRC ^ finalReg;
+      if ( CrcCalcMethod == CRCCalcMethod.LUT)
+        currCRC = LUTBasedCRC(Data, offset, count);
+      else
+        currCRC = BitWiseCRC(Data, offset, count, currCRC);
+      
+      // Prep CRC for output
+      currCRC = currCRC ^ finalReg;
+
+      return (currCRC);
+    }
+    
 
     /// <summary>
     /// Calculate the CRC-32 checksum using LUT.
@@ -260,87 +383,107 @@ namespace UtilLib.CRC
     /// <returns>CRC32 value.</returns>
     private UInt32 LUTBasedCRC(Byte[] Data, int offset, int count)
     {
-      UInt32 crc = currCRC;
-      Int32 len = count;
-      Int32 NumBitsPerRegShift = NumBytesPerRegShift * 8;
-      UInt32 Mask = (UInt32)(Math.Pow(2.0, NumBitsPerRegShift) - 1);
+      UInt32 crc = currCRC, hi;
+      Int32 i = offset;
+      Int32 end;
+      UInt32[] t = sliceLut;
       
-      Debug.DebugMSG("LUT-Based CRC, NumBitsPerRegShift = {0}, Refelected = {1}",NumBitsPerRegShift,reflected);
+      Debug.DebugMSG("LUT-Based CRC, NumBitsPerRegShift = {0}, Refelected = {1}",NumBytesPerRegShift * 8,reflected);
       Debug.DebugMSG("Offset = {0}, length = {1}",offset,count);
       Debug.DebugMSG("Interim Calculated CRC = 0x{0:X8}",crc);
 
-      // Perform the algorithm on each byte
+      // Shifting 16 bits per step is the same as two byte steps, except that
+      // a trailing odd byte is left out
+      if (NumBytesPerRegShift == 2)
+        count &= ~0x1;
+      end = offset + count;
+
+      // Eight bytes per step, slice-by-8
       if (reflected)
       {
-        if (NumBytesPerRegShift == 2)
+        for (; (end - i) >= 8; i += 8)
         {
-          for (Int32 i = 0; i < (len / NumBytesPerRegShift); i++)
-          {
-            crc = (crc >> NumBitsPerRegShift) ^ lut[(crc & Mask) ^ ((Data[2 * i + 1 + offset] << 8) | Data[2 * i + offset])];
-          }
+          crc ^= (UInt32)(Data[i] | (Data[i+1] << 8) | (Data[i+2] << 16) | (Data[i+3] << 24));
+          hi   = (UInt32)(Data[i+4] | (Data[i+5] << 8) | (Data[i+6] << 16) | (Data[i+7] << 24));
+          crc = t[0x700 + (crc & 0xFF)] ^ t[0x600 + ((crc >> 8) & 0xFF)] ^
+                t[0x500 + ((crc >> 16) & 0xFF)] ^ t[0x400 + (crc >> 24)] ^
+                t[0x300 + (hi & 0xFF)] ^ t[0x200 + ((hi >> 8) & 0xFF)] ^
+                t[0x100 + ((hi >> 16) & 0xFF)] ^ t[hi >> 24];
         }
-        else
+        for (; i < end; i++)
         {
-          for (Int32 i = 0; i < len; i++)
-          {
-            crc = (crc >> NumBitsPerRegShift) ^ lut[(crc & Mask) ^ Data[offset+i]];
-            Debug.DebugMSG("Data = {0:X2},Index = {1},Interim Calculated CRC = 0x{2:X8}",Data[offset+i],(crc & Mask) ^ Data[offset+i],crc);
-          }
+          crc = (crc >> 8) ^ t[(crc ^ Data[i]) & 0xFF];
         }
       }
       else
       {
-        if (NumBytesPerRegShift == 2)
+        for (; (end - i) >= 8; i += 8)
         {
-          for (Int32 i = 0; i < (len / NumBytesPerRegShift); i++)
-          {
-            crc = (crc << NumBitsPerRegShift) ^ lut[((crc >> (32 - NumBitsPerRegShift)) & Mask) ^ ((Data[2 * i + offset] << 8) | Data[2 * i + 1 + offset])];
-          }
+          crc ^= (UInt32)((Data[i] << 24) | (Data[i+1] << 16) | (Data[i+2] << 8) | Data[i+3]);
+          crc = t[0x700 + (crc >> 24)] ^ t[0x600 + ((crc >> 16) & 0xFF)] ^
+                t[0x500 + ((crc >> 8) & 0xFF)] ^ t[0x400 + (crc & 0xFF)] ^
+                t[0x300 + Data[i+4]] ^ t[0x200 + Data[i+5]] ^
+                t[0x100 + Data[i+6]] ^ t[Data[i+7]];
         }
-        else
+        for (; i < end; i++)
         {
-          for (Int32 i = 0; i < len; i++)
-          {
-            crc = (crc << NumBitsPerRegShift) ^ lut[((crc >> (32 - NumBitsPerRegShift)) & Mask) ^ Data[offset+i]];
-            Debug.DebugMSG("Data = {0:X2},Index = {1},Interim Calculated CRC = 0x{2:X8}",Data[offset+i],(crc & Mask) ^ Data[offset+i],crc);
-          }
+          crc = (crc << 8) ^ t[(crc >> 24) ^ Data[i]];
         }
       }
       return crc;
     }
     
+    /// <summary>
+    /// Combine the CRCs of two consecutive blocks of data into the CRC of the
+    /// concatenated data, so that large buffers can be checksummed in pieces
+    /// (possibly in parallel).  Both input CRCs must be complete results of this
+    /// object's configuration, i.e. started from the initial value and finalized.
+    /// </summary>
+    /// <param name="crcA">CRC of the first block.</param>
+    /// <param name="crcB">CRC of the second block.</param>
+    /// <param name="lenB">Length of the second block in bytes.</param>
+    /// <returns>CRC of the first block followed by the second.</returns>
+    public UInt32 Combine(UInt32 crcA, UInt32 crcB, Int64 lenB)
+    {
+      // The register is linear in its starting value, so the CRC of A||B is the
+      // raw register after A advanced over lenB zero bytes, plus the register
+      // contribution of B alone.  Undo the final XOR on A and remove the initial
+      // value that crcB already accounts for.
+      if (NumBytesPerRegShift == 2)
+        lenB &= ~0x1;
+      return ShiftZeroBytes(crcA ^ finalReg ^ initReg, lenB) ^ crcB;
+    }
+    
     /// <summary>
     /// Calculate the CRC-32 checksum using simple, inefficient bit wise operations.
     /// </summary>
     /// <param name="Data">The input byte array.</param>
     /// <param name="offset">The offset into the Byte array.</param>
     /// <param name="count">The number of bytes to use for the CRC calculation.</param>
-    /// <returns>CRC32 value.</returns>
-    private UInt32 BitWiseCRC(Byte[] Data, int offset, int count)
+    /// <param name="crc">The register value to start from.</param>
+    /// <returns>The register value, before the final XOR.</returns>
+    private UInt32 BitWiseCRC(Byte[] Data, int offset, int count, UInt32 crc)
     {
-      UInt32 crc = initReg;
-      Int32 len = Data.Length;
       Int32 NumBitsPerRegShift = NumBytesPerRegShift * 8;
       UInt32 Mask = (UInt32)(Math.Pow(2.0, NumBitsPerRegShift) - 1);
 
       // Perform the algorithm on each byte
       if (NumBytesPerRegShift == 2)
       {
-        for (Int32 i = 0; i < (len / NumBytesPerRegShift); i++)
+        for (Int32 i = offset; i < (offset + count - 1); i += 2)
         {
-          crc = ((crc << NumBitsPerRegShift) + (UInt32)((Data[2 * i] << 8) | Data[2 * i + 1])) ^ lut[((crc >> (32 - NumBitsPerRegShift)) & Mask)];
+          crc = ((crc << NumBitsPerRegShift) + (UInt32)((Data[i] << 8) | Data[i + 1])) ^ lut[((crc >> (32 - NumBitsPerRegShift)) & Mask)];
         }
       }
       else
       {
-        for (Int32 i = 0; i < len; i++)
+        for (Int32 i = offset; i < (offset + count); i++)
         {
           crc = ((crc << NumBitsPerRegShift) + Data[i]) ^ lut[((crc >> (32 - NumBitsPerRegShift)) & Mask)];
         }
       }
-      // Exclusive OR the result with the specified value
-      currCRC = (crc ^ finalReg);
-      return currCRC;
+      // The caller applies the final XOR, as for the LUT method
+      return crc;
     }
     
     public void ResetCRC()
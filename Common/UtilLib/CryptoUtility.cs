@@ -257,10 +257,26 @@ namespace UtilLib.Crypto
     }
     #endregion
     
+    // The shared AesManaged is only configured under its lock; the transforms
+    // it hands out are independent, so callers may run on several threads.
+    private static ICryptoTransform CreateTransform( byte[] key, byte[] iv, PaddingMode padding, bool encrypt )
+    {
+      lock (aes)
+      {
+        aes.Padding = padding;
+        aes.Key = key;
+        aes.IV = iv;
+        return (encrypt ? aes.CreateEncryptor() : aes.CreateDecryptor());
+      }
+    }
+    
+    
     public static byte[] AesCBCEncrypt( byte[] input, byte[] key, byte[] iv )
     {
       byte[] output;
       int blockCnt;
+      PaddingMode padding;
+      ICryptoTransform encryptor;
       
       // Get block count (rounded up so all data is covered)
       blockCnt = (input.Length + (blockSizeInBytes - 1)) / blockSizeInBytes;
@@ -268,23 +284,22 @@ namespace UtilLib.Crypto
       // Validate input
       if ((blockCnt * blockSizeInBytes) != input.Length)
       {
-        aes.Padding = PaddingMode.PKCS7;
+        padding = PaddingMode.PKCS7;
         output = new byte[blockCnt * blockSizeInBytes];
       }
       else
       {
-        aes.Padding = PaddingMode.None;
+        padding = PaddingMode.None;
         output = new byte[input.Length];
       }
       
-      aes.Key = key;
-      aes.IV = iv;
+      encryptor = CreateTransform(key, iv, padding, true);
       
       // Use CBC encryption to do CTS, with last two blocks swapped 
      
       // Do complete CBC encryption
       MemoryStream ms = new MemoryStream(output);
-      CryptoStream cs = new CryptoStream(ms, aes.CreateEncryptor(), CryptoStreamMode.Write);
+      CryptoStream cs = new CryptoStream(ms, encryptor, CryptoStreamMode.Write);
       try
       {
         cs.Write(input,0,input.Length);  
@@ -304,22 +319,22 @@ namespace UtilLib.Crypto
       byte[] output;
       byte[] tempIn,tempOut,tempSwap;
       int blockCnt;
+      PaddingMode padding;
+      ICryptoTransform encryptor;
                 
       // Validate input
       if (input.Length <= blockSizeInBytes)
       {
-        aes.Padding = PaddingMode.PKCS7;
+        padding = PaddingMode.PKCS7;
         output = new byte[blockSizeInBytes];
       }
       else
       {
-        aes.Padding = PaddingMode.None;
+        padding = PaddingMode.None;
         output = new byte[input.Length];
       }
       
-      
-      aes.Key = key;
-      aes.IV = iv;
+      encryptor = CreateTransform(key, iv, padding, true);
       
       // Get block count (rounded up so all data is covered)
       blockCnt = (input.Length + (blockSizeInBytes - 1)) / blockSizeInBytes;
@@ -328,7 +343,7 @@ namespace UtilLib.Crypto
       {
         // Do single block CBC encryption with PKCS7 padding
         MemoryStream ms = new MemoryStream(output);
-        CryptoStream cs = new CryptoStream(ms, aes.CreateEncryptor(), CryptoStreamMode.Write);
+        CryptoStream cs = new CryptoStream(ms, encryptor, CryptoStreamMode.Write);
         try
         {
           // Write Partial block
@@ -354,7 +369,7 @@ namespace UtilLib.Crypto
         
         // Do complete CBC encryption
         MemoryStream ms = new MemoryStream(tempOut);
-        CryptoStream cs = new CryptoStream(ms, aes.CreateEncryptor(), CryptoStreamMode.Write);
+        CryptoStream cs = new CryptoStream(ms, encryptor, CryptoStreamMode.Write);
         try
         {
           cs.Write(tempIn,0,tempIn.Length);  
@@ -389,13 +404,13 @@ namespace UtilLib.Crypto
       AesManaged ecbAes = new AesManaged();
       MemoryStream ms;
       CryptoStream cs;
+      ICryptoTransform decryptor;
       
       // Validate input
       if (input.Length <= blockSizeInBytes)
         throw new ArgumentException("Array size too small for Ciphertext Stealing","input");
      
-      aes.Key = key;
-      aes.IV = iv;
+      decryptor = CreateTransform(key, iv, PaddingMode.None, false);
       
       if ( (input.Length % blockSizeInBytes) != 0)
         blockCnt = ((input.Length / blockSizeInBytes) + 1 );
@@ -440,7 +455,7 @@ namespace UtilLib.Crypto
           
       // Do complete CBC encryption
       ms = new MemoryStream(tempIn, false);
-      cs = new CryptoStream(ms, aes.CreateDecryptor(), CryptoStreamMode.Read);
+      cs = new CryptoStream(ms, decryptor, CryptoStreamMode.Read);
       try
       {
         cs.Read(tempOut,0,tempOut.Length);  
@@ -462,6 +477,90 @@ namespace UtilLib.Crypto
       return output;
     }
   }
+  
+  /// <summary>
+  /// Write-only stream that hashes data as it is written, so the hash of
+  /// everything since the last reset is ready without keeping a copy of it.
+  /// </summary>
+  public class HashStream : Stream
+  {
+    private HashAlgorithm hashAlgorithm;
+    private Int64 length;
+    
+    public HashStream() : base()
+    {
+    }
+    
+    /// <summary>
+    /// Algorithm used for the hash.  Must be set before anything is written.
+    /// </summary>
+    public HashAlgorithm HashAlgorithm
+    {
+      get { return hashAlgorithm; }
+      set
+      {
+        hashAlgorithm = value;
+        hashAlgorithm.Initialize();
+        length = 0;
+      }
+    }
+    
+    /// <summary>
+    /// Finish the hash of the data written since the last reset.  The result
+    /// also stays in HashAlgorithm.Hash until the next SetLength(0).
+    /// </summary>
+    public Byte[] FinishHash()
+    {
+      hashAlgorithm.TransformFinalBlock(new Byte[0], 0, 0);
+      return hashAlgorithm.Hash;
+    }
+    
+    public override void Write(Byte[] buffer, Int32 offset, Int32 count)
+    {
+      if (hashAlgorithm == null)
+        throw new InvalidOperationException("No hash algorithm selected.");
+      hashAlgorithm.TransformBlock(buffer, offset, count, null, 0);
+      length += count;
+    }
+    
+    /// <summary>
+    /// SetLength(0) starts a new hash; no other length is supported.
+    /// </summary>
+    public override void SetLength(Int64 value)
+    {
+      if (value != 0)
+        throw new NotSupportedException();
+      if (hashAlgorithm != null)
+        hashAlgorithm.Initialize();
+      length = 0;
+    }
+    
+    public override Boolean CanRead   { get { return false; } }
+    public override Boolean CanSeek   { get { return false; } }
+    public override Boolean CanWrite  { get { return true; } }
+    public override Int64 Length      { get { return length; } }
+    
+    public override Int64 Position
+    {
+      get { return length; }
+      set { throw new NotSupportedException(); }
+    }
+    
+    public override void Flush()
+    {
+    }
+    
+    public override Int32 Read(Byte[] buffer, Int32 offset, Int32 count)
+    {
+      throw new NotSupportedException();
+    }
+    
+    public override Int64 Seek(Int64 offset, SeekOrigin origin)
+    {
+      throw new NotSupportedException();
+    }
+  }
+  
   /*
   public class CryptoStreamWithCTS : Stream
   {
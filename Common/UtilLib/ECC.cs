@@ -39,6 +39,12 @@ namespace UtilLib
       // Total number of message symbols
       private Int32 k;
       
+      // Number of row parity bits, log2(k)
+      private Int32 rowBits;
+      
+      // Parity of every byte value
+      private static readonly Byte[] byteParity = BuildByteParityTable();
+      
       
       // *************************************************
       // *            Private Constructors               *
@@ -49,6 +55,16 @@ namespace UtilLib
       // *               Private Methods                 *
       // *************************************************
 
+      private static Byte[] BuildByteParityTable()
+      {
+        Byte[] table = new Byte[256];
+        for (int i = 0; i < 256; i++)
+        {
+          table[i] = CalcBitWiseParity((Byte)i, colMasks.evenWhole);
+        }
+        return table;
+      }
+
       
       // *************************************************
       // *        Public properties and Indexer          *
@@ -63,6 +79,10 @@ namespace UtilLib
       public HammingECC(Int32 messageCnt)
       {
         k = messageCnt;
+        
+        rowBits = 0;
+        while ((1 << rowBits) < k)
+          rowBits++;
       }
       
       
@@ -113,6 +133,70 @@ namespace UtilLib
         return (Int32) ((oddResult << 16) | (evenResult));
       }
       
+      // Same result as GenerateParity(Byte[]) for a power of two message length,
+      // computed in one pass over k bytes starting at offset.  A byte with odd
+      // parity flips the odd row bits selected by its index and the even row
+      // bits selected by the complement of its index.
+      public Int32 GenerateParity(Byte[] messageData, Int32 offset)
+      {
+        Int32 col = 0, oddRow = 0, evenRow = 0, rowMask = k - 1;
+        Int32 oddResult, evenResult;
+        
+        if ((offset < 0) || ((offset + k) > messageData.Length))
+          throw new ArgumentException("Wrong size.","messageData");
+        
+        for (int i = 0; i < k; i++)
+        {
+          Byte val = messageData[offset + i];
+          col ^= val;
+          if (byteParity[val] != 0)
+          {
+            oddRow  ^= i;
+            evenRow ^= (~i & rowMask);
+          }
+        }
+        
+        evenResult = (byteParity[col & (Byte)colMasks.evenHalf] << 2) |
+                     (byteParity[col & (Byte)colMasks.evenFourth] << 1) |
+                     (byteParity[col & (Byte)colMasks.evenEighth] << 0) |
+                     (evenRow << 3);
+        oddResult  = (byteParity[col & (Byte)colMasks.oddHalf] << 2) |
+                     (byteParity[col & (Byte)colMasks.oddFourth] << 1) |
+                     (byteParity[col & (Byte)colMasks.oddEighth] << 0) |
+                     (oddRow << 3);
+        
+        return ((oddResult << 16) | evenResult);
+      }
+      
+      // Check k message bytes at offset against the stored parity and fix a
+      // single bit error in place.  Returns the number of bit errors found
+      // (0 or 1, where 1 may be a flipped bit of the stored parity itself) or
+      // -1 if the data has more errors than the code can correct.
+      public Int32 CorrectErrors(Byte[] messageData, Int32 offset, Int32 storedParity)
+      {
+        Int32 halfMask = (1 << (3 + rowBits)) - 1;
+        Int32 diff = (GenerateParity(messageData, offset) ^ storedParity) & ((halfMask << 16) | halfMask);
+        Int32 oddDiff = (diff >> 16) & halfMask;
+        Int32 evenDiff = diff & halfMask;
+        
+        if (diff == 0)
+          return 0;
+        
+        // A data bit error flips exactly one of each odd/even bit pair, and the
+        // odd bits then spell out its byte and bit address
+        if ((oddDiff ^ evenDiff) == halfMask)
+        {
+          messageData[offset + (oddDiff >> 3)] ^= (Byte)(0x1 << (oddDiff & 0x7));
+          return 1;
+        }
+        
+        // A single flipped bit in the stored parity leaves the data intact
+        if ((diff & (diff - 1)) == 0)
+          return 1;
+        
+        return -1;
+      }
+      
       
       // *************************************************
       // *             Public Class Methods              *
@@ -174,7 +258,20 @@ namespace UtilLib
       // The BinaryGaloisField under which all operations take place
       private BinaryGaloisField galoisField;
       
+      // Antilog table, alpha^i for i in [0, 2*(fieldLength-1)) so that a sum
+      // of two logs never needs reducing
+      private Int32[] expTable;
+      
+      // Log table, i such that alpha^i = x (entry 0 unused)
+      private Int32[] logTable;
+      
+      // Logs of the generator polynomial coefficients (-1 for a zero coefficient)
+      private Int32[] generatorLog;
       
+      // Number of non-zero field elements, fieldLength-1
+      private Int32 fieldOrder;
+      
+            
       // *************************************************
       // *            Private Constructors               *
       // *************************************************
@@ -184,11 +281,95 @@ namespace UtilLib
       // *               Private Methods                 *
       // *************************************************
 
+      // Build the log/antilog tables for the field and the generator polynomial
+      private void BuildTables()
+      {
+        Int32 order = galoisField.Length - 1;
+        
+        fieldOrder = order;
+        expTable = new Int32[2*order];
+        for (int i = 0; i < expTable.Length; i++)
+        {
+          expTable[i] = galoisField.AlphaFromIndex(i).Value;
+        }
+        
+        logTable = new Int32[galoisField.Length];
+        for (int i = 1; i < galoisField.Length; i++)
+        {
+          logTable[i] = galoisField.IndexFromAlpha(i) % order;
+        }
+        
+        generatorLog = new Int32[generatorPoly.Length];
+        for (int i = 0; i < generatorPoly.Length; i++)
+        {
+          generatorLog[i] = (generatorPoly[i] == 0) ? -1 : logTable[generatorPoly[i].Value];
+        }
+      }
+      
+      // Clock one message symbol into the parity shift register.  The register
+      // holds the running remainder of x^2s * m(x) mod g(x), lowest order first.
+      private void ShiftSymbol(Int32[] parity, Int32 symbol)
+      {
+        Int32 feedback = symbol ^ parity[2*s - 1];
+        
+        if (feedback == 0)
+        {
+          for (int j = (2*s - 1); j > 0; j--)
+          {
+            parity[j] = parity[j - 1];
+          }
+          parity[0] = 0;
+        }
+        else
+        {
+          Int32 fbLog = logTable[feedback];
+          for (int j = (2*s - 1); j > 0; j--)
+          {
+            parity[j] = (generatorLog[j] < 0) ? parity[j - 1] : (parity[j - 1] ^ expTable[fbLog + generatorLog[j]]);
+          }
+          parity[0] = (generatorLog[0] < 0) ? 0 : expTable[fbLog + generatorLog[0]];
+        }
+      }
+      
+      private Int32 Mul(Int32 x, Int32 y)
+      {
+        return ((x == 0) || (y == 0)) ? 0 : expTable[logTable[x] + logTable[y]];
+      }
+      
+      private Int32 Div(Int32 x, Int32 y)
+      {
+        return (x == 0) ? 0 : expTable[logTable[x] + fieldOrder - logTable[y]];
+      }
+      
+      // Evaluate poly at alpha^xLog, poly[i] being the coefficient of x^i
+      private Int32 Evaluate(Int32[] poly, Int32 degree, Int32 xLog)
+      {
+        Int32 result = 0, termLog = 0;
+        
+        for (int i = 0; i <= degree; i++)
+        {
+          if (poly[i] != 0)
+          {
+            result ^= expTable[logTable[poly[i]] + termLog];
+          }
+          termLog += xLog;
+          if (termLog >= fieldOrder)
+            termLog -= fieldOrder;
+        }
+        return result;
+      }
+
       
       // *************************************************
       // *        Public properties and Indexer          *
       // *************************************************
 
+      // Number of parity symbols produced per message
+      public Int32 ParityCount
+      {
+        get { return 2*s; }
+      }
+
 
       // *************************************************
       // *             Public constructors               *
@@ -205,6 +386,9 @@ namespace UtilLib
         
         // Create the generator polynomial, g(x)
         generatorPoly = ReedSolomonECC.createGeneratorPolynomial(galoisField, maxCorrectibleErrorCnt);
+        
+        // Precompute everything the encoder needs so encoding is table lookups only
+        BuildTables();
       }
       
 
@@ -212,45 +396,186 @@ namespace UtilLib
       // *           Public Instance Methods             *
       // *************************************************      
       
+      // Parity is defined parityPoly(x) = x^2s * messagePoly(x) (mod generatorPoly(x)),
+      // where messageData[i] is the coefficient of x^i.  Parity symbol i is the
+      // coefficient of x^i of the remainder.
       public Int32[] GenerateParity(Int32[] messageData)
       {
         Int32[] retArray = new Int32[2*s];
-        BinaryGaloisFieldElement[] data = new BinaryGaloisFieldElement[N];
       
         if (messageData.Length != k)
           throw new ArgumentException("Wrong size.","messageData");
 
-        // Parity is defined parityPoly(x) = x^2s * messagePoly(x) (mod generatorPoly(x))
-        // Convert input message data to array of BinaryGaloisFieldElement (implicit cast)
-        // Create x^2s * messagePoly(x) by shifting data up by 2s positions
-        for (int i=0; i<k; i++)
+        // Feed the message highest order coefficient first
+        for (int i = k - 1; i >= 0; i--)
+        {
+          ShiftSymbol(retArray, messageData[i]);
+        }
+        
+        // Return parity symbols
+        return retArray;
+      }
+      
+      // Same as GenerateParity, but taking k message bytes straight from a buffer
+      // with the highest order coefficient first (the order the NAND controller
+      // sees the data), and writing into a caller supplied parity array.  Only
+      // reads shared state, so one instance can be used from several threads.
+      public void GenerateParity(Byte[] messageData, Int32 offset, Int32[] parity)
+      {
+        if ((offset < 0) || ((offset + k) > messageData.Length))
+          throw new ArgumentException("Wrong size.","messageData");
+        if (parity.Length != (2*s))
+          throw new ArgumentException("Wrong size.","parity");
+
+        Array.Clear(parity, 0, parity.Length);
+        for (int i = offset; i < (offset + k); i++)
+        {
+          ShiftSymbol(parity, messageData[i]);
+        }
+      }
+      
+      // Check a message laid out as for GenerateParity(Byte[],Int32,Int32[]) against
+      // its parity symbols and correct both in place.  Returns the number of
+      // corrected bits (0 when the codeword is clean) or -1 if there are more
+      // than s symbol errors.  Syndromes, then Berlekamp-Massey for the error
+      // locator, a Chien search over the N used positions and Forney for the
+      // error values.
+      public Int32 CorrectErrors(Byte[] messageData, Int32 offset, Int32[] parity)
+      {
+        Int32[] syndrome = new Int32[2*s];
+        Int32[] locator, prevLocator, temp, evaluator;
+        Int32[] errorPos = new Int32[s], errorVal = new Int32[s];
+        Int32 locatorDeg, shift, prevDiscrepancy, discrepancy, coef;
+        Int32 rootCnt, bitCnt, num, den, value, xLog;
+        Boolean clean = true;
+        
+        if ((offset < 0) || ((offset + k) > messageData.Length))
+          throw new ArgumentException("Wrong size.","messageData");
+        if (parity.Length != (2*s))
+          throw new ArgumentException("Wrong size.","parity");
+
+        // Syndrome j is the received polynomial evaluated at alpha^(j+1), using
+        // Horner's rule from the highest order symbol down
+        for (int j = 0; j < (2*s); j++)
+        {
+          Int32 acc = 0;
+          for (int i = offset; i < (offset + k); i++)
+          {
+            acc = ((acc == 0) ? 0 : expTable[logTable[acc] + j + 1]) ^ messageData[i];
+          }
+          for (int i = (2*s - 1); i >= 0; i--)
+          {
+            acc = ((acc == 0) ? 0 : expTable[logTable[acc] + j + 1]) ^ parity[i];
+          }
+          syndrome[j] = acc;
+          if (acc != 0)
+            clean = false;
+        }
+        if (clean)
+          return 0;
+        
+        // Berlekamp-Massey
+        locator = new Int32[2*s + 1];
+        prevLocator = new Int32[2*s + 1];
+        locator[0] = prevLocator[0] = 1;
+        locatorDeg = 0;
+        shift = 1;
+        prevDiscrepancy = 1;
+        for (int n = 0; n < (2*s); n++)
         {
-          data[i+(2*s)] = messageData[i];
+          discrepancy = syndrome[n];
+          for (int i = 1; i <= locatorDeg; i++)
+          {
+            discrepancy ^= Mul(locator[i], syndrome[n - i]);
+          }
+          
+          if (discrepancy == 0)
+          {
+            shift++;
+            continue;
+          }
+          
+          coef = Div(discrepancy, prevDiscrepancy);
+          temp = (Int32[]) locator.Clone();
+          for (int i = shift; i <= (2*s); i++)
+          {
+            locator[i] ^= Mul(coef, prevLocator[i - shift]);
+          }
+          
+          if ((2*locatorDeg) <= n)
+          {
+            locatorDeg = n + 1 - locatorDeg;
+            prevLocator = temp;
+            prevDiscrepancy = discrepancy;
+            shift = 1;
+          }
+          else
+          {
+            shift++;
+          }
         }
+        if (locatorDeg > s)
+          return -1;
         
-        // Now do long division using generatorPoly, remainder is parity data
-        // Use synthetic division since generatorPoly is monic
-        for(int i = N - 1; i >=(2*s); i--)
+        // Error evaluator, syndrome(x) * locator(x) mod x^2s
+        evaluator = new Int32[2*s];
+        for (int i = 0; i < (2*s); i++)
         {
-          if (data[i] != 0)
+          for (int j = 0; j <= i; j++)
           {
-            for (int j = 1; j <= (2*s); j++)
-            {
-              data[i - j] = data[i - j] - galoisField.Multiply(data[i],generatorPoly[2*s - j]);
-            }
-            // Set to zero
-            data[i] = 0;
+            evaluator[i] ^= Mul(syndrome[j], locator[i - j]);
           }
         }
         
-        // Copy 2*s pieces of data to the parity symbols array
-        for (int i=0; i<(2*s); i++)
+        // Chien search: position p is in error when locator(alpha^-p) == 0
+        rootCnt = 0;
+        bitCnt = 0;
+        for (int p = 0; p < N; p++)
         {
-          retArray[i] = (Int32) data[i];
+          xLog = (fieldOrder - (p % fieldOrder)) % fieldOrder;
+          if (Evaluate(locator, locatorDeg, xLog) != 0)
+            continue;
+          if (rootCnt == locatorDeg)
+            return -1;
+          
+          // Forney (first consecutive root is alpha^1), derivative keeps odd terms only
+          num = Evaluate(evaluator, 2*s - 1, xLog);
+          den = 0;
+          for (int i = 1; i <= locatorDeg; i += 2)
+          {
+            if (locator[i] != 0)
+              den ^= expTable[logTable[locator[i]] + (Int32)(((Int64)xLog * (i - 1)) % fieldOrder)];
+          }
+          if (den == 0)
+            return -1;
+          value = Div(num, den);
+          
+          // Message symbols are bytes, so a wider error can't be real
+          if ((p >= (2*s)) && (value > 0xFF))
+            return -1;
+          
+          errorPos[rootCnt] = p;
+          errorVal[rootCnt] = value;
+          rootCnt++;
         }
         
-        // Return parity symbols
-        return retArray;
+        // Fewer roots than the locator degree means errors outside the codeword
+        if (rootCnt != locatorDeg)
+          return -1;
+        
+        // Only touch the caller's data once the whole pattern is known good
+        for (int i = 0; i < rootCnt; i++)
+        {
+          if (errorPos[i] < (2*s))
+            parity[errorPos[i]] ^= errorVal[i];
+          else
+            messageData[offset + (N - 1 - errorPos[i])] ^= (Byte) errorVal[i];
+          
+          for (value = errorVal[i]; value != 0; value &= (value - 1))
+            bitCnt++;
+        }
+        
+        return bitCnt;
       }
       
       
@@ -9,6 +9,7 @@ using System.Reflection;
 using System.Threading;
 using System.Globalization;
 using System.Collections;
+using System.Collections.Generic;
 using UtilLib;
 
 namespace UtilLib.IO
@@ -398,6 +399,12 @@ namespace UtilLib.IO
     private Hashtable headerRef;
     private Hashtable[] sectionRef;       
     private Hashtable[] symRef;
+    private Dictionary<String,UInt32> sectionIndex;
+    private Dictionary<String,UInt32> symbolIndex;
+    private String[] sectionNames;
+    
+    // Words read from the file per transfer when a whole section is read
+    private const UInt32 SecReadBlockWords = 16384;
     #endregion
     
     
@@ -471,8 +478,10 @@ namespace UtilLib.IO
       FileInfo fi = new FileInfo(filename);
       try
       {
+        // Section data is read on demand, a window at a time, so the
+        // file is opened for random access rather than read up front
         if (fi.Exists)
-          binFile = new FileStream(filename, FileMode.Open, FileAccess.Read);
+          binFile = new FileStream(filename, FileMode.Open, FileAccess.Read, FileShare.Read, 4096, FileOptions.RandomAccess);
       }
       catch (Exception e)
       {
@@ -514,6 +523,42 @@ namespace UtilLib.IO
       }
     }
 
+    /// <summary>
+    /// Print the named symbols sorted by address, with the section each
+    /// one belongs to
+    /// </summary>
+    public void dumpSymbolMap()
+    {
+      List<Hashtable> named = new List<Hashtable>(symbolIndex.Count);
+      foreach (UInt32 symNum in symbolIndex.Values)
+        named.Add(symRef[symNum]);
+      named.Sort(delegate(Hashtable a, Hashtable b)
+      {
+        return ((UInt64)a["value"]).CompareTo((UInt64)b["value"]);
+      });
+
+      Console.WriteLine("Symbol map of {0}:", (String)headerRef["fullName"]);
+      Console.WriteLine("\tAddress   \tSection         \tName");
+      Console.WriteLine("\t==========\t================\t========");
+      foreach (Hashtable sym in named)
+      {
+        UInt16 secNum = (UInt16)sym["secNum"];
+        String secName;
+        
+        if (secNum == (UInt16) ELF_SectionIndex.SHN_UNDEF)
+          secName = "(undef)";
+        else if (secNum == (UInt16) ELF_SectionIndex.SHN_ABS)
+          secName = "(abs)";
+        else if (secNum == (UInt16) ELF_SectionIndex.SHN_COMMON)
+          secName = "(common)";
+        else if (secNum < sectionNames.Length)
+          secName = sectionNames[secNum];
+        else
+          secName = "(reserved)";
+        Console.WriteLine("\t0x{0:X8}\t{1,-16}\t{2}", (UInt64)sym["value"], secName, (String)sym["name"]);
+      }
+    }
+
     public void dumpFileHeader()
     {
       foreach (DictionaryEntry de in headerRef)
@@ -573,15 +618,23 @@ namespace UtilLib.IO
     public Hashtable secFind(String secName)
     {
         //Debug.DebugMSG("secFind("+secName+")");
-        UInt32 numSections = ((UInt32)headerRef["numSectionHdrs"]);
-        for (UInt32 i = 0; i < numSections; i++)
+        UInt32 secNum;
+        if (sectionIndex.TryGetValue(secName, out secNum))
         {
-            
-            if ( ((String)sectionRef[i]["name"]).Equals(secName))
+            // Callers may reorder the array returned by Sections, so fall
+            // back to a scan if the indexed slot no longer holds the section
+            if ( !((String)sectionRef[secNum]["name"]).Equals(secName) )
             {
-                currSecNum = i;
-                return sectionRef[currSecNum];
+                UInt32 numSections = ((UInt32)headerRef["numSectionHdrs"]);
+                for (secNum = 0; secNum < numSections; secNum++)
+                {
+                    if ( ((String)sectionRef[secNum]["name"]).Equals(secName))
+                        break;
+                }
+                sectionIndex[secName] = secNum;
             }
+            currSecNum = secNum;
+            return sectionRef[currSecNum];
         }
         return null;
     }
@@ -602,34 +655,47 @@ namespace UtilLib.IO
     public UInt32[] secRead()
     {
         Hashtable section = sectionRef[currSecNum];
-        UInt32 flags = (UInt32)headerRef["flags"];
         UInt32 ws = (UInt32) section["wordSize"];
-        UInt32 dp = (UInt32) section["dataPtr"];
         UInt32[] dataArr = new UInt32[ws];
-        EndianBinaryReader ebr;
+        Byte[] block = new Byte[Math.Min(ws, SecReadBlockWords) << 2];
+        UInt32 n;
         
-        binFile.Seek(dp,SeekOrigin.Begin);
-        
-        if ( (flags & 0x0200) != 0)
+        // The ELF data encoding gives the byte order of the section data
+        for (UInt32 i = 0; i < ws; i += n)
         {
-            // Big Endian DSP
-            ebr = new EndianBinaryReader(binFile,Endian.BigEndian);
-        }
-        else
-        {
-            // Little Endian DSP
-            ebr = new EndianBinaryReader(binFile,Endian.LittleEndian);
-        }
-        //Debug.DebugMSG("secRead(): " + ebr.endianness.ToString());
-                        
-        for ( int i = 0; i<ws; i++)
-        {
-            dataArr[i] = ebr.ReadUInt32();
+            n = Math.Min(ws - i, SecReadBlockWords);
+            secRead(section, i << 2, block, 0, (Int32)(n << 2));
+            endian.GetWords(block, 0, dataArr, (Int32)i, (Int32)n);
         }
 
         return dataArr;
     }
 
+    /// <summary>
+    /// Read part of a section's raw data, in the file's byte order, straight
+    /// into the caller's buffer.  Only the requested window is read, so
+    /// loaders can stream large sections without holding them in memory.
+    /// </summary>
+    /// <param name="section">Section header Hashtable (from Sections or secFind)</param>
+    /// <param name="byteOffset">Offset of the window from the start of the section</param>
+    /// <param name="buffer">Output byte array</param>
+    /// <param name="offset">Offset in the output array of the first byte</param>
+    /// <param name="count">Number of bytes to read</param>
+    public void secRead(Hashtable section, UInt32 byteOffset, Byte[] buffer, Int32 offset, Int32 count)
+    {
+        Int32 n;
+        
+        binFile.Seek((Int64)((UInt64)section["dataPtr"] + byteOffset), SeekOrigin.Begin);
+        while (count > 0)
+        {
+            n = binFile.Read(buffer, offset, count);
+            if (n <= 0)
+                throw new EndOfStreamException("Section " + (String)section["name"] + " runs past the end of the file.");
+            offset += n;
+            count -= n;
+        }
+    }
+
     public UInt32[] secRead(UInt32 secNum)
     {
         secSeek(secNum);
@@ -667,14 +733,11 @@ namespace UtilLib.IO
     public Hashtable symFind( String symName)
     {
         //Debug.DebugMSG("symFind("+symName+")");
-        UInt32 numSymbols = (UInt32)headerRef["numEntriesInSymTable"];
-        for(UInt16 i = 0; i < numSymbols; i++)
+        UInt32 symNum;
+        if (symbolIndex.TryGetValue(symName, out symNum))
         {
-            if ( ((String)symRef[i]["name"]).Equals(symName))
-            {
-                currSymNum = i;
-                return symRef[currSymNum];
-            }
+            currSymNum = symNum;
+            return symRef[currSymNum];
         }
         return null;
     }
@@ -848,8 +911,17 @@ namespace UtilLib.IO
         throw new Exception("Section Header String Section is not of type SHT_STRTAB.");
       }
       
+      // Read the program headers once, rather than once per loadable section
+      ELF_SegmentHeader[] segmentHdrs = new ELF_SegmentHeader[hdr.e_phnum];
+      for (UInt32 segmentNum = 0; segmentNum < (UInt32)hdr.e_phnum; segmentNum++)
+      {
+        segmentHdrs[segmentNum] = ReadSegmentHeader(segmentNum);
+      }
+      
       // Cycle through all sections, collecting info about each (name, type, etc.)
       sectionRef = new Hashtable[numSections];
+      sectionIndex = new Dictionary<String,UInt32>((Int32)numSections);
+      sectionNames = new String[numSections];
       for (UInt32 secNum = 0; secNum < numSections; secNum++)
       {
         secHdr = ReadSectionHeader((UInt32) secNum);
@@ -859,7 +931,14 @@ namespace UtilLib.IO
 
         ebr.BaseStream.Seek((Int64)(secHdr.sh_name + (UInt64)headerRef["stringTableAddr"]), SeekOrigin.Begin);
         sectionRef[secNum]["name"]    = ELF_getStringFromStringTable();
+        sectionNames[secNum] = (String)sectionRef[secNum]["name"];
+        
+        // Index by name for secFind; the first section of a name wins
+        if (!sectionIndex.ContainsKey((String)sectionRef[secNum]["name"]))
+          sectionIndex.Add((String)sectionRef[secNum]["name"], secNum);
+        
         sectionRef[secNum]["type"]    = (ELF_SectionType) secHdr.sh_type;
+        sectionRef[secNum]["dataPtr"] = (UInt64) secHdr.sh_offset;
         sectionRef[secNum]["phyAddr"] = (UInt64) secHdr.sh_addr;
         sectionRef[secNum]["virAddr"]   = (UInt64) secHdr.sh_addr;
 
@@ -898,7 +977,7 @@ namespace UtilLib.IO
         {
           for (UInt32 segmentNum = 0; segmentNum < (UInt32)hdr.e_phnum; segmentNum++)
           {
-            ELF_SegmentHeader segmentHdr = ReadSegmentHeader((UInt32) segmentNum);
+            ELF_SegmentHeader segmentHdr = segmentHdrs[segmentNum];
             
             // If the segment is of load type, check to see if the current section resides in it
             if (segmentHdr.p_type == ELF_SegmentType.PT_LOAD)
@@ -1075,6 +1154,7 @@ namespace UtilLib.IO
       Byte info, other;
       
       symRef = new Hashtable[numSymbols];
+      symbolIndex = new Dictionary<String,UInt32>((Int32)numSymbols);
 
       // Read the symbol table
       for (UInt32 symNum = 0; symNum < numSymbols; symNum++)
@@ -1136,6 +1216,11 @@ namespace UtilLib.IO
 
         symRef[symNum]["visibility"] = sym.st_visibility;
         Debug.DebugMSG("symRef[" + symNum.ToString() + "][\"visibility\"]: " + sym.st_visibility);
+        
+        // Index by name for symFind; the first symbol of a name wins
+        String name = (String)symRef[symNum]["name"];
+        if ((name.Length != 0) && !symbolIndex.ContainsKey(name))
+          symbolIndex.Add(name, symNum);
 
       }      
       Debug.DebugMSG("Parse Symbol Table Done");
@@ -81,6 +81,140 @@ namespace UtilLib.IO
             return bytes;
         }
 
+        /// <summary>
+        /// Public static function to reverse the endianness of every word in a
+        /// region of a byte array, in place
+        /// </summary>
+        /// <param name="bytes">Input byte array</param>
+        /// <param name="offset">Offset of the first word</param>
+        /// <param name="count">Number of bytes to convert (multiple of wordSize)</param>
+        /// <param name="wordSize">Size of each word in bytes (2, 4 or 8)</param>
+        public static void swapEndian(byte[] bytes, Int32 offset, Int32 count, Int32 wordSize)
+        {
+            Int32 end = offset + count - (count % wordSize);
+            Byte temp;
+            for (int i = offset; i < end; i += wordSize)
+            {
+                for (int j = 0, k = wordSize - 1; j < k; j++, k--)
+                {
+                    temp = bytes[i + k];
+                    bytes[i + k] = bytes[i + j];
+                    bytes[i + j] = temp;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Public static functions to reverse the byte order of an integer
+        /// without going through a temporary byte array
+        /// </summary>
+        /// <param name="value">Input value</param>
+        /// <returns>Value with its bytes reversed</returns>
+        public static UInt16 swapEndian(UInt16 value)
+        {
+            return (UInt16)((value >> 8) | (value << 8));
+        }
+
+        public static UInt32 swapEndian(UInt32 value)
+        {
+            return ((value >> 24) | ((value >> 8) & 0x0000FF00) |
+                    ((value << 8) & 0x00FF0000) | (value << 24));
+        }
+
+        public static UInt64 swapEndian(UInt64 value)
+        {
+            return (((UInt64)swapEndian((UInt32)value)) << 32) | swapEndian((UInt32)(value >> 32));
+        }
+
+        /// <summary>
+        /// Convert an array of 32-bit words to bytes in this object's byte order
+        /// </summary>
+        /// <param name="words">Input word array</param>
+        /// <param name="index">Index of the first word to convert</param>
+        /// <param name="count">Number of words to convert</param>
+        /// <param name="bytes">Output byte array</param>
+        /// <param name="offset">Offset in the output array of the first byte</param>
+        public void GetBytes(UInt32[] words, Int32 index, Int32 count, byte[] bytes, Int32 offset)
+        {
+            UInt32 word;
+            Int32 end = index + count;
+            if (endianness == Big)
+            {
+                for (int i = index; i < end; i++, offset += 4)
+                {
+                    word = words[i];
+                    bytes[offset]     = (Byte)(word >> 24);
+                    bytes[offset + 1] = (Byte)(word >> 16);
+                    bytes[offset + 2] = (Byte)(word >> 8);
+                    bytes[offset + 3] = (Byte)word;
+                }
+            }
+            else
+            {
+                for (int i = index; i < end; i++, offset += 4)
+                {
+                    word = words[i];
+                    bytes[offset]     = (Byte)word;
+                    bytes[offset + 1] = (Byte)(word >> 8);
+                    bytes[offset + 2] = (Byte)(word >> 16);
+                    bytes[offset + 3] = (Byte)(word >> 24);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Convert a 32-bit word to bytes in this object's byte order
+        /// </summary>
+        /// <param name="word">Input word</param>
+        /// <param name="bytes">Output byte array</param>
+        /// <param name="offset">Offset in the output array of the first byte</param>
+        public void GetBytes(UInt32 word, byte[] bytes, Int32 offset)
+        {
+            if (endianness == Big)
+            {
+                bytes[offset]     = (Byte)(word >> 24);
+                bytes[offset + 1] = (Byte)(word >> 16);
+                bytes[offset + 2] = (Byte)(word >> 8);
+                bytes[offset + 3] = (Byte)word;
+            }
+            else
+            {
+                bytes[offset]     = (Byte)word;
+                bytes[offset + 1] = (Byte)(word >> 8);
+                bytes[offset + 2] = (Byte)(word >> 16);
+                bytes[offset + 3] = (Byte)(word >> 24);
+            }
+        }
+
+        /// <summary>
+        /// Convert bytes in this object's byte order to an array of 32-bit words
+        /// </summary>
+        /// <param name="bytes">Input byte array</param>
+        /// <param name="offset">Offset in the input array of the first byte</param>
+        /// <param name="words">Output word array</param>
+        /// <param name="index">Index of the first word to fill</param>
+        /// <param name="count">Number of words to convert</param>
+        public void GetWords(byte[] bytes, Int32 offset, UInt32[] words, Int32 index, Int32 count)
+        {
+            Int32 end = index + count;
+            if (endianness == Big)
+            {
+                for (int i = index; i < end; i++, offset += 4)
+                {
+                    words[i] = ((UInt32)bytes[offset] << 24) | ((UInt32)bytes[offset + 1] << 16) |
+                               ((UInt32)bytes[offset + 2] << 8) | (UInt32)bytes[offset + 3];
+                }
+            }
+            else
+            {
+                for (int i = index; i < end; i++, offset += 4)
+                {
+                    words[i] = (UInt32)bytes[offset] | ((UInt32)bytes[offset + 1] << 8) |
+                               ((UInt32)bytes[offset + 2] << 16) | ((UInt32)bytes[offset + 3] << 24);
+                }
+            }
+        }
+
         /// <summary>
         /// Check if this object is LittleEndian
         /// </summary>
@@ -189,7 +323,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                return BitConverter.ToInt16(Endian.swapEndian(BitConverter.GetBytes(base.ReadInt16())), 0);
+                return (short)Endian.swapEndian((UInt16)base.ReadInt16());
             }
             else
             {
@@ -201,7 +335,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                return BitConverter.ToInt32(Endian.swapEndian(BitConverter.GetBytes(base.ReadInt32())), 0);
+                return (int)Endian.swapEndian((UInt32)base.ReadInt32());
             }
             else
             {
@@ -213,7 +347,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                return BitConverter.ToInt64(Endian.swapEndian(BitConverter.GetBytes(base.ReadInt64())), 0);
+                return (long)Endian.swapEndian((UInt64)base.ReadInt64());
             }
             else
             {
@@ -225,7 +359,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                return BitConverter.ToUInt16(Endian.swapEndian(BitConverter.GetBytes(base.ReadUInt16())), 0);
+                return Endian.swapEndian(base.ReadUInt16());
             }
             else
             {
@@ -237,7 +371,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                return BitConverter.ToUInt32(Endian.swapEndian(BitConverter.GetBytes(base.ReadUInt32())), 0);
+                return Endian.swapEndian(base.ReadUInt32());
             }
             else
             {
@@ -249,7 +383,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                return BitConverter.ToUInt64(Endian.swapEndian(BitConverter.GetBytes(base.ReadUInt64())), 0);
+                return Endian.swapEndian(base.ReadUInt64());
             }
             else
             {
@@ -264,6 +398,10 @@ namespace UtilLib.IO
     public class EndianBinaryWriter : BinaryWriter
     {
         private Endian myEndian;
+        private Byte[] wordBuffer;
+
+        // Words converted per stream write in the bulk Write()
+        private const Int32 WordBufferCnt = 16384;
 
         public Endian endianness
         {
@@ -297,7 +435,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                base.Write(BitConverter.ToInt16(Endian.swapEndian(BitConverter.GetBytes(value)), 0));
+                base.Write((short)Endian.swapEndian((UInt16)value));
             }
             else
             {
@@ -309,7 +447,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                base.Write(BitConverter.ToInt32(Endian.swapEndian(BitConverter.GetBytes(value)), 0));
+                base.Write((int)Endian.swapEndian((UInt32)value));
             }
             else
             {
@@ -321,7 +459,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                base.Write(BitConverter.ToInt64(Endian.swapEndian(BitConverter.GetBytes(value)), 0));
+                base.Write((long)Endian.swapEndian((UInt64)value));
             }
             else
             {
@@ -333,7 +471,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                base.Write(BitConverter.ToUInt16(Endian.swapEndian(BitConverter.GetBytes(value)), 0));
+                base.Write(Endian.swapEndian(value));
             }
             else
             {
@@ -345,7 +483,7 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                base.Write(BitConverter.ToUInt32(Endian.swapEndian(BitConverter.GetBytes(value)), 0));
+                base.Write(Endian.swapEndian(value));
             }
             else
             {
@@ -357,12 +495,36 @@ namespace UtilLib.IO
         {
             if (myEndian.isBigEndian())
             {
-                base.Write(BitConverter.ToUInt64(Endian.swapEndian(BitConverter.GetBytes(value)), 0));
+                base.Write(Endian.swapEndian(value));
             }
             else
             {
                 base.Write(value);
             }
         }
+
+        /// <summary>
+        /// Write a run of 32-bit words, converting them in blocks through a
+        /// buffer that is reused for the life of the writer
+        /// </summary>
+        /// <param name="values">Input word array</param>
+        /// <param name="index">Index of the first word to write</param>
+        /// <param name="count">Number of words to write</param>
+        public void Write(uint[] values, Int32 index, Int32 count)
+        {
+            Int32 blockCnt;
+
+            if (wordBuffer == null)
+                wordBuffer = new Byte[WordBufferCnt * 4];
+
+            while (count > 0)
+            {
+                blockCnt = (count > WordBufferCnt) ? WordBufferCnt : count;
+                myEndian.GetBytes(values, index, blockCnt, wordBuffer, 0);
+                base.Write(wordBuffer, 0, blockCnt * 4);
+                index += blockCnt;
+                count -= blockCnt;
+            }
+        }
     }
 }
\ No newline at end of file
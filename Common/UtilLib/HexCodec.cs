@@ -0,0 +1,464 @@
+/****************************************************************
+ *  TI UtilLib.HexConv namespace: hex text and S-record codec   *
+ *  (C) 2010, Texas Instruments, Inc.                           *
+ *                                                              *
+ *  Table-driven conversion straight between byte arrays, so    *
+ *  that no per-digit strings or format calls are needed.       *
+ ****************************************************************/
+
+using System;
+using System.IO;
+using System.Text;
+
+namespace UtilLib.HexConv
+{
+  /// <summary>
+  /// ASCII hex encoding and decoding through lookup tables
+  /// </summary>
+  public static class HexCodec
+  {
+    private static readonly Byte[] upperDigits = Encoding.ASCII.GetBytes("0123456789ABCDEF");
+    private static readonly Byte[] lowerDigits = Encoding.ASCII.GetBytes("0123456789abcdef");
+
+    // Value of each ASCII character as a hex digit, 0xFF if it is not one
+    private static readonly Byte[] digitValues = BuildDigitValues();
+
+    private static Byte[] BuildDigitValues()
+    {
+      Byte[] values = new Byte[256];
+
+      for (Int32 i = 0; i < values.Length; i++)
+        values[i] = 0xFF;
+      for (Int32 i = 0; i < 16; i++)
+      {
+        values[upperDigits[i]] = (Byte)i;
+        values[lowerDigits[i]] = (Byte)i;
+      }
+      return values;
+    }
+
+    /// <summary>
+    /// Write a byte as two hex digits
+    /// </summary>
+    /// <returns>Offset just past the digits written.</returns>
+    public static Int32 PutByte(Byte value, Byte[] dest, Int32 offset)
+    {
+      dest[offset]     = upperDigits[value >> 4];
+      dest[offset + 1] = upperDigits[value & 0xF];
+      return offset + 2;
+    }
+
+    /// <summary>
+    /// Write a word as eight hex digits, most significant first
+    /// </summary>
+    /// <returns>Offset just past the digits written.</returns>
+    public static Int32 PutWord(UInt32 value, Byte[] dest, Int32 offset, Boolean lowerCase)
+    {
+      Byte[] digits = lowerCase ? lowerDigits : upperDigits;
+
+      for (Int32 shift = 28; shift >= 0; shift -= 4)
+        dest[offset++] = digits[(value >> shift) & 0xF];
+      return offset;
+    }
+
+    /// <summary>
+    /// Encode data as a run of 32-bit little endian words, each written as
+    /// eight hex digits most significant first (the text the ROM serial boot
+    /// loaders expect).
+    /// </summary>
+    /// <param name="data">Data to encode; its length must be a multiple of 4.</param>
+    /// <param name="lowerCase">Use lower case digits.</param>
+    /// <returns>The ASCII hex text, two bytes per data byte.</returns>
+    public static Byte[] EncodeWords(Byte[] data, Boolean lowerCase)
+    {
+      Byte[] digits = lowerCase ? lowerDigits : upperDigits;
+      Byte[] text;
+      Int32 o = 0;
+
+      if ((data.Length & 3) != 0)
+        throw new ArgumentException("Data length must be a multiple of 4 bytes.", "data");
+
+      text = new Byte[data.Length * 2];
+      for (Int32 i = 0; i < data.Length; i += 4)
+      {
+        for (Int32 j = 3; j >= 0; j--)
+        {
+          text[o++] = digits[data[i + j] >> 4];
+          text[o++] = digits[data[i + j] & 0xF];
+        }
+      }
+      return text;
+    }
+
+    /// <summary>
+    /// Value of one hex digit
+    /// </summary>
+    /// <returns>The value, or -1 if c is not a hex digit.</returns>
+    public static Int32 GetDigit(Byte c)
+    {
+      Byte value = digitValues[c];
+      return (value == 0xFF) ? -1 : value;
+    }
+
+    /// <summary>
+    /// Value of the byte written as two hex digits at offset
+    /// </summary>
+    /// <returns>The value, or -1 if either character is not a hex digit.</returns>
+    public static Int32 GetByte(Byte[] src, Int32 offset)
+    {
+      Int32 hi = digitValues[src[offset]];
+      Int32 lo = digitValues[src[offset + 1]];
+
+      if ((hi | lo) == 0xFF)
+        return -1;
+      return (hi << 4) | lo;
+    }
+
+    /// <summary>
+    /// Decode count bytes written as hex digits
+    /// </summary>
+    /// <returns>False if a non-hex character was found.</returns>
+    public static Boolean GetBytes(Byte[] src, Int32 offset, Byte[] dest, Int32 destOffset, Int32 count)
+    {
+      for (Int32 i = 0; i < count; i++)
+      {
+        Int32 value = GetByte(src, offset + (i << 1));
+        if (value < 0)
+          return false;
+        dest[destOffset + i] = (Byte)value;
+      }
+      return true;
+    }
+  }
+
+  /// <summary>
+  /// Writes Motorola S-records to a stream, each record built in one
+  /// reusable line buffer.
+  /// </summary>
+  public class SRecordWriter
+  {
+    private Stream output;
+    private Byte[] line = new Byte[80];
+
+    public SRecordWriter(Stream outputStream)
+    {
+      output = outputStream;
+    }
+
+    /// <summary>
+    /// Convert a whole binary stream to S-records: an S0 header naming the
+    /// file, S3 data records and an S7 record with startAddr as the entry point.
+    /// </summary>
+    /// <param name="inputStream">The binary data, read from its start.</param>
+    /// <param name="startAddr">Address of the first byte of data.</param>
+    /// <param name="recordSize">Data bytes per S3 record.</param>
+    /// <returns>The S-record text.</returns>
+    public static Byte[] Encode(Stream inputStream, UInt32 startAddr, Int32 recordSize)
+    {
+      String fileName;
+      Byte[] buffer;
+      Int32 n;
+      UInt32 memAddr = startAddr;
+      MemoryStream outStream;
+      SRecordWriter srw;
+
+      // Set S-record filename (real name or fake)
+      if (inputStream is FileStream)
+        fileName = ((FileStream)inputStream).Name;
+      else
+        fileName = "ublDaVinci.bin";
+      fileName = ModuleName(fileName);
+
+      outStream = new MemoryStream(EncodedLength(fileName.Length, inputStream.Length, recordSize));
+      srw = new SRecordWriter(outStream);
+      srw.WriteHeader(fileName);
+
+      // Read the input a whole number of records at a time
+      inputStream.Seek(0x0, SeekOrigin.Begin);
+      buffer = new Byte[recordSize * 1024];
+      while ((n = ReadBlock(inputStream, buffer)) > 0)
+      {
+        memAddr = srw.WriteData(memAddr, buffer, 0, n, recordSize);
+      }
+
+      srw.WriteEnd(startAddr);
+      return ExactBytes(outStream);
+    }
+
+    /// <summary>
+    /// Convert a binary array to S-records, as Encode(Stream, ...) does
+    /// </summary>
+    public static Byte[] Encode(Byte[] inputData, UInt32 startAddr, Int32 recordSize)
+    {
+      String fileName = ModuleName("ublDaVinci.bin");
+      MemoryStream outStream;
+      SRecordWriter srw;
+
+      outStream = new MemoryStream(EncodedLength(fileName.Length, inputData.Length, recordSize));
+      srw = new SRecordWriter(outStream);
+      srw.WriteHeader(fileName);
+      srw.WriteData(startAddr, inputData, 0, inputData.Length, recordSize);
+      srw.WriteEnd(startAddr);
+      return ExactBytes(outStream);
+    }
+
+    /// <summary>
+    /// Write the S0 header record carrying the module name
+    /// </summary>
+    public void WriteHeader(String moduleName)
+    {
+      Byte[] name = Encoding.ASCII.GetBytes(moduleName);
+      WriteRecord('0', 0, 2, name, 0, name.Length);
+    }
+
+    /// <summary>
+    /// Write data as S3 records of at most recordSize bytes each
+    /// </summary>
+    /// <param name="address">Address of the first byte of data.</param>
+    /// <returns>The address just past the data.</returns>
+    public UInt32 WriteData(UInt32 address, Byte[] data, Int32 offset, Int32 count, Int32 recordSize)
+    {
+      while (count > 0)
+      {
+        Int32 n = Math.Min(count, recordSize);
+        WriteRecord('3', address, 4, data, offset, n);
+        address += (UInt32)n;
+        offset += n;
+        count -= n;
+      }
+      return address;
+    }
+
+    /// <summary>
+    /// Write the S7 termination record carrying the entry point
+    /// </summary>
+    public void WriteEnd(UInt32 entryAddr)
+    {
+      WriteRecord('7', entryAddr, 4, null, 0, 0);
+    }
+
+    private void WriteRecord(Char type, UInt32 address, Int32 addrBytes, Byte[] data, Int32 offset, Int32 count)
+    {
+      Int32 recLen = addrBytes + count + 1;
+      Int32 checksum8 = recLen;
+      Int32 o;
+
+      // "S", type, length, address, data, checksum and linefeed
+      if (line.Length < ((recLen * 2) + 5))
+        line = new Byte[(recLen * 2) + 5];
+
+      line[0] = (Byte)'S';
+      line[1] = (Byte)type;
+      o = HexCodec.PutByte((Byte)recLen, line, 2);
+      for (Int32 shift = (addrBytes - 1) * 8; shift >= 0; shift -= 8)
+      {
+        Byte b = (Byte)(address >> shift);
+        checksum8 += b;
+        o = HexCodec.PutByte(b, line, o);
+      }
+      for (Int32 i = 0; i < count; i++)
+      {
+        checksum8 += data[offset + i];
+        o = HexCodec.PutByte(data[offset + i], line, o);
+      }
+      o = HexCodec.PutByte((Byte)((checksum8 & 0xFF) ^ 0xFF), line, o);
+      line[o++] = 0x0A;
+
+      output.Write(line, 0, o);
+    }
+
+    // S-record module name: the file name with a .hex extension, cut to
+    // fit the 20 byte field
+    private static String ModuleName(String fileName)
+    {
+      String shortFileName;
+
+      if (Path.HasExtension(fileName))
+        shortFileName = Path.GetFileNameWithoutExtension(fileName) + ".hex";
+      else
+        shortFileName = Path.GetFileName(fileName) + ".hex";
+
+      if (shortFileName.Length > 20)
+        shortFileName = shortFileName.Substring(0, 20);
+      return shortFileName;
+    }
+
+    // Exact size of the S0, S3 and S7 records for dataLength bytes, each
+    // record being "S", type, length, address, data, checksum and linefeed
+    private static Int32 EncodedLength(Int32 nameLength, Int64 dataLength, Int32 recordSize)
+    {
+      Int64 fullRecords = dataLength / recordSize;
+      Int64 lastRecord = dataLength % recordSize;
+      Int64 length;
+
+      length = 5 + 2 * (2 + nameLength + 1);
+      length += fullRecords * (5 + 2 * (4 + recordSize + 1));
+      if (lastRecord > 0)
+        length += 5 + 2 * (4 + lastRecord + 1);
+      length += 5 + 2 * (4 + 1);
+      return (Int32)length;
+    }
+
+    // Hand back the output buffer itself when it was sized exactly
+    private static Byte[] ExactBytes(MemoryStream outStream)
+    {
+      if (outStream.Length == outStream.Capacity)
+        return outStream.GetBuffer();
+      return outStream.ToArray();
+    }
+
+    // Fill buffer from the stream, short only at the end of the stream
+    private static Int32 ReadBlock(Stream inputStream, Byte[] buffer)
+    {
+      Int32 total = 0, n;
+
+      while (total < buffer.Length)
+      {
+        n = inputStream.Read(buffer, total, buffer.Length - total);
+        if (n <= 0)
+          break;
+        total += n;
+      }
+      return total;
+    }
+  }
+
+  /// <summary>
+  /// Reads Motorola S-records from a stream one record at a time, checking
+  /// each record's checksum.  The data of the current record is left in a
+  /// buffer that is reused for the next one.
+  /// </summary>
+  public class SRecordReader
+  {
+    private Stream input;
+    private Byte[] line = new Byte[80];
+    private Byte[] data = new Byte[32];
+    private Int32 dataLength;
+    private Char recordType;
+    private UInt32 address;
+    private Int32 lineNum;
+
+    public SRecordReader(Stream inputStream)
+    {
+      input = (inputStream is BufferedStream || inputStream is MemoryStream) ?
+        inputStream : new BufferedStream(inputStream);
+    }
+
+    /// <summary>
+    /// Record type character of the current record ('0' to '9')
+    /// </summary>
+    public Char RecordType
+    {
+      get { return recordType; }
+    }
+
+    /// <summary>
+    /// Address field of the current record
+    /// </summary>
+    public UInt32 Address
+    {
+      get { return address; }
+    }
+
+    /// <summary>
+    /// Data of the current record (valid for DataLength bytes)
+    /// </summary>
+    public Byte[] Data
+    {
+      get { return data; }
+    }
+
+    public Int32 DataLength
+    {
+      get { return dataLength; }
+    }
+
+    /// <summary>
+    /// Move to the next record, skipping blank lines
+    /// </summary>
+    /// <returns>False at the end of the input.</returns>
+    public Boolean Read()
+    {
+      Int32 len, addrBytes, recLen, checksum8, b;
+
+      do
+      {
+        len = ReadLine();
+        if (len < 0)
+          return false;
+      } while (len == 0);
+
+      if ((len < 4) || (line[0] != (Byte)'S') || (line[1] < (Byte)'0') || (line[1] > (Byte)'9'))
+        throw Malformed("not an S-record");
+      recordType = (Char)line[1];
+
+      switch (recordType)
+      {
+        case '2':
+        case '6':
+        case '8':
+          addrBytes = 3;
+          break;
+        case '3':
+        case '7':
+          addrBytes = 4;
+          break;
+        default:
+          addrBytes = 2;
+          break;
+      }
+
+      recLen = HexCodec.GetByte(line, 2);
+      if ((recLen < (addrBytes + 1)) || (len < (4 + (recLen * 2))))
+        throw Malformed("bad record length");
+
+      // Length, address, data and checksum bytes sum to 0xFF
+      checksum8 = recLen;
+      address = 0;
+      for (Int32 i = 0; i < recLen; i++)
+      {
+        b = HexCodec.GetByte(line, 4 + (i * 2));
+        if (b < 0)
+          throw Malformed("bad hex digit");
+        checksum8 += b;
+        if (i < addrBytes)
+          address = (address << 8) | (UInt32)b;
+      }
+      if ((checksum8 & 0xFF) != 0xFF)
+        throw Malformed("checksum error");
+
+      dataLength = recLen - addrBytes - 1;
+      if (data.Length < dataLength)
+        data = new Byte[dataLength];
+      HexCodec.GetBytes(line, 4 + (addrBytes * 2), data, 0, dataLength);
+      return true;
+    }
+
+    // Read one line into the line buffer, without its line ending
+    private Int32 ReadLine()
+    {
+      Int32 len = 0;
+      Int32 c = input.ReadByte();
+
+      if (c < 0)
+        return -1;
+      lineNum++;
+      while ((c >= 0) && (c != 0x0A))
+      {
+        if (c != 0x0D)
+        {
+          if (len == line.Length)
+            Array.Resize<Byte>(ref line, line.Length * 2);
+          line[len++] = (Byte)c;
+        }
+        c = input.ReadByte();
+      }
+      return len;
+    }
+
+    private InvalidDataException Malformed(String reason)
+    {
+      return new InvalidDataException(String.Format("S-record line {0}: {1}.", lineNum, reason));
+    }
+  }
+}
@@ -4,12 +4,13 @@ using System.IO.Ports;
 using System.Reflection;
 using System.Collections.Generic;
 using System.Text;
+using System.Threading;
 
 namespace UtilLib.IO
 {
   public class SerialIO
   {
-        /// <summary>
+    /// <summary>
     /// Waitforsequence with option for verbosity
     /// </summary>
     /// <param name="str">String to look for</param>
@@ -19,56 +20,514 @@ namespace UtilLib.IO
     /// <returns>Boolean to indicate if str or altStr was found.</returns>
     public static Boolean waitForSequence(String str, String altStr, SerialPort sp, Boolean verbose)
     {
-        Boolean strFound = false, altStrFound = false;
-        Byte[] input = new Byte[256];
-        String inputStr;
-        Int32 i;
+      return SerialEngine.GetEngine(sp).WaitForSequence(str, altStr, verbose);
+    }
+  }
+
+  /// <summary>
+  /// Streaming matcher for a small set of byte sequences (Aho-Corasick automaton
+  /// flattened into a 256-way state table).  Feed it one byte at a time; it
+  /// reports the index of the sequence that just completed, or -1.
+  /// </summary>
+  public class SequenceMatcher
+  {
+    #region Private Variables
+
+    private Int32[] next;
+    private Int32[] output;
+    private Int32 state;
+
+    #endregion
+
+    #region Class Constructors
+
+    public SequenceMatcher(params String[] sequences)
+    {
+      List<Int32[]> gotoTable = new List<Int32[]>();
+      List<Int32> outList = new List<Int32>();
+      Int32[] fail;
+      Queue<Int32> queue = new Queue<Int32>();
+      Int32 numStates;
+
+      // Build the trie, states numbered in creation order
+      gotoTable.Add(NewRow());
+      outList.Add(-1);
+      for (Int32 i = 0; i < sequences.Length; i++)
+      {
+        Byte[] seq = (new ASCIIEncoding()).GetBytes(sequences[i]);
+        Int32 s = 0;
+        foreach (Byte b in seq)
+        {
+          if (gotoTable[s][b] < 0)
+          {
+            gotoTable[s][b] = gotoTable.Count;
+            gotoTable.Add(NewRow());
+            outList.Add(-1);
+          }
+          s = gotoTable[s][b];
+        }
+        // Earlier sequences take precedence if two are identical
+        if (outList[s] < 0)
+          outList[s] = i;
+      }
+      numStates = gotoTable.Count;
+
+      // Breadth-first pass to fill in failure links and the full transition table
+      next = new Int32[numStates * 256];
+      output = outList.ToArray();
+      fail = new Int32[numStates];
+      for (Int32 c = 0; c < 256; c++)
+      {
+        Int32 t = gotoTable[0][c];
+        if (t < 0)
+        {
+          next[c] = 0;
+        }
+        else
+        {
+          next[c] = t;
+          fail[t] = 0;
+          queue.Enqueue(t);
+        }
+      }
+      while (queue.Count > 0)
+      {
+        Int32 s = queue.Dequeue();
+        if (output[s] < 0)
+          output[s] = output[fail[s]];
+        for (Int32 c = 0; c < 256; c++)
+        {
+          Int32 t = gotoTable[s][c];
+          if (t < 0)
+          {
+            next[(s * 256) + c] = next[(fail[s] * 256) + c];
+          }
+          else
+          {
+            next[(s * 256) + c] = t;
+            fail[t] = next[(fail[s] * 256) + c];
+            queue.Enqueue(t);
+          }
+        }
+      }
+
+      state = 0;
+    }
+
+    #endregion
+
+    #region Public functions
+
+    /// <summary>
+    /// Forget any partial match
+    /// </summary>
+    public void Reset()
+    {
+      state = 0;
+    }
+
+    /// <summary>
+    /// Advance the matcher by one byte
+    /// </summary>
+    /// <returns>Index of the sequence that ends at this byte, or -1.</returns>
+    public Int32 Step(Byte b)
+    {
+      state = next[(state * 256) + b];
+      return output[state];
+    }
+
+    #endregion
+
+    #region Private helper functions
+
+    private static Int32[] NewRow()
+    {
+      Int32[] row = new Int32[256];
+      for (Int32 c = 0; c < 256; c++)
+        row[c] = -1;
+      return row;
+    }
+
+    #endregion
+  }
+
+  /// <summary>
+  /// Buffered serial port engine.  A dedicated reader keeps one large read
+  /// outstanding on the port at all times and queues what arrives; protocol
+  /// tokens are then matched over that buffer instead of with a system call
+  /// per received byte.  Small writes are batched until the next wait (or an
+  /// explicit Flush) and bulk data is written in WriteChunkSize pieces.
+  /// There is one engine per open SerialPort, shared by everybody using it.
+  /// </summary>
+  public class SerialEngine
+  {
+    #region Public Types
+
+    /// <summary>
+    /// Progress callback for bulk writes
+    /// </summary>
+    public delegate void ProgressHandler(Int32 bytesDone, Int32 bytesTotal);
+
+    #endregion
+
+    #region Private Variables
+
+    private const Int32 ReadBufferSize = 4096;
+    private const Int32 MaxBufferedBytes = 1024 * 1024;
+    private const Int32 USBPacketSize = 64;
+
+    private static Dictionary<SerialPort,SerialEngine> engines = new Dictionary<SerialPort,SerialEngine>();
+
+    private SerialPort sp;
+    private Stream stream;
+    private Thread readerThread;
+    private Byte[] readBuf = new Byte[ReadBufferSize];
+    private Byte[] rxBuf = new Byte[ReadBufferSize * 4];
+    private Int32 rxStart, rxEnd;
+    private Exception readError;
+    private Object rxLock = new Object();
+    private AutoResetEvent dataReady = new AutoResetEvent(false);
+    private MemoryStream txBatch = new MemoryStream();
+    private Int32 writeChunkSize = ReadBufferSize;
+    private Dictionary<String,SequenceMatcher> matchers = new Dictionary<String,SequenceMatcher>();
+    private StringBuilder echoLine = new StringBuilder();
+
+    #endregion
+
+    #region Public Properties
+
+    /// <summary>
+    /// Size of the pieces bulk data is written in.  Rounded to a whole number
+    /// of USB full-speed bulk packets so USB serial adapters see full packets.
+    /// </summary>
+    public Int32 WriteChunkSize
+    {
+      get
+      {
+        return writeChunkSize;
+      }
+      set
+      {
+        writeChunkSize = (value < USBPacketSize) ? USBPacketSize : (value - (value % USBPacketSize));
+      }
+    }
+
+    /// <summary>
+    /// Serial port this engine drives
+    /// </summary>
+    public SerialPort Port
+    {
+      get
+      {
+        return sp;
+      }
+    }
+
+    #endregion
+
+    #region Class Constructors
 
-        while ((!strFound) && (!altStrFound))
+    private SerialEngine(SerialPort sp)
+    {
+      this.sp = sp;
+      this.stream = sp.BaseStream;
+
+      // A plain blocking reader rather than BeginRead, since older Mono runtimes
+      // complete Stream.BeginRead synchronously on the calling thread.
+      readerThread = new Thread(new ThreadStart(this.ReaderThreadStart));
+      readerThread.IsBackground = true;
+      readerThread.Name = "SerialEngine(" + sp.PortName + ")";
+      readerThread.Start();
+    }
+
+    /// <summary>
+    /// Get the engine for an open port, creating it on first use
+    /// </summary>
+    public static SerialEngine GetEngine(SerialPort sp)
+    {
+      SerialEngine engine;
+
+      lock (engines)
+      {
+        if ( (!engines.TryGetValue(sp, out engine)) ||
+             (engine.readError != null) ||
+             (!Object.ReferenceEquals(engine.stream, sp.BaseStream)) )
         {
+          engine = new SerialEngine(sp);
+          engines[sp] = engine;
+        }
+      }
+      return engine;
+    }
+
+    #endregion
 
-            i = 0;
-            do
-            {
-                input[i++] = (Byte)sp.ReadByte();
-                //Console.Write(input[i - 1] + " ");
-            } while ( (input[i - 1] != 0) &&
-                      (i < (input.Length - 1)) &&
-                      (input[i - 1] != 0x0A) &&
-                      (input[i - 1] != 0x0D) );
-
-            // Convert to string for comparison
-            if ((input[i-1] == 0x0A) || (input[i-1] == 0x0D))
-                inputStr = (new ASCIIEncoding()).GetString(input, 0, i-1);
-            else
-                inputStr = (new ASCIIEncoding()).GetString(input, 0, i);
-
-            if (inputStr.Length == 0)
-            {
-                continue;
-            }
-
-            // Compare Strings to see what came back
+    #region Public functions
+
+    /// <summary>
+    /// Wait for either of two sequences to arrive from the target.  Bytes up to
+    /// and including the match are consumed; anything after it stays buffered.
+    /// </summary>
+    /// <param name="str">String to look for</param>
+    /// <param name="altStr">String to look for but don't want</param>
+    /// <param name="verbose">Boolean to indicate verbosity.</param>
+    /// <returns>Boolean to indicate if str (true) or altStr (false) was found.</returns>
+    public Boolean WaitForSequence(String str, String altStr, Boolean verbose)
+    {
+      return WaitForSequence(str, altStr, verbose, Timeout.Infinite);
+    }
+
+    /// <summary>
+    /// WaitForSequence with a timeout in milliseconds
+    /// </summary>
+    public Boolean WaitForSequence(String str, String altStr, Boolean verbose, Int32 timeout)
+    {
+      SequenceMatcher matcher;
+      String key = str + "\n" + altStr;
+      Int32 found;
+
+      // Anything queued for the target has to go out before we wait on its reply
+      Flush();
+
+      if (!matchers.TryGetValue(key, out matcher))
+      {
+        // altStr goes first so, as before, it wins over str ending on the same byte
+        matcher = new SequenceMatcher(altStr, str);
+        matchers.Add(key, matcher);
+      }
+      matcher.Reset();
+
+      while (true)
+      {
+        lock (rxLock)
+        {
+          found = -1;
+          while ((rxStart < rxEnd) && (found < 0))
+          {
+            Byte b = rxBuf[rxStart++];
             if (verbose)
-                Console.WriteLine("\tTarget:\t{0}", inputStr);
-            if (inputStr.Contains(altStr))
-            {
-                altStrFound = true;
-                if (String.Equals(str, altStr))
-                {
-                    strFound = altStrFound;
-                }
-            }
-            else if (inputStr.Contains(str))
-            {
-                strFound = true;
-            }
-            else
-            {
-                strFound = false;
-            }
+              Echo(b);
+            found = matcher.Step(b);
+          }
+          if (found >= 0)
+          {
+            if (verbose)
+              EchoFlush();
+            return ((found == 1) || String.Equals(str, altStr));
+          }
+          if (readError != null)
+            throw readError;
+        }
+
+        if (!dataReady.WaitOne(timeout, false))
+          throw new TimeoutException("Timed out waiting for \"" + str.TrimEnd('\0') + "\" on " + sp.PortName + ".");
+      }
+    }
+
+    /// <summary>
+    /// Read exactly count bytes from the target
+    /// </summary>
+    public Int32 Read(Byte[] buffer, Int32 offset, Int32 count)
+    {
+      return Read(buffer, offset, count, Timeout.Infinite);
+    }
+
+    /// <summary>
+    /// Read with a timeout in milliseconds
+    /// </summary>
+    public Int32 Read(Byte[] buffer, Int32 offset, Int32 count, Int32 timeout)
+    {
+      Int32 done = 0;
+
+      Flush();
+      while (true)
+      {
+        lock (rxLock)
+        {
+          Int32 n = Math.Min(count - done, rxEnd - rxStart);
+          Buffer.BlockCopy(rxBuf, rxStart, buffer, offset + done, n);
+          rxStart += n;
+          done += n;
+          if (done == count)
+            return done;
+          if (readError != null)
+            throw readError;
         }
-        return strFound;
+        if (!dataReady.WaitOne(timeout, false))
+          throw new TimeoutException("Timed out reading from " + sp.PortName + ".");
+      }
+    }
+
+    /// <summary>
+    /// Throw away everything received so far
+    /// </summary>
+    public void DiscardInBuffer()
+    {
+      lock (rxLock)
+      {
+        sp.DiscardInBuffer();
+        rxStart = 0;
+        rxEnd = 0;
+      }
+    }
+
+    /// <summary>
+    /// Queue a string; it is sent with the next Flush, bulk write or wait.
+    /// </summary>
+    public void Write(String s)
+    {
+      Byte[] data = sp.Encoding.GetBytes(s);
+      Queue(data, 0, data.Length);
+    }
+
+    /// <summary>
+    /// Queue raw bytes; they are sent with the next Flush, bulk write or wait.
+    /// </summary>
+    public void Queue(Byte[] data, Int32 offset, Int32 count)
+    {
+      txBatch.Write(data, offset, count);
+      if (txBatch.Length >= writeChunkSize)
+        Flush();
+    }
+
+    /// <summary>
+    /// Write bulk data in WriteChunkSize pieces
+    /// </summary>
+    public void Write(Byte[] data, Int32 offset, Int32 count)
+    {
+      Write(data, offset, count, null);
+    }
+
+    /// <summary>
+    /// Write bulk data in WriteChunkSize pieces, reporting progress after each
+    /// </summary>
+    public void Write(Byte[] data, Int32 offset, Int32 count, ProgressHandler progress)
+    {
+      Int32 n;
+
+      Flush();
+      for (Int32 i = 0; i < count; i += n)
+      {
+        n = Math.Min(writeChunkSize, count - i);
+        stream.Write(data, offset + i, n);
+        if (progress != null)
+          progress(i + n, count);
+      }
     }
+
+    /// <summary>
+    /// Send any queued writes as one transfer
+    /// </summary>
+    public void Flush()
+    {
+      if (txBatch.Length > 0)
+      {
+        stream.Write(txBatch.GetBuffer(), 0, (Int32) txBatch.Length);
+        txBatch.SetLength(0);
+      }
+    }
+
+    #endregion
+
+    #region Private helper functions
+
+    private void ReaderThreadStart()
+    {
+      Int32 count;
+
+      while (true)
+      {
+        try
+        {
+          count = stream.Read(readBuf, 0, readBuf.Length);
+        }
+        catch (TimeoutException)
+        {
+          continue;
+        }
+        catch (Exception e)
+        {
+          Fail(e);
+          return;
+        }
+
+        if (count <= 0)
+        {
+          if (!sp.IsOpen)
+          {
+            Fail(new ObjectDisposedException(sp.PortName));
+            return;
+          }
+          continue;
+        }
+
+        lock (rxLock)
+        {
+          Append(readBuf, count);
+        }
+        dataReady.Set();
+      }
+    }
+
+    private void Append(Byte[] data, Int32 count)
+    {
+      Int32 used = rxEnd - rxStart;
+
+      // Nobody is listening; drop the oldest data rather than grow forever
+      if ((used + count) > MaxBufferedBytes)
+      {
+        rxStart += (used + count) - MaxBufferedBytes;
+        used = rxEnd - rxStart;
+      }
+
+      if ((rxEnd + count) > rxBuf.Length)
+      {
+        Byte[] dest = rxBuf;
+        if ((used + count) > rxBuf.Length)
+          dest = new Byte[Math.Max(rxBuf.Length * 2, used + count)];
+        Buffer.BlockCopy(rxBuf, rxStart, dest, 0, used);
+        rxBuf = dest;
+        rxStart = 0;
+        rxEnd = used;
+      }
+
+      Buffer.BlockCopy(data, 0, rxBuf, rxEnd, count);
+      rxEnd += count;
+    }
+
+    private void Fail(Exception e)
+    {
+      lock (rxLock)
+      {
+        readError = e;
+      }
+      lock (engines)
+      {
+        SerialEngine engine;
+        if (engines.TryGetValue(sp, out engine) && (engine == this))
+          engines.Remove(sp);
+      }
+      dataReady.Set();
+    }
+
+    // Target output is shown a line (or null-terminated token) at a time
+    private void Echo(Byte b)
+    {
+      if ((b == 0) || (b == 0x0A) || (b == 0x0D))
+        EchoFlush();
+      else
+        echoLine.Append((Char) b);
+    }
+
+    private void EchoFlush()
+    {
+      if (echoLine.Length != 0)
+      {
+        Console.WriteLine("\tTarget:\t{0}", echoLine.ToString());
+        echoLine.Length = 0;
+      }
+    }
+
+    #endregion
   }
 }
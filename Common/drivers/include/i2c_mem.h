@@ -21,6 +21,10 @@ extern far "c" {
 * Global Macro Declarations                                 *
 ************************************************************/
 
+#define I2C_MEM_MAX_PAGE_SIZE     (256)
+#define I2C_MEM_MAX_READ_CNT      (0xFFFF)    // ICCNT is 16 bits
+#define I2C_MEM_ACK_POLL_TIMEOUT  (0x10000)   // Address probes before giving up on a write cycle
+
 
 /***********************************************************
 * Global Typedef declarations                              *
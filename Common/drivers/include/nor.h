@@ -40,6 +40,9 @@ extern far "c" {
 #define AMD_PROG_CMD                (0xA0)        // AMD simple Write command
 #define AMD_WRT_BUF_LOAD_CMD        (0x25)        // AMD write buffer load command
 #define AMD_WRT_BUF_CONF_CMD        (0x29)        // AMD write buffer confirm command
+#define AMD_UNLOCK_BYPASS_CMD       (0x20)        // AMD unlock bypass entry command
+#define AMD_UNLOCK_BYPASS_RST_CMD0  (0x90)        // AMD unlock bypass reset, first cycle
+#define AMD_UNLOCK_BYPASS_RST_CMD1  (0x00)        // AMD unlock bypass reset, second cycle
 
 /**************** DEFINES for Intel Basic Command Set **************/
 #define INTEL_ID_CMD                (0x90)        // Intel ID CMD
@@ -96,6 +99,13 @@ extern far "c" {
 // Maximum number of block regions supported
 #define CFI_MAXREGIONS          (0x06)
 
+// Maximum number of sectors handed to one multi-sector erase
+#define NOR_MAX_ERASE_QUEUE     (16)
+
+// Erase and write options (NOR_InfoObj.options)
+#define NOR_OPT_BLANK_SKIP      (0x00000001)  // Don't erase blank sectors or program 0xFF data
+#define NOR_OPT_VERIFY_CRC      (0x00000002)  // Verify writes with one CRC-32 pass instead of per-buffer compares
+
 
 /***********************************************************
 * Global Typedef declarations                              *
@@ -143,6 +153,16 @@ typedef struct _NOR_INFO_
   Uint8       numberRegions;                // Number of regions of contiguous regions of same block size
   Uint32      numberBlocks[CFI_MAXREGIONS]; // Number of blocks in a region
   Uint32      blockSize[CFI_MAXREGIONS];    // Size of the blocks in a region
+  Uint32      regionEnd[CFI_MAXREGIONS];    // Address just past the end of a region
+  Uint8       currRegion;                   // Region of the most recent block lookup
+  Bool        unlockBypass;                 // AMD unlock bypass mode is active
+  Uint32      options;                      // NOR_OPT_* flags, NOR_OPT_BLANK_SKIP by default
+  Uint32      *crcTable;                    // CRC-32 table for NOR_OPT_VERIFY_CRC (built on first use)
+  Uint32      bytesProgrammed;              // Bytes programmed by the last NOR_writeBytes
+  Uint32      bytesSkipped;                 // 0xFF bytes it left in the erased state
+  Uint32      verifyCRC;                    // CRC-32 of the data it wrote (NOR_OPT_VERIFY_CRC)
+  Uint32      sectorsErased;                // Sectors erased by the last NOR_erase
+  Uint32      sectorsSkipped;               // Sectors it found blank already
   NOR_ManfID  manfID;                       // Manufacturer's ID
   Uint16      devID1;                       // Device ID
   Uint16      devID2;                       // Used for AMD 3-byte ID devices
@@ -150,9 +170,21 @@ typedef struct _NOR_INFO_
 }
 NOR_InfoObj,*NOR_InfoHandle;
 
+// State for walking the sectors (erase blocks) that overlap an address range
+typedef struct _NOR_SECTOR_ITER_
+{
+  Uint32      blockAddr;                    // Start of the current sector
+  Uint32      blockSize;                    // Size of the current sector
+  Uint32      nextAddr;                     // Start of the next sector
+  Uint32      endAddr;                      // End of the range
+  Uint8       region;                       // Erase region of the current sector
+}
+NOR_SectorIterObj,*NOR_SectorIterHandle;
+
 typedef Uint32   (* Flash_Write)(NOR_InfoHandle, Uint32, VUint32);
 typedef Uint32   (* Flash_BufferWrite)(NOR_InfoHandle, Uint32, VUint8[], Uint32);
 typedef Uint32   (* Flash_Erase)(NOR_InfoHandle, Uint32);
+typedef Uint32   (* Flash_MultiErase)(NOR_InfoHandle, Uint32[], Uint32*);
 typedef Uint32   (* Flash_ID)(NOR_InfoHandle);
 typedef void     (* Flash_Reset)(NOR_InfoHandle);
 
@@ -161,6 +193,7 @@ typedef struct _NOR_FXNS_
   const Flash_Write       write;
   const Flash_BufferWrite bufferWrite;
   const Flash_Erase       erase;
+  const Flash_MultiErase  multiErase;
   const Flash_ID          id;
   const Flash_Reset       reset;
 }
@@ -193,6 +226,8 @@ extern __FAR__ Uint32 NOR_writeBytes(NOR_InfoHandle hNorInfo, Uint32 writeAddres
 extern __FAR__ Uint32 NOR_globalErase(NOR_InfoHandle hNorInfo);
 extern __FAR__ Uint32 NOR_erase(NOR_InfoHandle hNorInfo, Uint32 start_address, Uint32 size);
 extern __FAR__ Uint32 NOR_getBlockInfo(NOR_InfoHandle hNorInfo, Uint32 address,Uint32* blockSize, Uint32* blockAddr);
+extern __FAR__ Uint32 NOR_sectorIterInit(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 size, NOR_SectorIterHandle hIter);
+extern __FAR__ Bool   NOR_sectorIterNext(NOR_InfoHandle hNorInfo, NOR_SectorIterHandle hIter);
 extern __FAR__ void NOR_reset(NOR_InfoHandle hNorInfo);
 
 
@@ -158,6 +158,12 @@ extern far "c" {
 #define SD_APP_OP_COND             (SDMMC_CMD41 | SDMMC_RSP3 )
 #define SD_SEND_RELATIVE_ADDR      (SDMMC_CMD3 | SDMMC_RSP6 | SDMMC_PPLEN)
 #define SD_SET_BUS_WIDTH           (SDMMC_CMD6  | SDMMC_RSP1 | SDMMC_PPLEN)
+#define SD_SWITCH_FUNC             (SDMMC_CMD6  | SDMMC_RSP1 | SDMMC_PPLEN)
+
+// CMD6 arguments: query/select function 1 (high speed) in group 1, leave the rest
+#define SD_SWITCH_CHECK_HS         (0x00FFFFF1u)
+#define SD_SWITCH_SET_HS           (0x80FFFFF1u)
+#define SD_SWITCH_STATUS_BYTES     (64)
 
 
 
@@ -348,6 +354,8 @@ typedef struct _SDMMC_INFO_
   SDMMC_csdRegInfo mmcSdCSDRegInfo;
   Uint32 dataBytesPerBlk;
   Uint32 dataBytesPerBlkPower2;
+  Uint8 busWidth4;              // Card and controller switched to 4-bit data
+  Uint8 highSpeed;              // Card switched to high speed timing
 } 
 SDMMC_InfoObj, *SDMMC_InfoHandle;
 
@@ -19,6 +19,7 @@ extern far "c" {
 * Global Macro Declarations                                 *
 ************************************************************/
 
+#define SPI_TXINTFLAG     (0x00000200u)
 #define SPI_RXINTFLAG     (0x00000100u)
 #define SPI_OVRNINTFLG    (0x00000040u)
 #define SPI_BITERRFLG     (0x00000010u)
@@ -77,6 +78,7 @@ extern Uint32 SPI_reset(SPI_InfoHandle hSPIInfo);
 extern Uint32 SPI_readBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *dest);
 extern Uint32 SPI_writeBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *src);
 extern Uint32 SPI_xferOneChar(SPI_InfoHandle hSPIInfo, Uint32 dataOut);
+extern Uint32 SPI_xferBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *src, Uint8 *dest);
 extern void SPI_enableCS(SPI_InfoHandle hSPIInfo);
 extern void SPI_disableCS(SPI_InfoHandle hSPIInfo);
 
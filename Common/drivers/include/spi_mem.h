@@ -20,6 +20,25 @@ extern far "c" {
 * Global Macro Declarations                                 *
 ************************************************************/
 
+// Program page sizes (writes must not cross a page boundary)
+#define SPI_MEM_FLASH_PAGE_SIZE       (256)
+#define SPI_MEM_EEPROM_PAGE_SIZE      (16)     // Smallest common SPI EEPROM page
+
+// Status register polling while a write is in progress
+#define SPI_MEM_STATUS_BUSY           (0x01)
+#define SPI_MEM_STATUS_WEL            (0x02)
+#define SPI_MEM_POLL_DELAY            (1000)    // UTIL_waitLoopAccurate count between RDSR reads
+#define SPI_MEM_POLL_TIMEOUT          (0x00100000)
+
+// Erase polls allowed, from datasheet worst cases with each poll taking at
+// least SPI_MEM_POLL_DELAY cycles (about 3.3 us at 300 MHz)
+#define SPI_MEM_ERASE_TIMEOUT         (0x00100000)  // Sector/block erase: 3 s max (M25P 64 KB sector)
+#define SPI_MEM_CHIP_ERASE_TIMEOUT    (0x05000000)  // Chip erase: 250 s max (M25P128 bulk erase)
+
+// Erase geometry
+#define SPI_MEM_MAX_ERASE_TYPES       (4)
+#define SPI_MEM_SFDP_SIGNATURE        (0x50444653)  // "SFDP", little endian
+
 
 /***********************************************************
 * Global Typedef declarations                              *
@@ -45,15 +64,25 @@ typedef enum _SPI_MEM_COMMANDS_
   SPI_MEM_CMD_FASTREAD = 0x0B,                // SPI Flash only 
   SPI_MEM_CMD_FASTREAD_DUAL_OUTPUT = 0x3B,    // SPI Flash only 
   SPI_MEM_CMD_BLOCKERASE = 0xD8,              // SPI Flash only 
+  SPI_MEM_CMD_BLOCKERASE32 = 0x52,            // SPI Flash only 
   SPI_MEM_CMD_SECTORERASE = 0x20,             // SPI Flash only 
   SPI_MEM_CMD_CHIPERASE = 0xC7,               // SPI Flash only 
   SPI_MEM_CMD_POWERDOWN = 0xB9,               // SPI Flash only 
   SPI_MEM_CMD_RELEASE_POWERDOWN = 0xAB,       // SPI Flash only 
   SPI_MEM_CMD_SIMPLE_ID = 0x90,               // SPI Flash only 
-  SPI_MEM_CMD_JEDEC_ID = 0x9F                 // SPI Flash only 
+  SPI_MEM_CMD_JEDEC_ID = 0x9F,                // SPI Flash only 
+  SPI_MEM_CMD_READ_SFDP = 0x5A                // SPI Flash only 
 }
 SPI_Mem_Commands;
 
+// One supported erase granularity
+typedef struct _SPI_MEM_ERASE_TYPE_
+{
+  Uint32 size;
+  Uint8  cmd;
+}
+SPI_MemEraseType;
+
 typedef struct _SPI_MEM_CMDS_
 {
   Uint8 readCmd;
@@ -65,9 +94,15 @@ SPI_MemCmds;
 typedef struct _SPI_MEM_INFO_
 {
   SPI_InfoHandle hSPIInfo;
+  SPI_Config spiCfg;
   SPI_Mem_Type memType;
   Uint32 addrWidth;
   Uint32 memorySize;
+  Uint32 pageSize;
+  Uint8 manfID;
+  Uint16 devID;
+  Uint32 eraseTypeCnt;                                  // Sorted largest first
+  SPI_MemEraseType eraseTypes[SPI_MEM_MAX_ERASE_TYPES];
 }
 SPI_MemInfoObj, *SPI_MemInfoHandle;
 
@@ -35,6 +35,11 @@
 * Local Function Declarations                               *
 ************************************************************/
 
+static Uint32 LOCAL_setAddrBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr, Uint8 *buf);
+#ifndef USE_IN_ROM
+static Uint32 LOCAL_waitWriteCycle(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr);
+#endif
+
 
 /************************************************************
 * Local Variable Definitions                                *
@@ -82,31 +87,42 @@ I2C_MemInfoHandle I2C_MEM_open(Uint32 i2cPeripheralNum, I2C_ConfigHandle hI2cCfg
 }
 
 
-// Routine to read a page from I2C
+// Routine to read data from I2C. The EEPROM's address counter runs on
+// across page boundaries during a sequential read, so one random-read
+// transaction covers as much as the byte counter allows.
 Uint32 I2C_MEM_readBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *dest)
 {
   Uint8 localAddr[4];
+  Uint32 addrCnt, cnt;
 
   // Check desired byte count verse
   if ((addr+byteCnt) > hI2CMemInfo->hI2CMemCfg->memorySize)
     return E_FAIL;
 
-  // Write address bytes
-  localAddr[0] = (addr>>8) & 0xFF;
-  localAddr[1] = (addr>>0) & 0xFF;
-  if ( I2C_writeBytes(hI2CMemInfo->hI2CInfo,2,localAddr) != E_PASS )
+  while (byteCnt > 0)
   {
-    return E_FAIL;
-  }
+    cnt = (byteCnt > I2C_MEM_MAX_READ_CNT) ? I2C_MEM_MAX_READ_CNT : byteCnt;
 
-  // Read the data bytes
-  if ( I2C_readBytes(hI2CMemInfo->hI2CInfo,byteCnt,dest) != E_PASS )
-  {
-    return E_FAIL;
-  }
+    // Write address bytes
+    addrCnt = LOCAL_setAddrBytes(hI2CMemInfo, addr, localAddr);
+    if ( I2C_writeBytes(hI2CMemInfo->hI2CInfo,addrCnt,localAddr) != E_PASS )
+    {
+      return E_FAIL;
+    }
 
-  // Manually assert stop condition
-  I2C_setStopCondition(hI2CMemInfo->hI2CInfo);
+    // Read the data bytes (repeated start)
+    if ( I2C_readBytes(hI2CMemInfo->hI2CInfo,cnt,dest) != E_PASS )
+    {
+      return E_FAIL;
+    }
+
+    // Manually assert stop condition
+    I2C_setStopCondition(hI2CMemInfo->hI2CInfo);
+
+    addr    += cnt;
+    dest    += cnt;
+    byteCnt -= cnt;
+  }
 
   return E_PASS;
 }
@@ -116,32 +132,39 @@ Uint32 I2C_MEM_readBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr, Uint32 byte
 // This can be used for using this driver as read-only for ROM code
 #ifndef USE_IN_ROM    
 
-// Generic routine to write a page of data to I2C EEPROM
+// Generic routine to write data to I2C EEPROM, one page per write cycle
 Uint32 I2C_MEM_writeBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *src)
 {
 
-  Int32 i,j,k, cycCnt;
-  Uint8 localBuffer[256];
+  Uint32 i,j,k, cycCnt, addrCnt, pageSize;
+  Uint8 localBuffer[I2C_MEM_MAX_PAGE_SIZE + 2];
 
   if ((addr+byteCnt) > hI2CMemInfo->hI2CMemCfg->memorySize)
     return E_FAIL;
 
-  // Write the bytes in page chunks
+  pageSize = hI2CMemInfo->hI2CMemCfg->pageSize;
+  if ((pageSize == 0) || (pageSize > I2C_MEM_MAX_PAGE_SIZE))
+    return E_FAIL;
+
+  // Write the bytes in page chunks. A page write that crosses a page
+  // boundary wraps around inside the page, so the first chunk only runs
+  // up to the boundary and every later one is a full, aligned page.
   cycCnt = 0;
 	for ( i=0; i<byteCnt; i+= k )
 	{
-		k = ( (byteCnt-i) > hI2CMemInfo->hI2CMemCfg->pageSize ) ? hI2CMemInfo->hI2CMemCfg->pageSize : (byteCnt-i);
+    k = pageSize - (addr & (pageSize - 1));
+    if (k > (byteCnt-i))
+      k = byteCnt-i;
 
     // Copy the addr and data to local buffer
-    localBuffer[0] = (addr>>8) & 0xFF;
-    localBuffer[1] = (addr>>0) & 0xFF;
+    addrCnt = LOCAL_setAddrBytes(hI2CMemInfo, addr, localBuffer);
     for (j=0;j<k;j++)
     {
-      localBuffer[j+2] = src[j];
+      localBuffer[j+addrCnt] = src[j];
     }
 
     // Then write addr and data bytes
-    if ( I2C_writeBytes(hI2CMemInfo->hI2CInfo,k+2,localBuffer) != E_PASS )
+    if ( I2C_writeBytes(hI2CMemInfo->hI2CInfo,k+addrCnt,localBuffer) != E_PASS )
 		{
       DEBUG_printString("On Cycle Count ");
       DEBUG_printHexInt(cycCnt);
@@ -153,7 +176,11 @@ Uint32 I2C_MEM_writeBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr, Uint32 byt
     I2C_setStopCondition(hI2CMemInfo->hI2CInfo);
 
     // Wait for EEPROM  to finish
-    UTIL_waitLoop(1000000);
+    if (LOCAL_waitWriteCycle(hI2CMemInfo, addr) != E_PASS)
+    {
+      DEBUG_printString("Write cycle timeout\r\n");
+      return E_TIMEOUT;
+    }
 		
     // Increment addr value and data pointer
 		addr += k;
@@ -198,6 +225,44 @@ Uint32 I2C_MEM_eraseBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 startAddr, Uint3
 * Local Function Definitions                                *
 ************************************************************/
 
+// Fill in the memory address bytes (MSB first), return how many
+static Uint32 LOCAL_setAddrBytes(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr, Uint8 *buf)
+{
+  if (hI2CMemInfo->hI2CMemCfg->addrWidth == 8)
+  {
+    buf[0] = (addr>>0) & 0xFF;
+    return 1;
+  }
+
+  buf[0] = (addr>>8) & 0xFF;
+  buf[1] = (addr>>0) & 0xFF;
+  return 2;
+}
+
+#ifndef USE_IN_ROM
+// Acknowledge polling: the EEPROM ignores its slave address while the
+// internal write cycle runs, so keep addressing it (with a dummy write of
+// the address bytes only, which starts no new cycle) until it ACKs. This
+// finishes as soon as the part does instead of after a worst case delay.
+static Uint32 LOCAL_waitWriteCycle(I2C_MemInfoHandle hI2CMemInfo, Uint32 addr)
+{
+  Uint8 localAddr[4];
+  Uint32 addrCnt, pollCnt;
+
+  addrCnt = LOCAL_setAddrBytes(hI2CMemInfo, addr, localAddr);
+  for (pollCnt = 0; pollCnt < I2C_MEM_ACK_POLL_TIMEOUT; pollCnt++)
+  {
+    if ( I2C_writeBytes(hI2CMemInfo->hI2CInfo,addrCnt,localAddr) == E_PASS )
+    {
+      I2C_setStopCondition(hI2CMemInfo->hI2CInfo);
+      return E_PASS;
+    }
+  }
+
+  return E_TIMEOUT;
+}
+#endif
+
 
 /***********************************************************
 * End file                                                 *
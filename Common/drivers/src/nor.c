@@ -45,6 +45,8 @@ static void LOCAL_flashMakeCmd (NOR_InfoHandle hNorInfo, Uint8 cmd, void *cmdbuf
 static void LOCAL_flashWriteCmd (NOR_InfoHandle hNorInfo, Uint32 blkAddr, Uint32 offset, Uint8 cmd);
 static void LOCAL_flashWriteData(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 data);
 static Uint32 LOCAL_flashVerifyDataBuffer(NOR_InfoHandle hNorInfo, Uint32 address, void* data, Uint32 numBytes);
+static Uint32 LOCAL_flashVerifyCRC(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 readAddress, Uint32 numBytes);
+static Bool LOCAL_isBlank(Uint32 address, Uint32 numBytes);
 static Uint32 LOCAL_flashReadData(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 offset);
 static Bool LOCAL_flashIsSetAll (NOR_InfoHandle hNorInfo, Uint32 blkAddr, Uint32 offset, Uint8 mask);
 static Bool LOCAL_flashIsSetSome (NOR_InfoHandle hNorInfo, Uint32 blkAddr, Uint32 offset, Uint8 mask);
@@ -52,10 +54,13 @@ static NOR_Data LOCAL_flashReadCFIBytes (NOR_InfoHandle hNorInfo, Uint32 offset,
 static Bool LOCAL_flashCFIIsEqual (NOR_InfoHandle hNorInfo, Uint32 offset, Uint8 val);
 // Flash Identification and discovery
 static Uint32   LOCAL_flashQueryCFI( NOR_InfoHandle hNorInfo );
+static void     LOCAL_flashBuildRegionMap( NOR_InfoHandle hNorInfo );
+static Uint8    LOCAL_flashFindRegion( NOR_InfoHandle hNorInfo, Uint32 address );
 
 
 // Empty commands for when neither command set is used
 static Uint32   Unsupported_Erase(NOR_InfoHandle hNorInfo, Uint32 address);
+static Uint32   Unsupported_MultiErase(NOR_InfoHandle hNorInfo, Uint32 blkAddr[], Uint32 *numBlocks);
 static Uint32   Unsupported_Write(NOR_InfoHandle hNorInfo, Uint32 address, VUint32 data);
 static Uint32   Unsupported_BufferWrite(NOR_InfoHandle hNorInfo, Uint32, VUint8[], Uint32 );
 static Uint32   Unsupported_ID(NOR_InfoHandle hNorInfo);
@@ -64,6 +69,7 @@ static void     Unsupported_SoftReset(NOR_InfoHandle hNorInfo);
 
 //Intel pointer-mapped commands
 static Uint32   Intel_Erase( NOR_InfoHandle hNorInfo, VUint32 blkAddr);
+static Uint32   Intel_MultiErase( NOR_InfoHandle hNorInfo, Uint32 blkAddr[], Uint32 *numBlocks);
 static Uint32   Intel_Write( NOR_InfoHandle hNorInfo, Uint32 address, VUint32 data );
 static Uint32   Intel_BufferWrite( NOR_InfoHandle hNorInfo, Uint32 address, VUint8 data[], Uint32 numBytes );
 static Uint32   Intel_ID( NOR_InfoHandle hNorInfo );
@@ -78,6 +84,7 @@ static void     LOCAL_IntelWaitForStatusComplete(NOR_InfoHandle hNorInfo);
 
 //AMD pointer-mapped commands
 static Uint32   AMD_Erase(NOR_InfoHandle hNorInfo, Uint32 blkAddr);
+static Uint32   AMD_MultiErase(NOR_InfoHandle hNorInfo, Uint32 blkAddr[], Uint32 *numBlocks);
 static Uint32   AMD_Write(NOR_InfoHandle hNorInfo, Uint32 address, VUint32 data );
 static Uint32   AMD_BufferWrite(NOR_InfoHandle hNorInfo, Uint32 address, VUint8 data[], Uint32 numBytes );
 static Uint32   AMD_ID(NOR_InfoHandle hNorInfo);
@@ -85,6 +92,8 @@ static void     AMD_SoftReset(NOR_InfoHandle hNorInfo);
 // Misc. AMD commands
 static void     LOCAL_AMDPrefixCommands(NOR_InfoHandle hNorInfo);
 static void     LOCAL_AMDWriteBufAbortReset(NOR_InfoHandle hNorInfo);
+static void     LOCAL_AMDUnlockBypassEnter(NOR_InfoHandle hNorInfo);
+static void     LOCAL_AMDUnlockBypassExit(NOR_InfoHandle hNorInfo);
 
 
 /************************************************************
@@ -101,6 +110,7 @@ const NOR_FxnsTable AMD_NOR_FxnsTable =
   &(AMD_Write),
   &(AMD_BufferWrite),
   &(AMD_Erase),
+  &(AMD_MultiErase),
   &(AMD_ID),
   &(AMD_SoftReset)
 };
@@ -110,6 +120,7 @@ const NOR_FxnsTable Intel_NOR_FxnsTable =
   &(Intel_Write),
   &(Intel_BufferWrite),
   &(Intel_Erase),
+  &(Intel_MultiErase),
   &(Intel_ID),
   &(Intel_SoftReset)
 };
@@ -119,6 +130,7 @@ const NOR_FxnsTable Unsupported_NOR_FxnsTable =
   &(Unsupported_Write),
   &(Unsupported_BufferWrite),
   &(Unsupported_Erase),
+  &(Unsupported_MultiErase),
   &(Unsupported_ID),
   &(Unsupported_SoftReset)
 };
@@ -159,6 +171,9 @@ NOR_InfoHandle NOR_open(Uint32 baseCSAddr, Uint8 busWidth)
   // Set width to 8 or 16
   hNorInfo->busWidth = busWidth;
 
+  // Leave blank sectors and 0xFF data alone unless the caller says otherwise
+  hNorInfo->options = NOR_OPT_BLANK_SKIP;
+
   // Try both Intel and AMD resets ( we don't know yet which we need)
   AMD_SoftReset(hNorInfo);
   Intel_SoftReset(hNorInfo);
@@ -247,29 +262,66 @@ NOR_InfoHandle NOR_open(Uint32 baseCSAddr, Uint8 busWidth)
 // Get info on block address and sizes
 Uint32 NOR_getBlockInfo(NOR_InfoHandle hNorInfo, Uint32 address, Uint32* blockSize, Uint32* blockAddr)
 {
-  Int32 i;
-  Uint32 currRegionAddr, nextRegionAddr;
-        
-  currRegionAddr = (Uint32) hNorInfo->flashBase;
-  if ((address < currRegionAddr) || (address >= (currRegionAddr+hNorInfo->flashSize)))
+  Uint32 i;
+
+  if ((address < hNorInfo->flashBase) || (address >= (hNorInfo->flashBase+hNorInfo->flashSize)))
   {
     return E_FAIL;
   }
-    
-  for(i=0; i< (hNorInfo->numberRegions); i++)
+
+  // Nearly every lookup lands in the same region as the one before it
+  i = hNorInfo->currRegion;
+  if ( (address >= hNorInfo->regionEnd[i]) ||
+       ((i > 0) && (address < hNorInfo->regionEnd[i-1])) )
   {
-    nextRegionAddr = currRegionAddr + (hNorInfo->blockSize[i] * hNorInfo->numberBlocks[i]);
-    if ( (currRegionAddr <= address) && (nextRegionAddr > address) )
-    {
-      *blockSize = hNorInfo->blockSize[i];
-      *blockAddr = address & (~((*blockSize) - 1));
-      break;
-    }
-    currRegionAddr = nextRegionAddr;
+    i = LOCAL_flashFindRegion(hNorInfo, address);
+    hNorInfo->currRegion = i;
+  }
+
+  // Block sizes are powers of two and regions start on block boundaries
+  *blockSize = hNorInfo->blockSize[i];
+  *blockAddr = address & (~((*blockSize) - 1));
+  return E_PASS;
+}
+
+// Start walking the sectors that overlap the given range
+Uint32 NOR_sectorIterInit(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 size, NOR_SectorIterHandle hIter)
+{
+  if ( (address < hNorInfo->flashBase) || (size > hNorInfo->flashSize) ||
+       ((address - hNorInfo->flashBase) > (hNorInfo->flashSize - size)) )
+  {
+    return E_FAIL;
   }
+
+  hIter->blockAddr = 0;
+  hIter->blockSize = 0;
+  hIter->nextAddr  = address;
+  hIter->endAddr   = address + size;
+  hIter->region    = LOCAL_flashFindRegion(hNorInfo, address);
+
   return E_PASS;
 }
 
+// Step to the next sector of the range, returns FALSE once the range is covered
+Bool NOR_sectorIterNext(NOR_InfoHandle hNorInfo, NOR_SectorIterHandle hIter)
+{
+  if (hIter->nextAddr >= hIter->endAddr)
+    return FALSE;
+
+  // Move on to the next region when this one is used up
+  while ( (hIter->nextAddr >= hNorInfo->regionEnd[hIter->region]) &&
+          (hIter->region < (hNorInfo->numberRegions - 1)) )
+  {
+    hIter->region++;
+  }
+
+  hIter->blockSize = hNorInfo->blockSize[hIter->region];
+  hIter->blockAddr = hIter->nextAddr & (~(hIter->blockSize - 1));
+  hIter->nextAddr  = hIter->blockAddr + hIter->blockSize;
+
+  return TRUE;
+}
+
 //Global Erase NOR Flash
 Uint32 NOR_globalErase(NOR_InfoHandle hNorInfo)
 {
@@ -284,55 +336,89 @@ void NOR_reset(NOR_InfoHandle hNorInfo)
 // Erase Flash Block
 Uint32 NOR_erase(NOR_InfoHandle hNorInfo, VUint32 start_address, VUint32 size)
 {
-  Uint32 i;
-	VUint32 addr  = start_address;
-	VUint32 range = start_address + size;
-	Uint32 blockSize, blockAddr;
+  Uint32 j;
+  Uint32 blkAddrs[NOR_MAX_ERASE_QUEUE], blkSizes[NOR_MAX_ERASE_QUEUE];
+  Uint32 numQueued = 0, numErased;
+  NOR_SectorIterObj iter;
+  Bool moreSectors;
 	
 	DEBUG_printString("Erasing the NOR Flash\r\n");
 	
-  while (addr < range)
+  if (NOR_sectorIterInit(hNorInfo, start_address, size, &iter) != E_PASS)
+  {
+    DEBUG_printString("Address out of range");
+    return E_FAIL;
+  }
+
+  hNorInfo->sectorsErased  = 0;
+  hNorInfo->sectorsSkipped = 0;
+  NOR_reset(hNorInfo);  // Put NOR into read mode for the blank checks
+
+  moreSectors = NOR_sectorIterNext(hNorInfo, &iter);
+  while (moreSectors || (numQueued > 0))
   {
-    if (NOR_getBlockInfo(hNorInfo, addr, &blockSize, &blockAddr) != E_PASS)
+    // Hand the chip as many sectors as it will take in one erase operation
+    while (moreSectors && (numQueued < NOR_MAX_ERASE_QUEUE))
     {
-      DEBUG_printString("Address out of range");
-      return E_FAIL;
+      if ( (hNorInfo->options & NOR_OPT_BLANK_SKIP) && LOCAL_isBlank(iter.blockAddr, iter.blockSize) )
+      {
+        hNorInfo->sectorsSkipped++;
+      }
+      else
+      {
+        blkAddrs[numQueued] = iter.blockAddr;
+        blkSizes[numQueued] = iter.blockSize;
+        numQueued++;
+      }
+      moreSectors = NOR_sectorIterNext(hNorInfo, &iter);
     }
-		
-		//Increment to the next block
-    if ((*(hNorInfo->hNorFxns->erase))(hNorInfo, blockAddr) != E_PASS)
-//    if ( (*Flash_Erase)(hNorInfo, blockAddr) != E_PASS)
+
+    // Everything left was blank
+    if (numQueued == 0)
+      break;
+
+    numErased = numQueued;
+    if ((*(hNorInfo->hNorFxns->multiErase))(hNorInfo, blkAddrs, &numErased) != E_PASS)
     {
       DEBUG_printString("Erase failure at block address ");
-      DEBUG_printHexInt(blockAddr);
+      DEBUG_printHexInt(blkAddrs[0]);
       DEBUG_printString("\r\n");
       return E_FAIL;
     }
     
     // Verify erase was correct
     NOR_reset(hNorInfo);  // Put NOR into read mode
-    for (i=0; i< blockSize; i+=4)
+    for (j=0; j<numErased; j++)
     {
-      if ( *((Uint32 *)(addr+i)) != 0xFFFFFFFF)
+      if (!LOCAL_isBlank(blkAddrs[j], blkSizes[j]))
       {
-        DEBUG_printString("Erase failure at address ");
-        DEBUG_printHexInt((addr+i));
+        DEBUG_printString("Erase failure in block at address ");
+        DEBUG_printHexInt(blkAddrs[j]);
         DEBUG_printString(".\r\n");
         return E_FAIL;
       }
     }
-    
-    
-    addr = blockAddr + blockSize;
+    hNorInfo->sectorsErased += numErased;
 	    
     // Show status messages
     DEBUG_printString("Erased through ");
-    DEBUG_printHexInt(addr);
+    DEBUG_printHexInt(blkAddrs[numErased-1] + blkSizes[numErased-1]);
     DEBUG_printString("\r\n");
 
+    // Keep the sectors the chip did not accept for the next operation
+    for (j=numErased; j<numQueued; j++)
+    {
+      blkAddrs[j-numErased] = blkAddrs[j];
+      blkSizes[j-numErased] = blkSizes[j];
+    }
+    numQueued -= numErased;
   }
 
-  DEBUG_printString("Erase Completed\r\n");
+  DEBUG_printString("Erase Completed (");
+  DEBUG_printHexInt(hNorInfo->sectorsErased);
+  DEBUG_printString(" sectors erased, ");
+  DEBUG_printHexInt(hNorInfo->sectorsSkipped);
+  DEBUG_printString(" already blank)\r\n");
 
   return(E_PASS);
 }
@@ -341,8 +427,9 @@ Uint32 NOR_erase(NOR_InfoHandle hNorInfo, VUint32 start_address, VUint32 size)
 Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numBytes, Uint32 readAddress)
 {
   Uint32  blockSize, blockAddr;
-  Int32   i;
   Uint32  retval = E_PASS;
+  Uint32  startWrite, startRead, totalBytes, chunk, toBoundary;
+  Bool    inReadMode;
 
   DEBUG_printString("Writing the NOR Flash\r\n");
 
@@ -358,10 +445,54 @@ Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numB
     return E_FAIL;
   }
 
+  startWrite = writeAddress;
+  startRead  = readAddress;
+  totalBytes = numBytes;
+  hNorInfo->bytesProgrammed = 0;
+  hNorInfo->bytesSkipped    = 0;
+  NOR_reset(hNorInfo);  // Put NOR into read mode for the blank checks
+  inReadMode = TRUE;
+
   while (numBytes > 0)
   {
-    if(  (hNorInfo->bufferSize == 1) || (numBytes < hNorInfo->bufferSize) || (writeAddress & (hNorInfo->bufferSize-1)) )
+    // Word writes up to the first buffer boundary, whole buffers after
+    // that, and a partial buffer for whatever is left at the end
+    toBoundary = hNorInfo->bufferSize - (writeAddress & (hNorInfo->bufferSize-1));
+    if ( (hNorInfo->bufferSize <= hNorInfo->busWidth) || (toBoundary != hNorInfo->bufferSize) )
+      chunk = hNorInfo->busWidth;
+    else if (numBytes < hNorInfo->bufferSize)
+      chunk = numBytes;
+    else
+      chunk = hNorInfo->bufferSize;
+
+    if ( (hNorInfo->options & NOR_OPT_BLANK_SKIP) && LOCAL_isBlank(readAddress, chunk) )
+    {
+      // Programming 0xFF changes nothing, the flash just has to be erased there.
+      // After a program operation a reset gets the chip out of status/bypass
+      // mode for the read; runs of blank chunks need only the one.
+      if ( (!(hNorInfo->options & NOR_OPT_VERIFY_CRC)) && (!inReadMode) )
+      {
+        NOR_reset(hNorInfo);
+        inReadMode = TRUE;
+      }
+      if ( (!(hNorInfo->options & NOR_OPT_VERIFY_CRC)) && (!LOCAL_isBlank(writeAddress, chunk)) )
+      {
+        DEBUG_printString("\r\nFlash not erased at ");
+        DEBUG_printHexInt(writeAddress);
+        DEBUG_printString(".\r\n");
+        retval = E_FAIL;
+      }
+      else
+      {
+        hNorInfo->bytesSkipped += chunk;
+        numBytes     -= chunk;
+        writeAddress += chunk;
+        readAddress  += chunk;
+      }
+    }
+    else if (chunk == hNorInfo->busWidth)
     {
+      inReadMode = FALSE;
       if ((*(hNorInfo->hNorFxns->write))(hNorInfo, writeAddress, LOCAL_flashReadData(hNorInfo,readAddress,0) ) != E_PASS)
 //      if ((*Flash_Write)(hNorInfo, writeAddress, LOCAL_flashReadData(hNorInfo,readAddress,0) ) != E_PASS)
       {
@@ -370,6 +501,7 @@ Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numB
       }
       else
       {
+        hNorInfo->bytesProgrammed += hNorInfo->busWidth;
         numBytes     -= hNorInfo->busWidth;
         writeAddress += hNorInfo->busWidth;
         readAddress  += hNorInfo->busWidth;
@@ -378,18 +510,20 @@ Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numB
     else
     {
       // Try to use buffered writes
-      if((*(hNorInfo->hNorFxns->bufferWrite))(hNorInfo, writeAddress, (VUint8 *)readAddress, hNorInfo->bufferSize) == E_PASS)
+      inReadMode = FALSE;
+      if((*(hNorInfo->hNorFxns->bufferWrite))(hNorInfo, writeAddress, (VUint8 *)readAddress, chunk) == E_PASS)
 //      if((*Flash_BufferWrite)(hNorInfo, writeAddress, (VUint8 *)readAddress, hNorInfo->bufferSize) == E_PASS)
       {
-        numBytes -= hNorInfo->bufferSize;
-        writeAddress += hNorInfo->bufferSize;
-        readAddress  += hNorInfo->bufferSize;
+        hNorInfo->bytesProgrammed += chunk;
+        numBytes -= chunk;
+        writeAddress += chunk;
+        readAddress  += chunk;
       }
       else
       {
         DEBUG_printString("\r\nBuffered write failed. Trying normal write\r\n");
         // Try normal writes as a backup
-        for(i = 0; i<(hNorInfo->bufferSize>>1); i++)
+        for(; chunk > 0; chunk -= hNorInfo->busWidth)
         {
           if ((*(hNorInfo->hNorFxns->write))(hNorInfo, writeAddress, LOCAL_flashReadData(hNorInfo,readAddress,0) ) != E_PASS)
 //          if ((*Flash_Write)(hNorInfo, writeAddress, LOCAL_flashReadData(hNorInfo,readAddress,0) ) != E_PASS)
@@ -400,6 +534,7 @@ Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numB
           }
           else
           {
+            hNorInfo->bytesProgrammed += hNorInfo->busWidth;
             numBytes     -= hNorInfo->busWidth;
             writeAddress += hNorInfo->busWidth;
             readAddress  += hNorInfo->busWidth;
@@ -420,6 +555,7 @@ Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numB
         if (NOR_getBlockInfo(hNorInfo, writeAddress, &blockSize, &blockAddr) != E_PASS)
         {
           DEBUG_printString("Address out of range");
+          NOR_reset(hNorInfo);
           return E_FAIL;
         }
       }
@@ -427,9 +563,28 @@ Uint32 NOR_writeBytes( NOR_InfoHandle hNorInfo, Uint32 writeAddress, Uint32 numB
     else
     {
       DEBUG_printString( "NOR Write Failed...Aborting!\r\n");
+      NOR_reset(hNorInfo);
       return E_FAIL;
     }
   }
+
+  // Leave any program mode the writes used (e.g. AMD unlock bypass)
+  NOR_reset(hNorInfo);
+
+  // Check the whole range in one pass if the per-buffer compares were skipped
+  if (hNorInfo->options & NOR_OPT_VERIFY_CRC)
+  {
+    retval = LOCAL_flashVerifyCRC(hNorInfo, startWrite, startRead, totalBytes);
+    if (retval != E_PASS)
+      DEBUG_printString("CRC verify failed.\r\n");
+  }
+
+  DEBUG_printString("Programmed ");
+  DEBUG_printHexInt(hNorInfo->bytesProgrammed);
+  DEBUG_printString(" bytes, skipped ");
+  DEBUG_printHexInt(hNorInfo->bytesSkipped);
+  DEBUG_printString(" blank bytes.\r\n");
+
   return retval;
 }
 
@@ -489,7 +644,6 @@ static void LOCAL_flashWriteData(NOR_InfoHandle hNorInfo, Uint32 address, Uint32
   }
 }
 
-/* Used only once */
 static Uint32 LOCAL_flashVerifyDataBuffer(NOR_InfoHandle hNorInfo, Uint32 address, void* data, Uint32 numBytes)
 {
   volatile NOR_Ptr pAddr, pData;
@@ -498,6 +652,17 @@ static Uint32 LOCAL_flashVerifyDataBuffer(NOR_InfoHandle hNorInfo, Uint32 addres
   pData.cp = (VUint8*) data;
   pAddr.cp = (VUint8*) address;
   endAddress =(VUint8*)(address+numBytes);
+
+  // Compare whole words while both sides are word aligned (array reads only)
+  if ( ((address | ((Uint32)data)) & 0x3) == 0 )
+  {
+    while ((pAddr.cp + 4) <= endAddress)
+    {
+      if ( (*pAddr.lp++) != (*pData.lp++) )
+        return E_FAIL;
+    }
+  }
+
   while (pAddr.cp < endAddress)
   {
     switch (hNorInfo->busWidth)
@@ -515,6 +680,57 @@ static Uint32 LOCAL_flashVerifyDataBuffer(NOR_InfoHandle hNorInfo, Uint32 addres
   return E_PASS;
 }
 
+// Compare the CRC-32 of a flash range with that of the source data
+static Uint32 LOCAL_flashVerifyCRC(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 readAddress, Uint32 numBytes)
+{
+  if (hNorInfo->crcTable == NULL)
+  {
+    hNorInfo->crcTable = (Uint32 *) UTIL_allocMem(256 * sizeof(Uint32));
+    UTIL_buildCRC32Table(hNorInfo->crcTable, 0x04C11DB7);
+  }
+
+  hNorInfo->verifyCRC = UTIL_calcCRC32(hNorInfo->crcTable, (Uint8 *) readAddress, numBytes, 0);
+  if (UTIL_calcCRC32(hNorInfo->crcTable, (Uint8 *) address, numBytes, 0) != hNorInfo->verifyCRC)
+    return E_FAIL;
+
+  return E_PASS;
+}
+
+// Check that memory (or NOR in read array mode) is all 0xFF
+static Bool LOCAL_isBlank(Uint32 address, Uint32 numBytes)
+{
+  VUint8 *pByte = (VUint8 *) address;
+  VUint32 *pWord;
+
+  // Leading bytes up to a word boundary
+  while ((numBytes > 0) && (((Uint32)pByte) & 0x3))
+  {
+    if (*pByte++ != 0xFF)
+      return FALSE;
+    numBytes--;
+  }
+
+  // Whole words
+  pWord = (VUint32 *) pByte;
+  while (numBytes >= 4)
+  {
+    if (*pWord++ != 0xFFFFFFFF)
+      return FALSE;
+    numBytes -= 4;
+  }
+
+  // Trailing bytes
+  pByte = (VUint8 *) pWord;
+  while (numBytes > 0)
+  {
+    if (*pByte++ != 0xFF)
+      return FALSE;
+    numBytes--;
+  }
+
+  return TRUE;
+}
+
 static Uint32 LOCAL_flashReadData(NOR_InfoHandle hNorInfo, Uint32 address, Uint32 offset)
 {
   volatile NOR_Ptr pAddr;
@@ -652,9 +868,9 @@ static Uint32 LOCAL_flashQueryCFI( NOR_InfoHandle hNorInfo )
       LOCAL_flashCFIIsEqual ( hNorInfo, CFI_Y, 'Y') )
 			{               
         hNorInfo->commandSet = (NOR_CmdSet) (LOCAL_flashReadCFIBytes(hNorInfo,CFI_CMDSET,2).w);
-        hNorInfo->flashSize = 0x1 << LOCAL_flashReadCFIBytes(hNorInfo,CFI_DEVICESIZE,1).c * hNorInfo->numberDevices;
+        hNorInfo->flashSize = (0x1 << LOCAL_flashReadCFIBytes(hNorInfo,CFI_DEVICESIZE,1).c) * hNorInfo->numberDevices;
         hNorInfo->numberRegions = LOCAL_flashReadCFIBytes(hNorInfo,CFI_NUMBLKREGIONS,1).c;
-        hNorInfo->bufferSize = 0x1 << LOCAL_flashReadCFIBytes(hNorInfo,CFI_WRITESIZE,2).w * hNorInfo->numberDevices;
+        hNorInfo->bufferSize = (0x1 << LOCAL_flashReadCFIBytes(hNorInfo,CFI_WRITESIZE,2).w) * hNorInfo->numberDevices;
                 
         // Get info on sector sizes in each erase region of device
         for (i = 0;i < hNorInfo->numberRegions; i++)
@@ -663,7 +879,10 @@ static Uint32 LOCAL_flashQueryCFI( NOR_InfoHandle hNorInfo )
           hNorInfo->numberBlocks[i] = (blkVal&0x0000FFFF) + 1;
           hNorInfo->blockSize[i]    = ((blkVal&0xFFFF0000) ? ( ((blkVal>>16)&0xFFFF) * 256) : 128) * hNorInfo->numberDevices;
         }
-                
+
+        // Build the lookup table used by NOR_getBlockInfo
+        LOCAL_flashBuildRegionMap(hNorInfo);
+                                
         // Exit CFI mode 
         LOCAL_flashWriteCmd (hNorInfo,hNorInfo->flashBase, 0, CFI_EXIT_CMD);
 			    
@@ -676,6 +895,55 @@ static Uint32 LOCAL_flashQueryCFI( NOR_InfoHandle hNorInfo )
   return E_FAIL;
 }
 
+// Merge neighbouring erase regions with the same block size (uniform parts
+// then have a single region) and record where each region ends
+static void LOCAL_flashBuildRegionMap( NOR_InfoHandle hNorInfo )
+{
+  Uint32 i, j, regionAddr;
+
+  if (hNorInfo->numberRegions > CFI_MAXREGIONS)
+    hNorInfo->numberRegions = CFI_MAXREGIONS;
+
+  for (i = 0, j = 0; i < hNorInfo->numberRegions; i++)
+  {
+    if ((j > 0) && (hNorInfo->blockSize[j-1] == hNorInfo->blockSize[i]))
+    {
+      hNorInfo->numberBlocks[j-1] += hNorInfo->numberBlocks[i];
+    }
+    else
+    {
+      hNorInfo->numberBlocks[j] = hNorInfo->numberBlocks[i];
+      hNorInfo->blockSize[j]    = hNorInfo->blockSize[i];
+      j++;
+    }
+  }
+  hNorInfo->numberRegions = j;
+
+  regionAddr = hNorInfo->flashBase;
+  for (i = 0; i < hNorInfo->numberRegions; i++)
+  {
+    regionAddr += hNorInfo->blockSize[i] * hNorInfo->numberBlocks[i];
+    hNorInfo->regionEnd[i] = regionAddr;
+  }
+
+  // The last region covers anything the CFI table leaves over
+  if (hNorInfo->numberRegions > 0)
+    hNorInfo->regionEnd[hNorInfo->numberRegions - 1] = hNorInfo->flashBase + hNorInfo->flashSize;
+
+  hNorInfo->currRegion = 0;
+}
+
+// Find the erase region holding an in-range address
+static Uint8 LOCAL_flashFindRegion( NOR_InfoHandle hNorInfo, Uint32 address )
+{
+  Uint8 i = 0;
+
+  while ( (i < (hNorInfo->numberRegions - 1)) && (address >= hNorInfo->regionEnd[i]) )
+    i++;
+
+  return i;
+}
+
 
 // ------------------------ Default empty commands ---------------------------
 
@@ -691,6 +959,10 @@ static Uint32 Unsupported_Erase(NOR_InfoHandle hNorInfo, Uint32 address)
 {
   return E_FAIL;
 }
+static Uint32 Unsupported_MultiErase(NOR_InfoHandle hNorInfo, Uint32 blkAddr[], Uint32 *numBlocks)
+{
+  return E_FAIL;
+}
 static Uint32 Unsupported_ID(NOR_InfoHandle hNorInfo)
 {
   return E_FAIL;
@@ -831,6 +1103,13 @@ static Uint32 Intel_Erase(NOR_InfoHandle hNorInfo, VUint32 blkAddr)
 	return retval;
 }
 
+// Intel parts take one block per erase command
+static Uint32 Intel_MultiErase(NOR_InfoHandle hNorInfo, Uint32 blkAddr[], Uint32 *numBlocks)
+{
+  *numBlocks = 1;
+  return Intel_Erase(hNorInfo, blkAddr[0]);
+}
+
 // Write data
 static Uint32 Intel_Write(NOR_InfoHandle hNorInfo, Uint32 address, VUint32 data )
 {
@@ -916,12 +1195,12 @@ static Uint32 Intel_BufferWrite(NOR_InfoHandle hNorInfo, Uint32 address, VUint8
 
     // Put back into Read Array mode.
     Intel_SoftReset(hNorInfo);
-    if (retval == E_PASS)
+    if ((retval == E_PASS) && !(hNorInfo->options & NOR_OPT_VERIFY_CRC))
     {
       retval = LOCAL_flashVerifyDataBuffer(hNorInfo, address, (void*)data, numBytes);
       if (retval != E_PASS)
         DEBUG_printString("Data verify failed.\r\n");
-    }    
+    }        
   }
 
   return retval;
@@ -962,6 +1241,10 @@ static Uint32 AMD_ID( NOR_InfoHandle hNorInfo )
 
 static void AMD_SoftReset(NOR_InfoHandle hNorInfo)
 {
+  // The reset command is ignored in unlock bypass mode
+  if (hNorInfo->unlockBypass)
+    LOCAL_AMDUnlockBypassExit(hNorInfo);
+
 	// Reset Flash to be in Read Array Mode
 	LOCAL_flashWriteCmd(hNorInfo,hNorInfo->flashBase,AMD_CMD2_ADDR,AMD_RESET);
   UTIL_waitLoop(5000);
@@ -974,12 +1257,31 @@ static void LOCAL_AMDPrefixCommands(NOR_InfoHandle hNorInfo)
   LOCAL_flashWriteCmd(hNorInfo, hNorInfo->flashBase, AMD_CMD1_ADDR, AMD_CMD1);
 }
 
+// Enter unlock bypass mode, where programming needs no unlock cycles
+static void LOCAL_AMDUnlockBypassEnter(NOR_InfoHandle hNorInfo)
+{
+  LOCAL_AMDPrefixCommands(hNorInfo);
+  LOCAL_flashWriteCmd(hNorInfo, hNorInfo->flashBase, AMD_CMD2_ADDR, AMD_UNLOCK_BYPASS_CMD);
+  hNorInfo->unlockBypass = TRUE;
+}
+
+// Leave unlock bypass mode, back to read array mode
+static void LOCAL_AMDUnlockBypassExit(NOR_InfoHandle hNorInfo)
+{
+  LOCAL_flashWriteCmd(hNorInfo, hNorInfo->flashBase, 0, AMD_UNLOCK_BYPASS_RST_CMD0);
+  LOCAL_flashWriteCmd(hNorInfo, hNorInfo->flashBase, 0, AMD_UNLOCK_BYPASS_RST_CMD1);
+  hNorInfo->unlockBypass = FALSE;
+}
+
 // Erase Block
 static Uint32 AMD_Erase(NOR_InfoHandle hNorInfo, Uint32 blkAddr)
 {
   Uint32 retval = E_PASS;
   Uint32 cnt = 0;
 
+  if (hNorInfo->unlockBypass)
+    LOCAL_AMDUnlockBypassExit(hNorInfo);
+
   // Send commands
   LOCAL_AMDPrefixCommands(hNorInfo);
   LOCAL_flashWriteCmd(hNorInfo,hNorInfo->flashBase, AMD_CMD2_ADDR, AMD_BLK_ERASE_SETUP_CMD);
@@ -1004,13 +1306,66 @@ static Uint32 AMD_Erase(NOR_InfoHandle hNorInfo, Uint32 blkAddr)
   return retval;
 }
 
+// Erase several blocks in one operation.  Extra sector addresses are accepted
+// until the erase timeout window closes (DQ3 set); numBlocks returns how many
+// of the blocks were actually erased.
+static Uint32 AMD_MultiErase(NOR_InfoHandle hNorInfo, Uint32 blkAddr[], Uint32 *numBlocks)
+{
+  Uint32 retval = E_PASS;
+  Uint32 i;
+
+  if (hNorInfo->unlockBypass)
+    LOCAL_AMDUnlockBypassExit(hNorInfo);
+
+  // Send commands for the first sector
+  LOCAL_AMDPrefixCommands(hNorInfo);
+  LOCAL_flashWriteCmd(hNorInfo,hNorInfo->flashBase, AMD_CMD2_ADDR, AMD_BLK_ERASE_SETUP_CMD);
+  LOCAL_AMDPrefixCommands(hNorInfo);
+  LOCAL_flashWriteCmd(hNorInfo,blkAddr[0], 0x0, AMD_BLK_ERASE_CMD);
+
+  // Queue the rest while the window is open.  If DQ3 is set straight after
+  // a sector command the command may have been ignored, so leave that
+  // sector for the next operation.
+  for (i = 1; i < *numBlocks; i++)
+  {
+    if (LOCAL_flashIsSetSome(hNorInfo, blkAddr[0], 0, BIT3))
+      break;
+    LOCAL_flashWriteCmd(hNorInfo,blkAddr[i], 0x0, AMD_BLK_ERASE_CMD);
+    if (LOCAL_flashIsSetSome(hNorInfo, blkAddr[0], 0, BIT3))
+      break;
+  }
+  *numBlocks = i;
+
+  // Poll DQ7 and DQ15 for status
+  while ( !LOCAL_flashIsSetAll(hNorInfo,blkAddr[0], 0, BIT7) );
+
+  UTIL_waitLoop(1000);
+
+  // Check data
+  for (i = 0; i < *numBlocks; i++)
+  {
+    if ( !LOCAL_flashIsSetAll(hNorInfo, blkAddr[i], 0, AMD_BLK_ERASE_DONE) )
+      retval = E_FAIL;
+  }
+
+  // Flash Mode: Read Array
+  AMD_SoftReset(hNorInfo);
+
+  return retval;
+}
+
 // AMD Flash Write
 static Uint32 AMD_Write(NOR_InfoHandle hNorInfo, Uint32 address, VUint32 data )
 {
   Uint32 retval = E_PASS;
 	
+  // Program in unlock bypass mode, so only the program command is needed
+  // per word.  The mode is left again by the next reset, erase or buffered
+  // write (NOR_writeBytes resets when done).
+  if (!hNorInfo->unlockBypass)
+    LOCAL_AMDUnlockBypassEnter(hNorInfo);
+
   // Send Commands
-  LOCAL_AMDPrefixCommands(hNorInfo);
   LOCAL_flashWriteCmd(hNorInfo,hNorInfo->flashBase, AMD_CMD2_ADDR, AMD_PROG_CMD);
   LOCAL_flashWriteData(hNorInfo,address, data);
 
@@ -1035,9 +1390,10 @@ static Uint32 AMD_Write(NOR_InfoHandle hNorInfo, Uint32 address, VUint32 data )
     }
   }
 	
-  // Return Read Mode
-	AMD_SoftReset(hNorInfo);
-	
+  // The array reads back directly in unlock bypass mode, so only reset on failure
+  if (retval != E_PASS)
+    AMD_SoftReset(hNorInfo);
+		
 	// Verify the data.
   if ( (retval == E_PASS) && ( LOCAL_flashReadData(hNorInfo, address, 0) != data) )
     retval = E_FAIL;
@@ -1056,6 +1412,10 @@ static Uint32 AMD_BufferWrite(NOR_InfoHandle hNorInfo, Uint32 address, VUint8 da
   volatile NOR_Ptr pAddr, pData;
   VUint8* endAddress;
 	
+  // Buffered programming needs the full unlock sequence
+  if (hNorInfo->unlockBypass)
+    LOCAL_AMDUnlockBypassExit(hNorInfo);
+
   // Get block base address and size
   NOR_getBlockInfo(hNorInfo, address, &blkSize, &blkAddress);
 			
@@ -1142,7 +1502,7 @@ static Uint32 AMD_BufferWrite(NOR_InfoHandle hNorInfo, Uint32 address, VUint8 da
 	
   // Put chip back into read array mode.
   AMD_SoftReset(hNorInfo);
-  if (retval == E_PASS)
+  if ((retval == E_PASS) && !(hNorInfo->options & NOR_OPT_VERIFY_CRC))
   {
     retval = LOCAL_flashVerifyDataBuffer(hNorInfo, startAddress,(void*)data, numBytes);
     if (retval != E_PASS)
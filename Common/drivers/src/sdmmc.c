@@ -17,6 +17,9 @@
 // The generic SD/MMC module driver 
 #include "sdmmc.h"
 
+// Device specific SD/MMC info
+#include "device_sdmmc.h"
+
 
 /************************************************************
 * Explicit External Declarations                            *
@@ -32,6 +35,10 @@
 * Local Function Declarations                               *
 ************************************************************/
 static Uint8 Local_SDMMCInitCard(SDMMC_InfoHandle hSDMMCInfo);
+static void Local_SDMMCSetClock(Uint32 clkrt);
+static Uint8 Local_SDMMCSwitchFunc(Uint32 arg, Uint32 *status);
+static Uint8 Local_SDMMCSetHighSpeed(SDMMC_InfoHandle hSDMMCInfo);
+Uint8 SDMMCReadNWords(Uint32 *data, Uint32 numofBytes);
 
 /************************************************************
 * Local Variable Definitions                                *
@@ -166,8 +173,10 @@ Uint8 SDMMCSendCmd(Uint32 command, Uint32 argument, Bool checkStatus) {
    	SDMMC->MMCARGHL = argument;
    	SDMMC->MMCCMD   = command;
   
-   	/*Delay loop allowing cards to respond */
-	UTIL_waitLoop(1000);
+   	/*Delay loop allowing cards to respond (polling covers this when
+   	  the status is checked) */
+   	if (checkStatus != 1)
+		UTIL_waitLoop(1000);
         
    	if (checkStatus == 1) {
 	   	/* Wait for RspDne; exit on RspTimeOut or RspCRCErr
@@ -447,16 +456,89 @@ static Uint8 Local_SDMMCInitCard(SDMMC_InfoHandle hSDMMCInfo) {
 	if(status == E_FAIL)
 		return  status;
    
-	if(mmc == FALSE) {
-		SDMMC_Set_BusWidth(hSDMMCInfo->relCardAddress);
+	/* Card is in transfer state, leave the identification clock */
+	Local_SDMMCSetClock(DEVICE_SDMMC_CLKRT_DEFAULT);
+
+	hSDMMCInfo->busWidth4 = FALSE;
+	hSDMMCInfo->highSpeed = FALSE;
+	if( (mmc == FALSE) && (hSDMMCInfo->hSDMMCCfg->busWidth == SDMMC_4BIT_DATABUS) &&
+	    (SDMMC_Set_BusWidth(hSDMMCInfo->relCardAddress) == E_PASS) ) {
 		/* bit no.2 to 1 for 4 bit bus width */
 	  	SDMMC->MMCCTL |= 0x4;
+		hSDMMCInfo->busWidth4 = TRUE;
 	} else {
    		SDMMC->MMCCTL &= 0xFFFFFFFB;
 	}
+
+	/* SD cards from spec 1.10 on can double the clock (older ones reject CMD6) */
+	if( (mmc == FALSE) && (Local_SDMMCSetHighSpeed(hSDMMCInfo) == E_PASS) ) {
+		Local_SDMMCSetClock(DEVICE_SDMMC_CLKRT_HIGHSPEED);
+		hSDMMCInfo->highSpeed = TRUE;
+	}
+
 	return status;
 }
 
+/* Change the MMC_CLK divider, keeping the clock enable and other bits */
+static void Local_SDMMCSetClock(Uint32 clkrt)
+{
+	SDMMC->MMCCLK = (SDMMC->MMCCLK & 0xFF00) | (clkrt & 0xFF);
+}
+
+/* Issue CMD6 and read back its 64 byte status block */
+static Uint8 Local_SDMMCSwitchFunc(Uint32 arg, Uint32 *status)
+{
+	Uint32 timeOut;
+
+	SDMMC->MMCBLEN = SD_SWITCH_STATUS_BYTES;
+	SDMMC->MMCNBLK = 1;
+
+	/* reset the FIFO, set receive direction and the 64 byte level */
+	SDMMC->MMCFIFOCTL |= 0x1;
+	SDMMC->MMCFIFOCTL &= 0xFFFD;
+	SDMMC->MMCFIFOCTL |= 0x0004;
+
+	if(SDMMCSendCmd(0x2000 | SD_SWITCH_FUNC, arg, FALSE) != E_PASS)
+		return E_FAIL;
+
+	if(SDMMCReadNWords(status, SD_SWITCH_STATUS_BYTES) != E_PASS)
+		return E_FAIL;
+
+	timeOut = 3000;
+	while( !(SDMMC->MMCST0 & SDMMC_STAT0_DATDNE) ) {
+		if( --timeOut == 0 )
+			return E_TIMEOUT;
+	}
+
+	return E_PASS;
+}
+
+/* Ask the card whether it supports high speed and, if so, switch to it.
+   The status block arrives MSB first, so byte n of the buffer holds
+   bits (511 - 8n) down to (504 - 8n). */
+static Uint8 Local_SDMMCSetHighSpeed(SDMMC_InfoHandle hSDMMCInfo)
+{
+	Uint32 status[SD_SWITCH_STATUS_BYTES >> 2];
+	Uint8 *statusBytes = (Uint8 *) status;
+
+	/* Bits 415:400 list the group 1 functions supported, bit 401 is high speed */
+	if(Local_SDMMCSwitchFunc(SD_SWITCH_CHECK_HS, status) != E_PASS)
+		return E_FAIL;
+	if( !(statusBytes[13] & 0x02) )
+		return E_FAIL;
+
+	/* Bits 379:376 return the function now selected in group 1 */
+	if(Local_SDMMCSwitchFunc(SD_SWITCH_SET_HS, status) != E_PASS)
+		return E_FAIL;
+	if( (statusBytes[16] & 0x0F) != 0x1 )
+		return E_FAIL;
+
+	/* Card switches timing within 8 clocks of the status block */
+	UTIL_waitLoop(100);
+
+	return E_PASS;
+}
+
 
 /**
     Read N words from the MMC Controller Register
@@ -507,18 +589,17 @@ Uint8 SDMMCSingleBlkRead( SDMMC_InfoHandle hSDMMCInfo, Uint32 cardMemAddr, Uint3
   /*Set the FIFO level 32 bytes (256 bit) always */
   SDMMC->MMCFIFOCTL |= 0x0004;
  
-  status = SDMMCSendCmd(SDMMC_SET_BLOCKLEN, blkLength, FALSE);
+  status = SDMMCSendCmd(SDMMC_SET_BLOCKLEN, blkLength, TRUE);
   if(status != E_PASS)
   	return	E_FAIL;
       
   SDMMCClearResponse();
 
-  UTIL_waitLoop(100000);
     /* Set the blocklength and size of the block in bytes */
   if(blkLength == 0)
     return E_FAIL;
 
-  SDMMC->MMCBLEN |= (Uint16)(blkLength&0xFFF);
+  SDMMC->MMCBLEN = (Uint16)(blkLength&0xFFF);
   SDMMC->MMCNBLK =  1;
 
     /* reset the FIFO  */
@@ -571,7 +652,7 @@ Uint8 SDMMCMultipleBlkRead( SDMMC_InfoHandle hSDMMCInfo, Uint32 cardMemAddr, Uin
 
   /*Set the FIFO level 32 bytes (256 bit) always */
   SDMMC->MMCFIFOCTL |= 0x0004;
-  status = SDMMCSendCmd(SDMMC_SET_BLOCKLEN, 512, FALSE);
+  status = SDMMCSendCmd(SDMMC_SET_BLOCKLEN, 512, TRUE);
   if(status != E_PASS)
   	return	E_FAIL;
      
@@ -581,12 +662,11 @@ Uint8 SDMMCMultipleBlkRead( SDMMC_InfoHandle hSDMMCInfo, Uint32 cardMemAddr, Uin
   /* To find the Number of blocks to be read in terms of 512 Bytes */
   numBlks = dataLength >> hSDMMCInfo->dataBytesPerBlkPower2;
 
-  SDMMC->MMCBLEN |= hSDMMCInfo->dataBytesPerBlk;
+  SDMMC->MMCBLEN = hSDMMCInfo->dataBytesPerBlk;
   SDMMC->MMCNBLK =  numBlks;
 
     /* reset the FIFO  */
   SDMMC->MMCFIFOCTL |= 0x1;
-  UTIL_waitLoop(100000);
   /* Set the Transfer direction from the FIFO as receive*/
   SDMMC->MMCFIFOCTL &= 0xFFFD;
 
@@ -608,8 +688,6 @@ Uint8 SDMMCMultipleBlkRead( SDMMC_InfoHandle hSDMMCInfo, Uint32 cardMemAddr, Uin
   if(status !=E_PASS)
 	 return E_FAIL; 
 
-  /*Delay needed for safety */
-  UTIL_waitLoop(10000); 
   timeOut = 50000;
   do {
 	if(SDMMC->MMCST0 & SDMMC_STAT0_DATDNE) {
@@ -111,44 +111,82 @@ Uint32 SPI_reset(SPI_InfoHandle hSPIInfo)
 
 Uint32 SPI_readBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *dest)
 {
-  Uint32 i;
+  return SPI_xferBytes(hSPIInfo, byteCnt, NULL, dest);
+}
+
+Uint32 SPI_writeBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *src)
+{
+  return SPI_xferBytes(hSPIInfo, byteCnt, src, NULL);
+}
+
+// Full duplex block transfer. A NULL src clocks out zeros and a NULL dest
+// discards what comes back. The next character is loaded into SPIDAT0 as
+// soon as the TX buffer frees up, so the shifter never idles waiting on
+// the RX handshake of the previous character. At most two characters are
+// in flight (TX buffer plus shift register), which the RX side can always
+// drain before it overruns.
+Uint32 SPI_xferBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *src, Uint8 *dest)
+{
+  DEVICE_SPIRegs *SPI = (DEVICE_SPIRegs *) hSPIInfo->regs;
+  Uint32 mask = (0x1 << hSPIInfo->config->charLen) - 1;
+  Uint32 charCnt, txCnt = 0, rxCnt = 0;
+  Uint32 spiflg, spibuf, dataOut;
+  Bool wide;
 
   if (hSPIInfo->config->charLen == 16)
   {
-    Uint16 *tempDest = (Uint16 *) dest;
-    for (i=0; i< (byteCnt>>1); i++)
-    {
-      tempDest[i] = SPI_xferOneChar(hSPIInfo,0x0000);
-    }
+    wide = TRUE;
+    charCnt = byteCnt >> 1;
   }
   else if (hSPIInfo->config->charLen == 8)
   {
-    for (i=0; i< byteCnt; i++)
-    {
-      dest[i] = SPI_xferOneChar(hSPIInfo,0x00);
-    }
+    wide = FALSE;
+    charCnt = byteCnt;
+  }
+  else
+  {
+    return E_FAIL;
   }
 
-  return E_PASS;
-}
-
-Uint32 SPI_writeBytes(SPI_InfoHandle hSPIInfo, Uint32 byteCnt, Uint8 *src)
-{
-  Uint32 i;
+  // Drop anything left over in the receive buffer
+  spibuf = SPI->SPIBUF;
 
-  if (hSPIInfo->config->charLen == 16)
+  while (rxCnt < charCnt)
   {
-    Uint16 *tempSrc = (Uint16 *) src;
-    for (i=0; i< (byteCnt>>1); i++)
+    spiflg = SPI->SPIFLG;
+
+    if ( (txCnt < charCnt) && ((txCnt - rxCnt) < 2) && (spiflg & SPI_TXINTFLAG) )
     {
-      SPI_xferOneChar(hSPIInfo,tempSrc[i]);
+      if (src == NULL)
+        dataOut = 0x0;
+      else if (wide)
+        dataOut = ((Uint16 *) src)[txCnt];
+      else
+        dataOut = src[txCnt];
+      SPI->SPIDAT0 = dataOut & mask;
+      txCnt++;
     }
-  }
-  else if (hSPIInfo->config->charLen == 8)
-  {
-    for (i=0; i< byteCnt; i++)
+
+    if (spiflg & SPI_RXINTFLAG)
     {
-      SPI_xferOneChar(hSPIInfo,src[i]);
+      spibuf = (SPI->SPIBUF) & mask;
+      if (dest != NULL)
+      {
+        if (wide)
+          ((Uint16 *) dest)[rxCnt] = (Uint16) spibuf;
+        else
+          dest[rxCnt] = (Uint8) spibuf;
+      }
+      rxCnt++;
+    }
+    else if (spiflg & SPI_OVRNINTFLG)
+    {
+      SPI->SPIFLG &= SPI_OVRNINTFLG;
+      return E_FAIL;
+    }
+    else if (spiflg & SPI_BITERRFLG)
+    {
+      return E_FAIL;
     }
   }
 
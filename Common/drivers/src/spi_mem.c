@@ -30,6 +30,26 @@
 * Local Macro Declarations                                  *
 ************************************************************/
 
+// Erase capabilities for the ID table fallback
+#define SPI_MEM_ERASE_4K    (0x1)
+#define SPI_MEM_ERASE_32K   (0x2)
+#define SPI_MEM_ERASE_64K   (0x4)
+
+
+/************************************************************
+* Local Typedef Declarations                                *
+************************************************************/
+
+// Parts without SFDP are matched by manufacturer (and memory type, where
+// one vendor has families with different erase sets)
+typedef struct _SPI_MEM_ID_ENTRY_
+{
+  Uint8 manfID;
+  Uint8 memType;      // 0x00 matches any
+  Uint8 eraseCaps;
+}
+SPI_MemIDEntry;
+
 
 /************************************************************
 * Local Function Declarations                               *
@@ -38,11 +58,35 @@
 static void LOCAL_xferAddrBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr);
 static void LOCAL_readDataBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 byteCnt, Uint8 *data);
 static void LOCAL_writeDataBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 byteCnt, Uint8 *data);
+#ifndef USE_IN_ROM
+static Uint32 LOCAL_writePage(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *src);
+static Uint32 LOCAL_writeEnable(SPI_MemInfoHandle hSPIMemInfo);
+static Uint32 LOCAL_waitWhileBusy(SPI_MemInfoHandle hSPIMemInfo, Uint32 timeout);
+static Uint32 LOCAL_eraseUnit(SPI_MemInfoHandle hSPIMemInfo, Uint8 cmd, Uint32 addr);
+#endif
+static Uint32 LOCAL_readSFDP(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *dest);
+static Uint32 LOCAL_getSFDPGeometry(SPI_MemInfoHandle hSPIMemInfo);
+static Uint32 LOCAL_getTableGeometry(SPI_MemInfoHandle hSPIMemInfo);
+static void LOCAL_addEraseType(SPI_MemInfoHandle hSPIMemInfo, Uint32 size, Uint8 cmd);
 
 /************************************************************
 * Local Variable Definitions                                *
 ************************************************************/
 
+static const SPI_MemIDEntry LOCAL_idTable[] =
+{
+  { 0x20, 0x20, SPI_MEM_ERASE_64K },                                        // ST/Numonyx M25P
+  { 0x20, 0x71, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_64K },                     // Numonyx M25PX
+  { 0x20, 0x00, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_64K },                     // Numonyx/Micron N25Q, M25PE
+  { 0x01, 0x02, SPI_MEM_ERASE_64K },                                        // Spansion S25FL-A
+  { 0x01, 0x00, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_64K },                     // Spansion S25FL-K/P
+  { 0xEF, 0x00, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_32K | SPI_MEM_ERASE_64K }, // Winbond W25X/W25Q
+  { 0xC2, 0x00, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_64K },                     // Macronix MX25L
+  { 0xBF, 0x00, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_32K | SPI_MEM_ERASE_64K }, // SST SST25VF
+  { 0x1F, 0x00, SPI_MEM_ERASE_4K | SPI_MEM_ERASE_32K | SPI_MEM_ERASE_64K }, // Atmel AT25DF
+  { 0x00, 0x00, SPI_MEM_ERASE_64K }                                         // End of table/default
+};
+
 
 /************************************************************
 * Global Variable Definitions                               *
@@ -61,7 +105,6 @@ SPI_MemInfoObj gSPIMemInfo;
 SPI_MemInfoHandle SPI_MEM_open(Uint32 spiPeripheralNum)
 {
   Uint8 spibuf;
-  SPI_Config spiCfg;
   SPI_MemInfoHandle hSPIMemInfo;
   
      
@@ -71,33 +114,36 @@ SPI_MemInfoHandle SPI_MEM_open(Uint32 spiPeripheralNum)
   hSPIMemInfo = (SPI_MemInfoHandle) UTIL_allocMem(sizeof(SPI_MemInfoObj));
 #endif
 
-  // Transfer 8 bits at a time
-  spiCfg.charLen = 8;
+  // Transfer 8 bits at a time (the config lives in the info object since
+  // the SPI driver keeps a pointer to it)
+  hSPIMemInfo->spiCfg.charLen = 8;
   
   // Use industry standard mode 3 (note that our SPI peripheral phase value is
   // inverted compared to all other industry players)
-  spiCfg.phase = 0;
-  spiCfg.polarity = 1;
-  spiCfg.prescalar = 79;
+  hSPIMemInfo->spiCfg.phase = 0;
+  hSPIMemInfo->spiCfg.polarity = 1;
+  hSPIMemInfo->spiCfg.prescalar = 79;
 
   hSPIMemInfo->hSPIInfo = SPI_open(spiPeripheralNum,
     SPI_ROLE_MASTER,
     SPI_MODE_3PIN,
-    &spiCfg);
+    &hSPIMemInfo->spiCfg);
+  if (hSPIMemInfo->hSPIInfo == NULL)
+    return NULL;
 
   
   // Assert chip select
   SPI_enableCS(hSPIMemInfo->hSPIInfo);
 
   // Send memory read command
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_READ);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_READ);
 
   // Send 8-bit adresss, receive dummy
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
 
   // Receive data from 8-bit device OR
   // Transmit next part of 16-bit address and receive dummy
-  spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+  spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
 
   // Check for 8-bit memory
   if (spibuf != 0x00)
@@ -106,7 +152,7 @@ SPI_MemInfoHandle SPI_MEM_open(Uint32 spiPeripheralNum)
   {
     // Receive data from 16-bit device OR
     // Transmit next part of 24-bit address and receive dummy
-    spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+    spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
 
     // Check for 16-bit memory
     if (spibuf != 0x00)
@@ -115,7 +161,7 @@ SPI_MemInfoHandle SPI_MEM_open(Uint32 spiPeripheralNum)
     {
       // Receive data from 24-bit device OR
       // Transmit dummy
-      spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+      spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
 
       // Check for 24-bit memory
       if (spibuf != 0x00)
@@ -137,20 +183,24 @@ SPI_MemInfoHandle SPI_MEM_open(Uint32 spiPeripheralNum)
   SPI_enableCS(hSPIMemInfo->hSPIInfo);
 
   // Send memory read command
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_JEDEC_ID);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_JEDEC_ID);
 
   // Send dummy data, receive manufacture ID
-  spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+  spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
 
+  hSPIMemInfo->manfID = spibuf;
+  hSPIMemInfo->devID = 0;
   if (spibuf != 0x00)
   {
     hSPIMemInfo->memType = SPI_MEM_TYPE_FLASH;
     
-    // Send dummy data, receive devicd ID1
-    spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+    // Send dummy data, receive memory type
+    spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
+    hSPIMemInfo->devID = spibuf << 8;
 
-    // Send dummy data, receive manufacture ID
-    spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+    // Send dummy data, receive capacity
+    spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
+    hSPIMemInfo->devID |= spibuf;
   }
   else
   {
@@ -159,6 +209,20 @@ SPI_MemInfoHandle SPI_MEM_open(Uint32 spiPeripheralNum)
 
   SPI_disableCS(hSPIMemInfo->hSPIInfo);
 
+  // Find the size and erase granularities of flash parts
+  hSPIMemInfo->memorySize = 0;
+  hSPIMemInfo->eraseTypeCnt = 0;
+  if (hSPIMemInfo->memType == SPI_MEM_TYPE_FLASH)
+  {
+    if (LOCAL_getSFDPGeometry(hSPIMemInfo) != E_PASS)
+      LOCAL_getTableGeometry(hSPIMemInfo);
+  }
+
+  if (hSPIMemInfo->memType == SPI_MEM_TYPE_FLASH)
+    hSPIMemInfo->pageSize = SPI_MEM_FLASH_PAGE_SIZE;
+  else
+    hSPIMemInfo->pageSize = SPI_MEM_EEPROM_PAGE_SIZE;
+
   return hSPIMemInfo;
 }
 
@@ -168,7 +232,7 @@ Uint32 SPI_MEM_readBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byte
   SPI_enableCS(hSPIMemInfo->hSPIInfo);
 
   // Send memory read command
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_READ);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_READ);
 
   // Send the address bytes
   LOCAL_xferAddrBytes(hSPIMemInfo,addr);
@@ -186,43 +250,25 @@ Uint32 SPI_MEM_readBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byte
 // This can be used for using this driver as read-only for ROM code
 #ifndef USE_IN_ROM    
 
-// Generic routine to write data to SPI
+// Generic routine to write data to SPI, split at program page boundaries
 Uint32 SPI_MEM_writeBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *src)
 {
-  Uint8 spibuf;
-  
-  // Set WE Latch
-  SPI_enableCS(hSPIMemInfo->hSPIInfo);
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_WREN);
-  SPI_disableCS(hSPIMemInfo->hSPIInfo);
-
-  SPI_enableCS(hSPIMemInfo->hSPIInfo);
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_RDSR);
-  spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_WREN);
-  SPI_disableCS(hSPIMemInfo->hSPIInfo);
-
-  // Verify latch is set and no write is in progress
-  if ((!(spibuf & 0x02)) || (spibuf & 0x01) )
-    return E_FAIL;
+  Uint32 pageCnt;
 
-  SPI_enableCS(hSPIMemInfo->hSPIInfo);
-
-  SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_WRITE);
-
-  LOCAL_xferAddrBytes(hSPIMemInfo,addr);
-
-  LOCAL_writeDataBytes(hSPIMemInfo,byteCnt,src);
+  while (byteCnt > 0)
+  {
+    // Bytes left in the page containing addr
+    pageCnt = hSPIMemInfo->pageSize - (addr & (hSPIMemInfo->pageSize - 1));
+    if (pageCnt > byteCnt)
+      pageCnt = byteCnt;
 
-  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+    if (LOCAL_writePage(hSPIMemInfo, addr, pageCnt, src) != E_PASS)
+      return E_FAIL;
 
-  // Wait until write is complete
-  do
-  {
-    SPI_enableCS(hSPIMemInfo->hSPIInfo);
-    SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_RDSR);
-    spibuf = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_WREN);
-    SPI_disableCS(hSPIMemInfo->hSPIInfo);
-  } while ( spibuf & 0x01 );
+    addr    += pageCnt;
+    src     += pageCnt;
+    byteCnt -= pageCnt;
+  }
 
   return E_PASS;
 }
@@ -232,7 +278,7 @@ Uint32 SPI_MEM_verifyBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 by
 {
   Uint32 i;
 
-  if (SPI_MEM_readBytes(hSPIMemInfo,addr,byteCnt,dest) != E_PASS);
+  if (SPI_MEM_readBytes(hSPIMemInfo,addr,byteCnt,dest) != E_PASS)
     return E_FAIL;
 
   for (i=0; i<byteCnt; i++)
@@ -243,15 +289,72 @@ Uint32 SPI_MEM_verifyBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 by
   return E_PASS;
 }
 
-// Global Erase NOR Flash
+// Chip erase (EEPROMs need no erase)
 Uint32 SPI_MEM_globalErase(SPI_MemInfoHandle hSPIMemInfo)
 {
-  return E_PASS;
+  if (hSPIMemInfo->memType != SPI_MEM_TYPE_FLASH)
+    return E_PASS;
+
+  if (LOCAL_writeEnable(hSPIMemInfo) != E_PASS)
+    return E_FAIL;
+
+  SPI_enableCS(hSPIMemInfo->hSPIInfo);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_CHIPERASE);
+  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+  return LOCAL_waitWhileBusy(hSPIMemInfo, SPI_MEM_CHIP_ERASE_TIMEOUT);
 }
 
-// NAND Flash erase block function
+// Erase the sectors/blocks making up a byte range. The range must start and
+// end on boundaries of the smallest erase unit, so that nothing outside it
+// is lost. At each address the largest erase unit that is aligned there and
+// ends inside the range is used, since big blocks erase far faster per byte
+// than 4 KB sectors.
 Uint32 SPI_MEM_eraseBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 startAddr, Uint32 byteCnt)
 {  
+  Uint32 addr, endAddr, minSize, i;
+  SPI_MemEraseType *type;
+
+  if ((hSPIMemInfo->memType != SPI_MEM_TYPE_FLASH) || (byteCnt == 0))
+    return E_PASS;
+
+  if (hSPIMemInfo->eraseTypeCnt == 0)
+    return E_FAIL;
+
+  minSize = hSPIMemInfo->eraseTypes[hSPIMemInfo->eraseTypeCnt - 1].size;
+  if ( ((startAddr | byteCnt) & (minSize - 1)) != 0 )
+    return E_FAIL;
+
+  addr    = startAddr;
+  endAddr = startAddr + byteCnt;
+
+  if ((hSPIMemInfo->memorySize != 0) && (endAddr > hSPIMemInfo->memorySize))
+    return E_FAIL;
+
+  // Whole device requested, chip erase is quickest
+  if ((addr == 0) && (endAddr == hSPIMemInfo->memorySize))
+    return SPI_MEM_globalErase(hSPIMemInfo);
+
+  while (addr < endAddr)
+  {
+    // The smallest type always fits since the range is aligned to it
+    type = &hSPIMemInfo->eraseTypes[hSPIMemInfo->eraseTypeCnt - 1];
+    for (i = 0; i < hSPIMemInfo->eraseTypeCnt; i++)
+    {
+      if ( ((addr & (hSPIMemInfo->eraseTypes[i].size - 1)) == 0) &&
+           ((addr + hSPIMemInfo->eraseTypes[i].size) <= endAddr) )
+      {
+        type = &hSPIMemInfo->eraseTypes[i];
+        break;
+      }
+    }
+
+    if (LOCAL_eraseUnit(hSPIMemInfo, type->cmd, addr) != E_PASS)
+      return E_FAIL;
+
+    addr += type->size;
+  }
+
   return E_PASS;
 }
 #endif
@@ -267,28 +370,233 @@ static void LOCAL_xferAddrBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr)
   for (i=0; i<hSPIMemInfo->addrWidth; i+=8)
   {
     Uint8 addrByte = ((addr >> (hSPIMemInfo->addrWidth - i - 8)) & 0xFF);
-    SPI_xferOneByte(hSPIMemInfo->hSPIInfo,addrByte);
+    SPI_xferOneChar(hSPIMemInfo->hSPIInfo,addrByte);
   }
 }
 
 static void LOCAL_writeDataBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 byteCnt, Uint8 *data)
 {
-  Uint32 i;
+  SPI_xferBytes(hSPIMemInfo->hSPIInfo, byteCnt, data, NULL);
+}
+
+static void LOCAL_readDataBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 byteCnt, Uint8 *data)
+{
+  SPI_xferBytes(hSPIMemInfo->hSPIInfo, byteCnt, NULL, data);
+}
+
+#ifndef USE_IN_ROM
+// Program up to one page (the caller keeps the range inside a page)
+static Uint32 LOCAL_writePage(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *src)
+{
+  if (LOCAL_writeEnable(hSPIMemInfo) != E_PASS)
+    return E_FAIL;
 
-  for (i=0; i< byteCnt; i++)
+  SPI_enableCS(hSPIMemInfo->hSPIInfo);
+
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_WRITE);
+
+  LOCAL_xferAddrBytes(hSPIMemInfo,addr);
+
+  LOCAL_writeDataBytes(hSPIMemInfo,byteCnt,src);
+
+  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+  return LOCAL_waitWhileBusy(hSPIMemInfo, SPI_MEM_POLL_TIMEOUT);
+}
+
+// Set the write enable latch and check that it took
+static Uint32 LOCAL_writeEnable(SPI_MemInfoHandle hSPIMemInfo)
+{
+  Uint8 spibuf;
+  
+  SPI_enableCS(hSPIMemInfo->hSPIInfo);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_WREN);
+  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+  SPI_enableCS(hSPIMemInfo->hSPIInfo);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_RDSR);
+  spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
+  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+  // Verify latch is set and no write is in progress
+  if ((!(spibuf & SPI_MEM_STATUS_WEL)) || (spibuf & SPI_MEM_STATUS_BUSY) )
+    return E_FAIL;
+
+  return E_PASS;
+}
+
+static Uint32 LOCAL_eraseUnit(SPI_MemInfoHandle hSPIMemInfo, Uint8 cmd, Uint32 addr)
+{
+  if (LOCAL_writeEnable(hSPIMemInfo) != E_PASS)
+    return E_FAIL;
+
+  SPI_enableCS(hSPIMemInfo->hSPIInfo);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,cmd);
+  LOCAL_xferAddrBytes(hSPIMemInfo,addr);
+  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+  return LOCAL_waitWhileBusy(hSPIMemInfo, SPI_MEM_ERASE_TIMEOUT);
+}
+
+// Poll the status register until the write in progress bit clears. A page
+// program takes on the order of a millisecond, so back off between reads
+// rather than keeping the bus and chip select busy.
+static Uint32 LOCAL_waitWhileBusy(SPI_MemInfoHandle hSPIMemInfo, Uint32 timeout)
+{
+  Uint8 spibuf;
+  Uint32 timeoutCnt = 0;
+
+  do
   {
-    SPI_xferOneByte(hSPIMemInfo->hSPIInfo,data[i]);
+    SPI_enableCS(hSPIMemInfo->hSPIInfo);
+    SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_RDSR);
+    spibuf = SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
+    SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+    if (!(spibuf & SPI_MEM_STATUS_BUSY))
+      return E_PASS;
+
+    UTIL_waitLoopAccurate((Uint32) SPI_MEM_POLL_DELAY);
   }
+  while (++timeoutCnt < timeout);
+
+  return E_TIMEOUT;
 }
+#endif
 
-static void LOCAL_readDataBytes(SPI_MemInfoHandle hSPIMemInfo, Uint32 byteCnt, Uint8 *data)
+// READ SFDP always uses a 3-byte address and one dummy byte
+static Uint32 LOCAL_readSFDP(SPI_MemInfoHandle hSPIMemInfo, Uint32 addr, Uint32 byteCnt, Uint8 *dest)
 {
-  Uint32 i;
+  Uint32 status;
+
+  SPI_enableCS(hSPIMemInfo->hSPIInfo);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,SPI_MEM_CMD_READ_SFDP);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,(addr >> 16) & 0xFF);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,(addr >> 8) & 0xFF);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,addr & 0xFF);
+  SPI_xferOneChar(hSPIMemInfo->hSPIInfo,0x00);
+  status = SPI_xferBytes(hSPIMemInfo->hSPIInfo, byteCnt, NULL, dest);
+  SPI_disableCS(hSPIMemInfo->hSPIInfo);
+
+  return status;
+}
 
-  for (i=0; i< byteCnt; i++)
+// Pull density and erase types from the JEDEC basic flash parameter table
+// (JESD216). Parts without SFDP read back 0xFF or 0x00 and fail the
+// signature check.
+static Uint32 LOCAL_getSFDPGeometry(SPI_MemInfoHandle hSPIMemInfo)
+{
+  Uint8 hdr[16];
+  Uint32 bfpt[9];
+  Uint32 tableAddr, tableLen, density, i;
+  Uint8 *p;
+
+  if (LOCAL_readSFDP(hSPIMemInfo, 0, 16, hdr) != E_PASS)
+    return E_FAIL;
+
+  if ( (hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | (hdr[3] << 24)) != SPI_MEM_SFDP_SIGNATURE )
+    return E_FAIL;
+
+  // First parameter header must be the JEDEC basic table (ID 0x00)
+  if (hdr[8] != 0x00)
+    return E_FAIL;
+  tableLen  = hdr[11];
+  tableAddr = hdr[12] | (hdr[13] << 8) | (hdr[14] << 16);
+  if (tableLen < 2)
+    return E_FAIL;
+  if (tableLen > 9)
+    tableLen = 9;
+
+  if (LOCAL_readSFDP(hSPIMemInfo, tableAddr, tableLen << 2, (Uint8 *) bfpt) != E_PASS)
+    return E_FAIL;
+
+  // Assemble the little endian DWORDs in place
+  for (i = 0; i < tableLen; i++)
   {
-    data[i] = SPI_xferOneByte(hSPIMemInfo->hSPIInfo,0x00);
+    p = (Uint8 *) &bfpt[i];
+    bfpt[i] = p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
   }
+
+  // DWORD 2: density in bits
+  density = bfpt[1];
+  if (density & 0x80000000)
+    hSPIMemInfo->memorySize = ((density & 0x7FFFFFFF) >= 35) ? 0 : (0x1 << ((density & 0x7FFFFFFF) - 3));
+  else
+    hSPIMemInfo->memorySize = (density >> 3) + 1;
+
+  // DWORDs 8 and 9: up to four erase types (size as a power of two)
+  if (tableLen >= 9)
+  {
+    for (i = 0; i < 4; i++)
+    {
+      Uint32 field = (bfpt[7 + (i >> 1)] >> ((i & 0x1) << 4)) & 0xFFFF;
+      if (((field & 0xFF) != 0) && ((field & 0xFF) < 32))
+        LOCAL_addEraseType(hSPIMemInfo, 0x1 << (field & 0xFF), (field >> 8) & 0xFF);
+    }
+  }
+
+  // JESD216 rev 0 tables only describe the 4 KB erase (DWORD 1)
+  if ( (hSPIMemInfo->eraseTypeCnt == 0) && ((bfpt[0] & 0x3) == 0x1) )
+    LOCAL_addEraseType(hSPIMemInfo, 4096, (bfpt[0] >> 8) & 0xFF);
+
+  // A block erase is always there even if the table doesn't say so
+  if ((hSPIMemInfo->eraseTypeCnt == 0) || (hSPIMemInfo->eraseTypes[0].size < 65536))
+    LOCAL_addEraseType(hSPIMemInfo, 65536, SPI_MEM_CMD_BLOCKERASE);
+
+  return E_PASS;
+}
+
+// Fall back on the JEDEC ID: capacity byte is log2 of the size in bytes
+// for the vendors listed, erase sets come from the table
+static Uint32 LOCAL_getTableGeometry(SPI_MemInfoHandle hSPIMemInfo)
+{
+  const SPI_MemIDEntry *entry = LOCAL_idTable;
+  Uint8 memType  = (hSPIMemInfo->devID >> 8) & 0xFF;
+  Uint8 capacity = hSPIMemInfo->devID & 0xFF;
+
+  while (entry->manfID != 0x00)
+  {
+    if ( (entry->manfID == hSPIMemInfo->manfID) &&
+         ((entry->memType == 0x00) || (entry->memType == memType)) )
+      break;
+    entry++;
+  }
+
+  if ((capacity >= 0x10) && (capacity <= 0x1F))
+    hSPIMemInfo->memorySize = 0x1 << capacity;
+
+  if (entry->eraseCaps & SPI_MEM_ERASE_64K)
+    LOCAL_addEraseType(hSPIMemInfo, 65536, SPI_MEM_CMD_BLOCKERASE);
+  if (entry->eraseCaps & SPI_MEM_ERASE_32K)
+    LOCAL_addEraseType(hSPIMemInfo, 32768, SPI_MEM_CMD_BLOCKERASE32);
+  if (entry->eraseCaps & SPI_MEM_ERASE_4K)
+    LOCAL_addEraseType(hSPIMemInfo, 4096, SPI_MEM_CMD_SECTORERASE);
+
+  return E_PASS;
+}
+
+// Insert an erase type, keeping the list sorted largest first
+static void LOCAL_addEraseType(SPI_MemInfoHandle hSPIMemInfo, Uint32 size, Uint8 cmd)
+{
+  Uint32 i, j;
+
+  if (hSPIMemInfo->eraseTypeCnt >= SPI_MEM_MAX_ERASE_TYPES)
+    return;
+
+  for (i = 0; i < hSPIMemInfo->eraseTypeCnt; i++)
+  {
+    if (hSPIMemInfo->eraseTypes[i].size == size)
+      return;
+    if (hSPIMemInfo->eraseTypes[i].size < size)
+      break;
+  }
+
+  for (j = hSPIMemInfo->eraseTypeCnt; j > i; j--)
+    hSPIMemInfo->eraseTypes[j] = hSPIMemInfo->eraseTypes[j-1];
+
+  hSPIMemInfo->eraseTypes[i].size = size;
+  hSPIMemInfo->eraseTypes[i].cmd  = cmd;
+  hSPIMemInfo->eraseTypeCnt++;
 }
 
 
@@ -9,6 +9,7 @@ using System;
 using System.Text;
 using System.IO;
 using System.Reflection;
+using System.Threading;
 using UtilLib;
 using UtilLib.IO;
 
@@ -19,6 +20,12 @@ namespace TIBootAndFlash
 {
   partial class Program
   {
+    // Size of the message covered by each set of parity words
+    private const Int32 chunkSize = 512;
+    
+    // Number of chunks read and encoded at a time (2 MB of input)
+    private const Int32 chunksPerBatch = 4096;
+    
     private struct ProgramCmdParams
     {
       public String inputfileName;
@@ -163,45 +170,114 @@ namespace TIBootAndFlash
       
       // Create Reed Solomon ECC Object
       // Usage: ReedSolomonECC(Int32 msgSymbolCnt, Int32 maxCorrectibleErrorCnt, Byte symbolBitWidth)
-      ReedSolomonECC rs = new ReedSolomonECC(512,4,10);
+      ReedSolomonECC rs = new ReedSolomonECC(chunkSize,4,10);
 
+      // Stream the input through in batches rather than loading the whole image
+      FileStream fs = new FileStream(cmdParams.inputfileName, FileMode.Open, FileAccess.Read);
+      
       // Create binary writer for saving ECC data to output file
       BinaryWriter bw = new BinaryWriter(new FileStream(cmdParams.outputFileName,FileMode.Create,FileAccess.Write));      
       
-      // Read input data from file
-      Byte[] fileData = FileIO.GetFileData(cmdParams.inputfileName);
-      
-      Int32[] subArray = new Int32[512];
-      Int32[] parityArray;
+      Byte[] batchData = new Byte[chunkSize * chunksPerBatch];
+      Int32[] eccWords = new Int32[4 * chunksPerBatch];
+      Int32 opNum = 0;
       
-      for (int i=0; i<fileData.Length; i+=512)
+      while (true)
       {
-        for (int j=0; j<512; j++)
+        Int32 bytesRead = ReadBatch(fs, batchData);
+        if (bytesRead == 0)
+          break;
+          
+        // Pad a partial last chunk with 0xFF, as the erased NAND would be
+        Int32 chunkCnt = (bytesRead + chunkSize - 1) / chunkSize;
+        for (int i = bytesRead; i < (chunkCnt * chunkSize); i++)
         {
-          // Swap order of message data since this is apparently what the hardware does
-          // for its RS calculations
-          subArray[511-j] = ((i+j) >= fileData.Length) ? (0xFF) : ((Int32) fileData[i+j]);
+          batchData[i] = 0xFF;
         }
         
         // Calculate parity of the message data
-        parityArray = rs.GenerateParity(subArray);
+        EncodeBatch(rs, batchData, chunkCnt, eccWords);
         
-        // Prep the parity data and output it to file
-        if (cmdParams.verbose)
-        {
-          Console.WriteLine("NAND operation #{0}",(i/512)+1);
-        }
-        for (int j=0; j<8; j+=2)
+        // Output the parity data to file, in order
+        for (int i = 0; i < chunkCnt; i++)
         {
+          opNum++;
           if (cmdParams.verbose)
           {
-            Console.WriteLine("\tNAND4BITECC{0} = {1:X8}", (j/2 + 1),( (parityArray[j+1] & 0x3FF) << 16) | (parityArray[j] & 0x3FF) );
+            Console.WriteLine("NAND operation #{0}",opNum);
+          }
+          for (int j = 0; j < 4; j++)
+          {
+            if (cmdParams.verbose)
+            {
+              Console.WriteLine("\tNAND4BITECC{0} = {1:X8}", (j + 1), eccWords[4*i + j]);
+            }
+            bw.Write(eccWords[4*i + j]);
           }
-          bw.Write( ( (parityArray[j+1] & 0x3FF) << 16) | (parityArray[j] & 0x3FF) );
         }
+        
+        if (bytesRead < batchData.Length)
+          break;
       }
       
+      fs.Close();
+      bw.Close();
+      
       return 0;
     }
+    
+    /// <summary>
+    /// Fill the buffer from the stream, stopping short only at end of file
+    /// </summary>
+    private static Int32 ReadBatch(Stream s, Byte[] buffer)
+    {
+      Int32 total = 0, cnt;
+      
+      while (total < buffer.Length)
+      {
+        cnt = s.Read(buffer, total, buffer.Length - total);
+        if (cnt == 0)
+          break;
+        total += cnt;
+      }
+      return total;
+    }
+    
+    /// <summary>
+    /// Generate the NAND4BITECC register values for each chunk of the batch,
+    /// splitting the chunks across one worker thread per processor
+    /// </summary>
+    private static void EncodeBatch(ReedSolomonECC rs, Byte[] batchData, Int32 chunkCnt, Int32[] eccWords)
+    {
+      Int32 threadCnt = Math.Min(Environment.ProcessorCount, chunkCnt);
+      Thread[] workers = new Thread[threadCnt];
+      
+      for (int t = 0; t < threadCnt; t++)
+      {
+        Int32 first = (chunkCnt * t) / threadCnt;
+        Int32 last = (chunkCnt * (t + 1)) / threadCnt;
+        
+        workers[t] = new Thread(delegate()
+        {
+          Int32[] parityArray = new Int32[rs.ParityCount];
+          for (int i = first; i < last; i++)
+          {
+            rs.GenerateParity(batchData, i * chunkSize, parityArray);
+            
+            // Pack pairs of 10-bit parity symbols the way the hardware reports them
+            for (int j = 0; j < 8; j += 2)
+            {
+              eccWords[4*i + j/2] = ((parityArray[j+1] & 0x3FF) << 16) | (parityArray[j] & 0x3FF);
+            }
+          }
+        });
+        workers[t].Start();
+      }
+      
+      for (int t = 0; t < threadCnt; t++)
+      {
+        workers[t].Join();
+      }
+    }
   }
 }
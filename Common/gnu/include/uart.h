@@ -33,6 +33,7 @@ extern far "c" {
 
 // Simple send/recv functions
 Uint32 UART_sendString(String seq, Bool includeNull);
+Uint32 UART_sendStringN(String seq, Uint32 len);
 Uint32 UART_sendHexInt(Uint32 value);
 Uint32 UART_recvString(String seq);
 Uint32 UART_recvStringN(String seq, Uint32* len, Bool stopAtNull);
@@ -84,6 +84,32 @@ Uint32 UART_sendString(String seq, Bool includeNull)
   return E_PASS;
 }
 
+// Send exactly len bytes (binary data, nulls included)
+Uint32 UART_sendStringN(String seq, Uint32 len)
+{
+  Uint32 i, status = 0;
+  Uint32 timerStatus = 1;
+
+  for(i=0;i<len;i++)
+  {
+    // Enable Timer one time
+    DEVICE_TIMER0Start();
+    do
+    {
+      status = (UART0->LSR)&(0x20);
+      timerStatus = DEVICE_TIMER0Status();
+    }
+    while (!status && timerStatus);
+
+    if(timerStatus == 0)
+      return E_TIMEOUT;
+
+    // Send byte
+    (UART0->THR) = seq[i];
+  }
+  return E_PASS;
+}
+
 Uint32 UART_sendHexInt(Uint32 value)
 {
   char seq[9];
@@ -0,0 +1,518 @@
+/* --------------------------------------------------------------------------
+    FILE        : nandscan.cs
+    PURPOSE     : TI Booting and Flashing Utilities
+    DESC        : Offline ECC check of a raw NAND dump (data plus spare bytes
+                  for every page).  Decodes each 512 byte operation with the
+                  device's ECC layout and reports corrected bits, 
+                  uncorrectable pages and bad blocks.
+ ----------------------------------------------------------------------------- */
+
+using System;
+using System.Text;
+using System.IO;
+using System.Reflection;
+using System.Threading;
+using System.Collections.Generic;
+using UtilLib;
+
+[assembly: AssemblyTitle("nandscan")]
+[assembly: AssemblyVersion("1.00.*")]
+
+namespace TIBootAndFlash
+{
+  partial class Program
+  {
+    // Size of the data covered by one ECC operation
+    private const Int32 bytesPerOp = 512;
+    
+    // Spare bytes used by each ECC operation
+    private const Int32 spareBytesPerOp = 16;
+
+    // ECC layouts, selected with #if below:
+    //  DM644x (EMIF 2.x): 1-bit Hamming, spare bytes follow all the page data,
+    //    parity stored MSB first at offset 0 (small page) or 8 (large page) of each 16
+    //  DM35x (EMIF 2.5): 4-bit Reed-Solomon, each 512 data bytes followed by their
+    //    own 16 spare bytes, 10 parity bytes at offset 6
+    //  Others (EMIF 2.5): 4-bit Reed-Solomon, spare bytes follow all the page
+    //    data, 10 parity bytes at offset 6 of each 16
+    private const Int32 rsECCOffset = 6;
+    private const Int32 hammingECCOffsetSmallPage = 0;
+    private const Int32 hammingECCOffsetLargePage = 8;
+    
+    // Amount of dump read and decoded at a time
+    private const Int32 batchBytes = 8*1024*1024;
+    
+    // Per page results
+    private const Int32 pageErased = -2;
+    private const Int32 pageUncorrectable = -1;
+    
+    private struct ProgramCmdParams
+    {
+      public String inputfileName;
+      
+      public Int32 bytesPerPage;
+      
+      public Int32 pagesPerBlock;
+
+      public Boolean verbose;
+
+      public Boolean valid;
+    }
+      
+    /// <summary>
+    /// Function to display help in case command-line is invalid
+    /// </summary>
+    private static void DispHelp()
+    {
+      Console.Write("Usage:\n\n");
+      Console.Write("nandscan_"+devString+" [Options] <Raw Dump File Name>\n");
+      Console.Write("\t" + "<Option> can be any of the following:\n");
+      Console.Write("\t\t" + "-h                   \tShow this help screen.\n");
+      Console.Write("\t\t" + "-v                   \tList every page that needed correction.\n"); 
+      Console.Write("\t\t" + "-p <Page Size>       \tData bytes per page (512, 2048 or 4096).\n");
+      Console.Write("\t\t" + "                     \tDefault is 2048.\n");
+      Console.Write("\t\t" + "-b <Pages Per Block> \tPages in each erase block. Default is 64.\n");
+      Console.Write("\n");
+      Console.Write("\t" + "The dump must hold each page's data followed by its spare bytes\n");
+      Console.Write("\t" + "(page size / 32), as read from the device with ECC disabled.\n");
+      Console.Write("\n");
+    }
+
+    /// <summary>
+    /// Function to parse the command line
+    /// </summary>
+    /// <param name="args">Array of command-line arguments</param>
+    /// <returns>Struct of the filled in program arguments</returns>
+    private static ProgramCmdParams ParseCmdLine(String[] args)
+    {
+      ProgramCmdParams myCmdParams = new ProgramCmdParams();
+      Boolean[] argsHandled = new Boolean[args.Length];
+
+      UInt32 numUnhandledArgs, numHandledArgs = 0;
+      String s;
+
+      // Check for no argumnents
+      if (args.Length == 0)
+      {
+        myCmdParams.valid = false;
+        return myCmdParams;
+      }
+
+      // Set Defaults    
+      myCmdParams.valid = true;
+      myCmdParams.verbose = false;
+      myCmdParams.inputfileName = null;
+      myCmdParams.bytesPerPage = 2048;
+      myCmdParams.pagesPerBlock = 64;
+
+      // Initialize array of handled argument booleans to false
+      for (int i = 0; i < argsHandled.Length; i++)
+        argsHandled[i] = false;
+
+      // For loop to check for all dash options
+      for (int i = 0; i < args.Length; i++)
+      {
+        s = args[i];
+        if (s.StartsWith("-"))
+        {
+          switch (s.Substring(1).ToLower())
+          {
+            case "p":
+              myCmdParams.bytesPerPage = (Int32) ParseNumber(args, i + 1, ref myCmdParams.valid);
+              argsHandled[i + 1] = true;
+              numHandledArgs++;
+              break;
+            case "b":
+              myCmdParams.pagesPerBlock = (Int32) ParseNumber(args, i + 1, ref myCmdParams.valid);
+              argsHandled[i + 1] = true;
+              numHandledArgs++;
+              break;
+            case "v":
+              myCmdParams.verbose = true;
+              break;
+            default:
+              myCmdParams.valid = false;
+              break;
+          }
+          argsHandled[i] = true;
+          numHandledArgs++;
+        }
+      }
+      numUnhandledArgs = (UInt32)(args.Length - numHandledArgs);
+      
+      // Check to make sure we are still valid
+      if ( (!myCmdParams.valid) || (numUnhandledArgs != 1) || (argsHandled[args.Length-1]))
+      {
+          myCmdParams.valid = false;
+          return myCmdParams;
+      }
+      
+      if ( (myCmdParams.bytesPerPage < bytesPerOp) || ((myCmdParams.bytesPerPage % bytesPerOp) != 0) ||
+           (myCmdParams.pagesPerBlock <= 0) )
+      {
+        Console.WriteLine("Invalid page or block geometry.");
+        myCmdParams.valid = false;
+        return myCmdParams;
+      }
+       
+      // Get input file
+      FileInfo fi = new FileInfo(args[args.Length-1]);
+      if (fi.Exists)
+      {
+        myCmdParams.inputfileName = args[args.Length - 1];
+      }
+      else
+      {
+        Console.WriteLine("File not found.");
+        myCmdParams.valid = false;
+        return myCmdParams;
+      }
+
+      return myCmdParams;
+    }
+    
+    private static UInt32 ParseNumber(String[] args, Int32 index, ref Boolean valid)
+    {
+      if (index >= args.Length)
+      {
+        valid = false;
+        return 0;
+      }
+      try
+      {
+        if (args[index].StartsWith("0x"))
+          return Convert.ToUInt32(args[index], 16);
+        return Convert.ToUInt32(args[index], 10);
+      }
+      catch (Exception)
+      {
+        valid = false;
+        return 0;
+      }
+    }
+      
+    /// <summary>
+    /// Main program.
+    /// </summary>
+    /// <param name="args">Input commandline arguments</param>
+    /// <returns>Return code: 0 for a clean dump, 1 if uncorrectable pages were
+    /// found, -1 for unexpected exit</returns>
+    static Int32 Main(String[] args)
+    {          
+      // Assumes that in AssemblyInfo.cs, the version is specified as 1.0.* or the like,
+      // with only 2 numbers specified;  the next two are generated from the date.
+      System.Version v = System.Reflection.Assembly.GetExecutingAssembly().GetName().Version;
+      
+      // v.Build is days since Jan. 1, 2000, v.Revision*2 is seconds since local midnight
+      Int32 buildYear = new DateTime( v.Build * TimeSpan.TicksPerDay + v.Revision * TimeSpan.TicksPerSecond * 2 ).AddYears(1999).Year;
+      
+      // Begin main code
+      Console.WriteLine("-----------------------------------------------------");
+      Console.WriteLine("   TI NAND Dump ECC Scanner for " + devString          );
+      Console.WriteLine("   (C) "+buildYear+", Texas Instruments, Inc."        );
+      Console.WriteLine("   Ver. "+v.Major+"."+v.Minor.ToString("D2")          );
+      Console.WriteLine("-----------------------------------------------------");
+      Console.Write("\n\n");            
+      
+      // Parse the input command line parameters
+      ProgramCmdParams cmdParams = ParseCmdLine(args);
+      if (!cmdParams.valid)
+      {
+          DispHelp();
+          return -1;
+      }
+      
+      Int32 spareBytesPerPage = cmdParams.bytesPerPage / 32;
+      Int32 rawPageSize = cmdParams.bytesPerPage + spareBytesPerPage;
+      Int32 rawBlockSize = rawPageSize * cmdParams.pagesPerBlock;
+      Int32 blocksPerBatch = Math.Max(1, batchBytes / rawBlockSize);
+      
+      Byte[] batchData = new Byte[rawBlockSize * blocksPerBatch];
+      Int32[] pageResults = new Int32[cmdParams.pagesPerBlock * blocksPerBatch];
+      Boolean[] badBlocks = new Boolean[blocksPerBatch];
+      
+      // Statistics
+      Int64 pageCnt = 0, erasedCnt = 0, cleanCnt = 0, correctedCnt = 0, correctedBits = 0;
+      Int32 blockNum = 0;
+      List<Int32> badBlockList = new List<Int32>();
+      List<String> uncorrectableList = new List<String>();
+      SortedDictionary<Int32,Int64> pageHistogram = new SortedDictionary<Int32,Int64>();
+      SortedDictionary<Int32,Int64> blockHistogram = new SortedDictionary<Int32,Int64>();
+      
+      FileStream fs = new FileStream(cmdParams.inputfileName, FileMode.Open, FileAccess.Read, FileShare.Read, 1 << 16);
+      
+      if ((fs.Length % rawPageSize) != 0)
+      {
+        Console.WriteLine("WARNING: Dump size is not a multiple of {0} byte raw pages; the tail is ignored.", rawPageSize);
+      }
+      
+      while (true)
+      {
+        Int32 bytesRead = ReadBatch(fs, batchData);
+        Int32 pagesRead = bytesRead / rawPageSize;
+        if (pagesRead == 0)
+          break;
+        Int32 blocksRead = (pagesRead + cmdParams.pagesPerBlock - 1) / cmdParams.pagesPerBlock;
+        
+        // Factory/UBL bad block markers live in the spare bytes of the first two pages
+        for (int b = 0; b < blocksRead; b++)
+        {
+          badBlocks[b] = false;
+          for (int p = 0; (p < 2) && (p < cmdParams.pagesPerBlock) && ((b * cmdParams.pagesPerBlock + p) < pagesRead); p++)
+          {
+            if (IsMarkedBad(cmdParams, batchData, (b * rawBlockSize) + (p * rawPageSize)))
+              badBlocks[b] = true;
+          }
+        }
+        
+        ScanBatch(cmdParams, batchData, pagesRead, badBlocks, pageResults);
+        
+        // Gather the results in dump order
+        for (int b = 0; b < blocksRead; b++, blockNum++)
+        {
+          if (badBlocks[b])
+          {
+            badBlockList.Add(blockNum);
+            continue;
+          }
+          
+          Int32 blockBits = 0;
+          for (int p = 0; (p < cmdParams.pagesPerBlock) && ((b * cmdParams.pagesPerBlock + p) < pagesRead); p++)
+          {
+            Int32 result = pageResults[b * cmdParams.pagesPerBlock + p];
+            pageCnt++;
+            
+            if (result == pageErased)
+            {
+              erasedCnt++;
+              continue;
+            }
+            if (result == pageUncorrectable)
+            {
+              uncorrectableList.Add(String.Format("block {0}, page {1}", blockNum, p));
+              continue;
+            }
+            
+            AddToHistogram(pageHistogram, result);
+            if (result == 0)
+            {
+              cleanCnt++;
+            }
+            else
+            {
+              correctedCnt++;
+              correctedBits += result;
+              blockBits += result;
+              if (cmdParams.verbose)
+              {
+                Console.WriteLine("Block {0}, page {1}: corrected {2} bit(s)", blockNum, p, result);
+              }
+            }
+          }
+          AddToHistogram(blockHistogram, blockBits);
+        }
+        
+        if (bytesRead < batchData.Length)
+          break;
+      }
+      fs.Close();
+      
+      // Report
+      Console.WriteLine();
+      Console.WriteLine("Blocks scanned        : {0}", blockNum);
+      Console.WriteLine("Bad blocks            : {0}", badBlockList.Count);
+      Console.WriteLine("Pages decoded         : {0}", pageCnt);
+      Console.WriteLine("  erased              : {0}", erasedCnt);
+      Console.WriteLine("  clean               : {0}", cleanCnt);
+      Console.WriteLine("  corrected           : {0} ({1} bits)", correctedCnt, correctedBits);
+      Console.WriteLine("  uncorrectable       : {0}", uncorrectableList.Count);
+      
+      Console.WriteLine();
+      Console.WriteLine("Corrected bits per programmed page:");
+      foreach (KeyValuePair<Int32,Int64> kvp in pageHistogram)
+      {
+        Console.WriteLine("  {0,5} : {1}", kvp.Key, kvp.Value);
+      }
+      
+      Console.WriteLine();
+      Console.WriteLine("Corrected bits per good block:");
+      foreach (KeyValuePair<Int32,Int64> kvp in blockHistogram)
+      {
+        Console.WriteLine("  {0,5} : {1}", kvp.Key, kvp.Value);
+      }
+      
+      if (badBlockList.Count > 0)
+      {
+        Console.WriteLine();
+        Console.WriteLine("Bad blocks:");
+        foreach (Int32 b in badBlockList)
+        {
+          Console.WriteLine("  block {0}", b);
+        }
+      }
+      
+      if (uncorrectableList.Count > 0)
+      {
+        Console.WriteLine();
+        Console.WriteLine("Uncorrectable pages:");
+        foreach (String s in uncorrectableList)
+        {
+          Console.WriteLine("  " + s);
+        }
+        return 1;
+      }
+      
+      return 0;
+    }
+    
+    private static void AddToHistogram(SortedDictionary<Int32,Int64> histogram, Int32 key)
+    {
+      Int64 cnt;
+      histogram.TryGetValue(key, out cnt);
+      histogram[key] = cnt + 1;
+    }
+    
+    /// <summary>
+    /// Fill the buffer from the stream, stopping short only at end of file
+    /// </summary>
+    private static Int32 ReadBatch(Stream s, Byte[] buffer)
+    {
+      Int32 total = 0, cnt;
+      
+      while (total < buffer.Length)
+      {
+        cnt = s.Read(buffer, total, buffer.Length - total);
+        if (cnt == 0)
+          break;
+        total += cnt;
+      }
+      return total;
+    }
+    
+    /// <summary>
+    /// Decode every page of the batch that is not in a bad block, splitting the
+    /// pages across one worker thread per processor
+    /// </summary>
+    private static void ScanBatch(ProgramCmdParams cmdParams, Byte[] batchData, Int32 pageCnt, Boolean[] badBlocks, Int32[] pageResults)
+    {
+      Int32 threadCnt = Math.Min(Environment.ProcessorCount, pageCnt);
+      Thread[] workers = new Thread[threadCnt];
+      
+      for (int t = 0; t < threadCnt; t++)
+      {
+        Int32 first = (Int32)(((Int64)pageCnt * t) / threadCnt);
+        Int32 last = (Int32)(((Int64)pageCnt * (t + 1)) / threadCnt);
+        
+        workers[t] = new Thread(delegate()
+        {
+          // The ECC objects are only read while decoding, one set per thread keeps it simple
+#if DM644x
+          ReedSolomonECC rs = null;
+          HammingECC h = new HammingECC(bytesPerOp);
+#else
+          ReedSolomonECC rs = new ReedSolomonECC(bytesPerOp,4,10);
+          HammingECC h = null;
+#endif
+          Int32[] parity = new Int32[8];
+          
+          for (int p = first; p < last; p++)
+          {
+            if (badBlocks[p / cmdParams.pagesPerBlock])
+              continue;
+            pageResults[p] = DecodePage(cmdParams, batchData, p * (cmdParams.bytesPerPage + cmdParams.bytesPerPage / 32), rs, h, parity);
+          }
+        });
+        workers[t].Start();
+      }
+      
+      for (int t = 0; t < threadCnt; t++)
+      {
+        workers[t].Join();
+      }
+    }
+    
+    /// <summary>
+    /// Check a raw page for a bad block marker
+    /// </summary>
+    private static Boolean IsMarkedBad(ProgramCmdParams cmdParams, Byte[] buf, Int32 pageOffset)
+    {
+#if DM35x
+      // Each 512 data bytes carry their own 16 spare bytes, so the usual
+      // marker position falls inside the page data.  As the UBL does, treat
+      // the block as bad if any free (non-ECC) spare byte is not 0xFF.
+      Int32 opsPerPage = cmdParams.bytesPerPage / bytesPerOp;
+      for (int op = 0; op < opsPerPage; op++)
+      {
+        Int32 spareOffset = pageOffset + op * (bytesPerOp + spareBytesPerOp) + bytesPerOp;
+        for (int i = 0; i < rsECCOffset; i++)
+        {
+          if (buf[spareOffset + i] != 0xFF)
+            return true;
+        }
+      }
+      return false;
+#else
+      // Spare bytes follow the page data; the marker is the first spare byte
+      // (large page) or the sixth (small page)
+      return (buf[pageOffset + cmdParams.bytesPerPage + ((cmdParams.bytesPerPage > 512) ? 0 : 5)] != 0xFF);
+#endif
+    }
+    
+    /// <summary>
+    /// Check and correct one raw page in place
+    /// </summary>
+    /// <returns>Number of corrected bits, pageErased or pageUncorrectable</returns>
+    private static Int32 DecodePage(ProgramCmdParams cmdParams, Byte[] buf, Int32 pageOffset, ReedSolomonECC rs, HammingECC h, Int32[] parity)
+    {
+      Int32 opsPerPage = cmdParams.bytesPerPage / bytesPerOp;
+      Int32 rawPageSize = cmdParams.bytesPerPage + (cmdParams.bytesPerPage / 32);
+      Int32 dataOffset, spareOffset, result, totalBits = 0;
+      Boolean erased = true;
+      
+      // Pages never programmed since the last erase carry no valid ECC
+      for (int i = pageOffset; i < (pageOffset + rawPageSize); i++)
+      {
+        if (buf[i] != 0xFF)
+        {
+          erased = false;
+          break;
+        }
+      }
+      if (erased)
+        return pageErased;
+      
+      for (int op = 0; op < opsPerPage; op++)
+      {
+#if DM35x
+        dataOffset = pageOffset + op * (bytesPerOp + spareBytesPerOp);
+        spareOffset = dataOffset + bytesPerOp;
+#else
+        dataOffset = pageOffset + op * bytesPerOp;
+        spareOffset = pageOffset + cmdParams.bytesPerPage + op * spareBytesPerOp;
+#endif
+        
+#if DM644x
+        Int32 eccOffset = spareOffset + ((cmdParams.bytesPerPage > 512) ? hammingECCOffsetLargePage : hammingECCOffsetSmallPage);
+        Int32 stored = (buf[eccOffset] << 24) | (buf[eccOffset+1] << 16) | (buf[eccOffset+2] << 8) | buf[eccOffset+3];
+        result = h.CorrectErrors(buf, dataOffset, stored);
+#else
+        // Eight 10-bit parity symbols packed LSB first into 10 bytes
+        Int32 eccOffset = spareOffset + rsECCOffset;
+        for (int i = 0; i < 8; i++)
+        {
+          Int32 bitPos = 10 * i;
+          Int32 pair = buf[eccOffset + (bitPos >> 3)] | (buf[eccOffset + (bitPos >> 3) + 1] << 8);
+          parity[i] = (pair >> (bitPos & 0x7)) & 0x3FF;
+        }
+        result = rs.CorrectErrors(buf, dataOffset, parity);
+#endif
+        
+        if (result < 0)
+          return pageUncorrectable;
+        totalBits += result;
+      }
+      
+      return totalBits;
+    }
+  }
+}
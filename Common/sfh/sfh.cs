@@ -12,10 +12,12 @@ using System.IO.Ports;
 using System.Reflection;
 using System.Threading;
 using System.Globalization;
+using System.Collections.Generic;
 using UtilLib;
 using UtilLib.CRC;
 using UtilLib.IO;
 using UtilLib.ConsoleUtility;
+using UtilLib.HexConv;
 
 [assembly: AssemblyTitle("SerialFlasherHost")]
 [assembly: AssemblyVersion("1.50.*")]
@@ -46,9 +48,14 @@ namespace TIBootAndFlash
     UBL_MAGIC_BIN_IMG_DM35x_REVC = 0xA1BCED66,     /* Describes the application image in Flash - indicates that it is binary*/
     UBL_MAGIC_NOR_FLASH_NO_UBL = 0xA1ACED77,       /* Download via UART & Burn NOR with u-boot only - legacy option */
     UBL_MAGIC_NOR_FLASH = 0xA1ACED99,              /* Download via UART & Burn NOR with UBL and U-boot */
+    UBL_MAGIC_SESSION_EXIT = 0xA1ACEDBB,           /* End the resident SFT session */
     UBL_MAGIC_NOR_ERASE = 0xA1ACEDAA,              /* Download via UART & erase the NOR Flash */
     UBL_MAGIC_NAND_FLASH = 0xA1ACEDCC,             /* Download via UART & Flash NAND with UBL and U-boot */
     UBL_MAGIC_NAND_ERASE = 0xA1ACEDDD,	           /* Download via UART & erase the NAND Flash */
+    UBL_MAGIC_NAND_RAW_WRITE = 0xA1ACED88,         /* Download via UART & write a raw image to a range of NAND blocks */
+    UBL_MAGIC_NAND_RAW_ERASE = 0xA1ACED89,         /* Erase the good blocks of a range of NAND blocks */
+    UBL_MAGIC_NAND_RAW_VERIFY = 0xA1ACED8A,        /* Return the CRC-32 of a raw image read from a range of NAND blocks */
+    UBL_MAGIC_NAND_RAW_READ = 0xA1ACED8B,          /* Read a raw image back from a range of NAND blocks via UART */
     UBL_MAGIC_SDMMC_FLASH = 0xA1ACEDEE,            /* Download via UART & Burn SD/MMC with UBL and U-boot */
     UBL_MAGIC_SDMMC_ERASE = 0xA1ACEDFF,            /* Download via UART erase the SD/MMC Flash */        
   };
@@ -80,15 +87,21 @@ namespace TIBootAndFlash
     public Boolean verbose;
     
     /// <summary>
-    /// Name of serial port used for communications
+    /// Names of the serial ports used for communications (one target per port)
     /// </summary>
-    public String SerialPortName;
+    public String[] SerialPortNames;
     
     /// <summary>
     /// Baud Rate of serial port
     /// </summary>
     public Int32 SerialPortBaudRate;
 
+    /// <summary>
+    /// Baud rate the SFT loader stub switches to for the binary SFT download
+    /// (zero means send the whole SFT through the RBL instead).
+    /// </summary>
+    public Int32 StubBaudRate;
+
     /// <summary>
     /// This should be transmitted alone in response to the BOOTUBL.
     /// </summary>
@@ -125,6 +138,22 @@ namespace TIBootAndFlash
     /// </summary>
     public String APPFileName;
 
+    /// <summary>
+    /// Script of commands to run in one SFT session (instead of a single command)
+    /// </summary>
+    public String ScriptFileName;
+
+    /// <summary>
+    /// First NAND block and number of blocks of the partition for a raw write
+    /// </summary>
+    public UInt32 RawStartBlock;
+    public UInt32 RawBlockCount;
+
+    /// <summary>
+    /// Number of bytes to read back from the partition
+    /// </summary>
+    public UInt32 RawByteCount;
+
     /// <summary>
     /// Start address of where the app image should be loaded
     /// </summary>
@@ -142,9 +171,298 @@ namespace TIBootAndFlash
     public UInt32 startAddr;
     public UInt32 loadAddr;
     public UInt32 byteCnt;
-    public UInt32 crcVal;
-  }    
+  }
+
+  /// <summary>
+  /// One command for the SFT, with the image data it sends
+  /// </summary>
+  class FlashCommand
+  {
+    public MagicFlags CMDMagicFlag;
+    public FlashType UBLFlashType;
+    public String UBLFileName;
+    public String APPFileName;
+    public Byte[] ublData;
+    public Byte[] appData;
+    public UInt32 RawStartBlock;
+    public UInt32 RawBlockCount;
+    public UInt32 RawByteCount;
+    public String RawOutFileName;
+
+    public FlashCommand(MagicFlags cmdMagicFlag, FlashType flashType)
+    {
+      CMDMagicFlag = cmdMagicFlag;
+      UBLFlashType = flashType;
+    }
+
+    /// <summary>
+    /// Parse a decimal number, or a hex one with a 0x prefix
+    /// </summary>
+    public static UInt32 ParseNumber(String s)
+    {
+      if (s.StartsWith("0x") || s.StartsWith("0X"))
+        return System.UInt32.Parse(s.Substring(2),System.Globalization.NumberStyles.AllowHexSpecifier);
+      else
+        return System.UInt32.Parse(s);
+    }
+
+    /// <summary>
+    /// Look up a command by its command line name (without the dash)
+    /// </summary>
+    /// <returns>The command, or null if the name is not known.</returns>
+    public static FlashCommand FromName(String name, out Int32 numArgs)
+    {
+      numArgs = 0;
+      switch (name.ToLower())
+      {
+        case "norflash":
+          numArgs = 2;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NOR_FLASH, FlashType.NOR);
+        case "norflash_noubl":
+          numArgs = 1;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NOR_FLASH_NO_UBL, FlashType.NOR);
+        case "nandflash":
+          numArgs = 2;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NAND_FLASH, FlashType.NAND);
+        case "nandraw":
+          numArgs = 3;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NAND_RAW_WRITE, FlashType.NAND);
+        case "nandrawerase":
+          numArgs = 2;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NAND_RAW_ERASE, FlashType.NAND);
+        case "nandverify":
+          numArgs = 3;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NAND_RAW_VERIFY, FlashType.NAND);
+        case "nandread":
+          numArgs = 4;
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NAND_RAW_READ, FlashType.NAND);
+        case "norerase":
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NOR_ERASE, FlashType.NOR);
+        case "nanderase":
+          return new FlashCommand(MagicFlags.UBL_MAGIC_NAND_ERASE, FlashType.NAND);
+        default:
+          return null;
+      }
+    }
+
+    /// <summary>
+    /// Whether the command works on a range of NAND blocks
+    /// </summary>
+    public Boolean IsRaw
+    {
+      get
+      {
+        return ((CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_WRITE) ||
+                (CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_ERASE) ||
+                (CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_VERIFY) ||
+                (CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_READ));
+      }
+    }
+
+    /// <summary>
+    /// Parse a command script: one command per line, written as on the
+    /// command line but without the dash, e.g. "nandflash ubl.bin u-boot.bin",
+    /// "nandraw 0x100 0x700 rootfs.jffs2" or "nandverify 0x100 0x700 rootfs.jffs2".
+    /// Blank lines and lines starting with '#' are ignored.
+    /// </summary>
+    public static List<FlashCommand> ParseScript(String fileName)
+    {
+      List<FlashCommand> commands = new List<FlashCommand>();
+      String[] lines = FileIO.GetFileText(fileName).Split('\n');
+
+      for (int i = 0; i < lines.Length; i++)
+      {
+        String line = lines[i].Trim();
+        String[] tokens;
+        FlashCommand cmd;
+        Int32 numArgs;
+
+        if ((line.Length == 0) || line.StartsWith("#"))
+          continue;
+
+        tokens = line.Split(new Char[] {' ','\t'}, StringSplitOptions.RemoveEmptyEntries);
+        cmd = FromName(tokens[0].TrimStart('-'), out numArgs);
+        if (tokens[0].TrimStart('-').ToLower() == "sdflash")
+          throw new Exception(fileName + ", line " + (i+1) + ": sdflash can't be run from a script, only on its own.");
+        if (cmd == null)
+          throw new Exception(fileName + ", line " + (i+1) + ": unknown command " + tokens[0] + ".");
+        if ((tokens.Length - 1) != numArgs)
+          throw new Exception(fileName + ", line " + (i+1) + ": " + tokens[0] + " takes " + numArgs + " argument(s).");
+
+        if (cmd.IsRaw)
+        {
+          try
+          {
+            cmd.RawStartBlock = ParseNumber(tokens[1]);
+            cmd.RawBlockCount = ParseNumber(tokens[2]);
+            if (cmd.CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_READ)
+              cmd.RawByteCount = ParseNumber(tokens[3]);
+          }
+          catch (Exception)
+          {
+            throw new Exception(fileName + ", line " + (i+1) + ": bad block number or length.");
+          }
+          if (cmd.CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_READ)
+            cmd.RawOutFileName = tokens[4];
+          else if (numArgs == 3)
+            cmd.APPFileName = tokens[3];
+        }
+        else if (numArgs == 2)
+        {
+          cmd.UBLFileName = tokens[1];
+          cmd.APPFileName = tokens[2];
+        }
+        else if (numArgs == 1)
+        {
+          cmd.APPFileName = tokens[1];
+        }
+        commands.Add(cmd);
+      }
+
+      if (commands.Count == 0)
+        throw new Exception(fileName + " contains no commands.");
+
+      return commands;
+    }
+  }
     
+  /// <summary>
+  /// Image in the form the device ROM serial boot wants it: ASCII hex data,
+  /// the CRC of the data and the CRC table, all built once up front.
+  /// </summary>
+  class RBLImage
+  {
+    public Byte[] data;
+    public Byte[] hexData;
+    public Byte[] crcTable;
+    public UInt32 crcVal;
+
+    public RBLImage(Byte[] imageData)
+    {
+      CRC32 MyCRC;
+
+      data = imageData;
+
+      // Each 32-bit word of the image as 8 hex digits
+      hexData = HexCodec.EncodeWords(imageData, false);
+
+      // Create CRC object and use it to calculate the UBL file's CRC
+      // Note that this CRC is not quite the standard CRC-32 algorithm
+      // commonly in use since the final register value is not XOR'd
+      // with 0xFFFFFFFF.  As a result the CRC value returned here
+      // will be the bitwise inverse of the standard CRC-32 value.
+      MyCRC = new CRC32(0x04C11DB7, 0xFFFFFFFF, 0x00000000, true, 1, CRCType.ONESHOT, CRCCalcMethod.LUT);
+      crcVal = MyCRC.CalculateCRC(imageData);
+
+      // The 1024 byte (256 word) CRC table, as hex text
+      crcTable = new Byte[MyCRC.Length * 8];
+      for (int i = 0; i < MyCRC.Length; i++)
+      {
+        HexCodec.PutWord(MyCRC[i], crcTable, i * 8, true);
+      }
+    }
+  }
+
+  /// <summary>
+  /// All image data needed for one flashing operation.  This is loaded and
+  /// prepared once and then shared (read-only) by every target session.
+  /// </summary>
+  class FlashImages
+  {
+    /// <summary>
+    /// SFT image, prepared for the RBL
+    /// </summary>
+    public RBLImage sftImage;
+
+    /// <summary>
+    /// Standard CRC-32 of the SFT image, as checked by the loader stub
+    /// </summary>
+    public UInt32 sftStubCRC;
+
+    /// <summary>
+    /// SFT loader stub image, prepared for the RBL (null if not used)
+    /// </summary>
+    public RBLImage stubImage;
+
+    /// <summary>
+    /// Commands to run, in order, with their image data
+    /// </summary>
+    public List<FlashCommand> commands;
+
+    public FlashImages(ProgramCmdParams cmdParams)
+    {
+      Dictionary<String,Byte[]> files = new Dictionary<String,Byte[]>();
+      FlashType flashType;
+      String srchStr;
+      CRC32 MyCRC;
+
+      if (cmdParams.ScriptFileName != null)
+      {
+        commands = FlashCommand.ParseScript(cmdParams.ScriptFileName);
+      }
+      else
+      {
+        FlashCommand cmd = new FlashCommand(cmdParams.CMDMagicFlag, cmdParams.UBLFlashType);
+        cmd.UBLFileName = cmdParams.UBLFileName;
+        cmd.APPFileName = cmdParams.APPFileName;
+        cmd.RawStartBlock = cmdParams.RawStartBlock;
+        cmd.RawBlockCount = cmdParams.RawBlockCount;
+        cmd.RawByteCount = cmdParams.RawByteCount;
+        if (cmd.CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_READ)
+        {
+          // The only file named is where the data read back goes
+          cmd.RawOutFileName = cmdParams.APPFileName;
+          cmd.APPFileName = null;
+        }
+        commands = new List<FlashCommand>();
+        commands.Add(cmd);
+      }
+
+      // One SFT serves the whole session, so all commands must target the same flash
+      flashType = commands[0].UBLFlashType;
+      foreach (FlashCommand cmd in commands)
+      {
+        if (cmd.UBLFlashType != flashType)
+          throw new Exception("NOR and NAND commands can't be mixed in one session.");
+
+        // Read each file only once, even if several commands use it
+        if (cmd.UBLFileName != null)
+        {
+          if (!files.ContainsKey(cmd.UBLFileName))
+            files.Add(cmd.UBLFileName, FileIO.GetFileData(cmd.UBLFileName));
+          cmd.ublData = files[cmd.UBLFileName];
+        }
+        if (cmd.APPFileName != null)
+        {
+          if (!files.ContainsKey(cmd.APPFileName))
+            files.Add(cmd.APPFileName, FileIO.GetFileData(cmd.APPFileName));
+          cmd.appData = files[cmd.APPFileName];
+        }
+      }
+
+      if (flashType == FlashType.NAND)
+        srchStr = "sft_"+Program.devString+"_nand.bin";
+      else
+        srchStr = "sft_"+Program.devString+"_nor.bin";
+
+      // Extract the embedded SFT and read the data that we will transmit
+      EmbeddedFileIO.ExtractFile(System.Reflection.Assembly.GetExecutingAssembly(), srchStr, true);
+      sftImage = new RBLImage(FileIO.GetFileData(srchStr));
+
+      if (cmdParams.StubBaudRate != 0)
+      {
+        // Extract the embedded loader stub, which is sent through the RBL instead
+        srchStr = "sft_"+Program.devString+"_stub.bin";
+        EmbeddedFileIO.ExtractFile(System.Reflection.Assembly.GetExecutingAssembly(), srchStr, true);
+        stubImage = new RBLImage(FileIO.GetFileData(srchStr));
+
+        // Standard CRC-32, which the stub calculates bitwise
+        MyCRC = new CRC32(0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, 1, CRCType.ONESHOT, CRCCalcMethod.LUT);
+        sftStubCRC = MyCRC.CalculateCRC(sftImage.data);
+      }
+    }
+  }
+
   /// <summary>
   /// Main program Class
   /// </summary>
@@ -154,19 +472,19 @@ namespace TIBootAndFlash
     #region Class variables and members
 
     /// <summary>
-    /// Global main Serial Port Object
+    /// One flashing session per target serial port
     /// </summary>
-    public static SerialPort MySP;
+    public static FlashSession[] sessions;
             
     /// <summary>
-    /// The main thread used to actually execute everything
+    /// Number of sessions that have not yet finished
     /// </summary>
-    public static Thread workerThread;
+    private static Int32 activeSessions;
 
     /// <summary>
-    /// Global boolean to indicate successful completion of workerThread
+    /// Signalled when the last session finishes
     /// </summary>
-    public static Boolean workerThreadSucceeded = false;
+    private static ManualResetEvent sessionsDone = new ManualResetEvent(false);
 
     /// <summary>
     /// Public variable to hold needed command line and program parameters
@@ -200,15 +518,32 @@ namespace TIBootAndFlash
       Console.Write("\t\t" + "-norflash\tRestore the NOR Flash with bootable UBL and application (typically U-Boot).\n");                 
       Console.Write("\tsfh_"+devString+" -nandflash [<Options>] <UBL binary image> <Application binary image>\n");
       Console.Write("\t\t" + "-nandflash\tRestore the NAND Flash with bootable UBL and application (typically U-Boot).\n");                 
+      Console.Write("\tsfh_"+devString+" -nandraw <Start block> <Block count> [<Options>] <Raw image>\n");
+      Console.Write("\t\t" + "-nandraw\tWrite a raw image (e.g. a root filesystem) to a NAND partition, skipping\n");
+      Console.Write("\t\t" + "        \tbad blocks as Linux MTD does. Block numbers are decimal or 0x-prefixed hex.\n");
+      Console.Write("\tsfh_"+devString+" -nandrawerase <Start block> <Block count> [<Options>]\n");
+      Console.Write("\t\t" + "-nandrawerase\tErase the good blocks of a NAND partition.\n");
+      Console.Write("\tsfh_"+devString+" -nandverify <Start block> <Block count> [<Options>] <Raw image>\n");
+      Console.Write("\t\t" + "-nandverify\tCheck that a NAND partition holds a raw image written with -nandraw.\n");
+      Console.Write("\tsfh_"+devString+" -nandread <Start block> <Block count> <Byte count> [<Options>] <Output file>\n");
+      Console.Write("\t\t" + "-nandread\tRead <Byte count> bytes of a raw image back from a NAND partition into\n");
+      Console.Write("\t\t" + "         \t<Output file> (one file per port, with the port name appended, for several boards).\n");
+      Console.Write("\tsfh_"+devString+" -script <Script file> [<Options>]\n");
+      Console.Write("\t\t" + "-script\tRun several of the above commands in one SFT session. The file holds one\n");
+      Console.Write("\t\t" + "       \tcommand per line, without the dash (e.g. nanderase, nandflash ubl.bin u-boot.bin).\n");
       Console.Write("\tsfh_"+devString+" -sdflash [<Options>] <UBL binary image> <Application binary image>\n");      
       Console.Write("\t\t" + "-sdflash\tRestore the SD/MMC Flash with bootable UBL and application (typically U-Boot).\n");            
       Console.Write("\n\t" + "<Options> can be the following: " +
                     "\n\t\t" + "-APPStartAddr <Application entry point address>\tSpecify in hex, defaults to 0x81080000." +
                     "\n\t\t" + "-APPLoadAddr <Application image load address>  \tSpecify in hex, defaults to 0x81080000." +      
                     "\n\t\t" + "-UBLStartAddr <UBL entry point address>        \tSpecify in hex, defaults to 0x0100 ." +                    
+                    "\n\t\t" + "-stubbaud <Baud rate>\tSend a small loader stub through the ROM and download the SFT" +
+                    "\n\t\t" + "                     \tthrough it in binary at <Baud rate> (e.g. 750000, 1500000)." +
                     "\n\t\t" + "-h                \tDisplay this help screen."+
                     "\n\t\t" + "-v                \tDisplay more verbose output returned from the "+devString+"."+
-                    "\n\t\t" + "-p \"<PortName>\" \tUse <PortName> as the serial port (e.g. COM2, /dev/ttyS1).\n\n");
+                    "\n\t\t" + "-p \"<PortName>\" \tUse <PortName> as the serial port (e.g. COM2, /dev/ttyS1)."+
+                    "\n\t\t" + "                  \tGive a comma separated list (or repeat -p) to flash several"+
+                    "\n\t\t" + "                  \tboards at once, one per port (e.g. COM3,COM4,COM5).\n\n");
     }   
 
     /// <summary>
@@ -219,6 +554,7 @@ namespace TIBootAndFlash
     {
       ProgramCmdParams myCmdParams =  new ProgramCmdParams();
       Boolean[] argsHandled = new Boolean[args.Length];
+      List<String> portNames = new List<String>();
       Int32 numFiles = -1;
       UInt32 numUnhandledArgs,numHandledArgs=0;
       String s;
@@ -239,9 +575,12 @@ namespace TIBootAndFlash
       myCmdParams.CMDMagicFlag = MagicFlags.MAGIC_NUMBER_INVALID;
       myCmdParams.valid = true;
       myCmdParams.verbose = false;
-      myCmdParams.SerialPortName = null;
+      myCmdParams.SerialPortNames = null;
       myCmdParams.SerialPortBaudRate = 115200;
+      myCmdParams.StubBaudRate = 0;
       
+      myCmdParams.ScriptFileName = null;
+
       myCmdParams.APPMagicFlag = MagicFlags.UBL_MAGIC_SAFE;
       myCmdParams.APPFileName = null;
       myCmdParams.APPLoadAddr = 0xFFFFFFFF;
@@ -317,6 +656,87 @@ namespace TIBootAndFlash
               myCmdParams.UBLFlashType = FlashType.NAND;
               cmdString = "Globally erasing NAND flash.";
               break;
+            case "nandraw":
+              if (myCmdParams.CMDMagicFlag == MagicFlags.MAGIC_NUMBER_INVALID)
+                myCmdParams.CMDMagicFlag = MagicFlags.UBL_MAGIC_NAND_RAW_WRITE;
+              else
+                myCmdParams.valid = false;
+              try
+              {
+                myCmdParams.RawStartBlock = FlashCommand.ParseNumber(args[i + 1]);
+                myCmdParams.RawBlockCount = FlashCommand.ParseNumber(args[i + 2]);
+                argsHandled[i + 1] = true;
+                argsHandled[i + 2] = true;
+                numHandledArgs += 2;
+              }
+              catch (Exception)
+              {
+                myCmdParams.valid = false;
+              }
+              numFiles = 1;
+              myCmdParams.UBLFlashType = FlashType.NAND;
+              cmdString = "Writing NAND blocks " + myCmdParams.RawStartBlock + " to " +
+                          (myCmdParams.RawStartBlock + myCmdParams.RawBlockCount - 1) + " with ";
+              break;
+            case "nandrawerase":
+            case "nandverify":
+            case "nandread":
+              if (myCmdParams.CMDMagicFlag == MagicFlags.MAGIC_NUMBER_INVALID)
+              {
+                Int32 numArgs;
+                myCmdParams.CMDMagicFlag = FlashCommand.FromName(s.Substring(1), out numArgs).CMDMagicFlag;
+              }
+              else
+                myCmdParams.valid = false;
+              try
+              {
+                myCmdParams.RawStartBlock = FlashCommand.ParseNumber(args[i + 1]);
+                myCmdParams.RawBlockCount = FlashCommand.ParseNumber(args[i + 2]);
+                argsHandled[i + 1] = true;
+                argsHandled[i + 2] = true;
+                numHandledArgs += 2;
+                if (myCmdParams.CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_READ)
+                {
+                  myCmdParams.RawByteCount = FlashCommand.ParseNumber(args[i + 3]);
+                  argsHandled[i + 3] = true;
+                  numHandledArgs++;
+                }
+              }
+              catch (Exception)
+              {
+                myCmdParams.valid = false;
+              }
+              myCmdParams.UBLFlashType = FlashType.NAND;
+              cmdString = "NAND blocks " + myCmdParams.RawStartBlock + " to " +
+                          (myCmdParams.RawStartBlock + myCmdParams.RawBlockCount - 1);
+              switch (myCmdParams.CMDMagicFlag)
+              {
+                case MagicFlags.UBL_MAGIC_NAND_RAW_ERASE:
+                  numFiles = 0;
+                  cmdString = "Erasing " + cmdString + ".";
+                  break;
+                case MagicFlags.UBL_MAGIC_NAND_RAW_VERIFY:
+                  numFiles = 1;
+                  cmdString = "Verifying " + cmdString + " against ";
+                  break;
+                default:
+                  numFiles = 1;
+                  cmdString = "Reading " + cmdString + " into ";
+                  break;
+              }
+              break;
+            case "script":
+              if ((myCmdParams.ScriptFileName == null) && ((i + 1) < args.Length))
+              {
+                myCmdParams.ScriptFileName = args[i + 1];
+                argsHandled[i + 1] = true;
+                numHandledArgs++;
+              }
+              else
+                myCmdParams.valid = false;
+              numFiles = 0;
+              cmdString = "Running the commands in " + myCmdParams.ScriptFileName + ".";
+              break;
             default:
               continue;
           }
@@ -328,8 +748,8 @@ namespace TIBootAndFlash
         }
       } // end of for loop for handling dash params
       
-      // Check to make sure a command was selected
-      if (myCmdParams.CMDMagicFlag == MagicFlags.MAGIC_NUMBER_INVALID)
+      // Check to make sure exactly one command or a script was selected
+      if ((myCmdParams.CMDMagicFlag == MagicFlags.MAGIC_NUMBER_INVALID) == (myCmdParams.ScriptFileName == null))
       {
         myCmdParams.valid = false;
         return myCmdParams;
@@ -367,7 +787,11 @@ namespace TIBootAndFlash
                 numHandledArgs++;
                 break;              
               case "p":
-                myCmdParams.SerialPortName = args[i + 1];
+                foreach (String portName in args[i + 1].Split(','))
+                {
+                  if ((portName.Trim().Length != 0) && (!portNames.Contains(portName.Trim())))
+                    portNames.Add(portName.Trim());
+                }
                 argsHandled[i + 1] = true;
                 numHandledArgs++;
                 break;
@@ -376,6 +800,11 @@ namespace TIBootAndFlash
                 argsHandled[i + 1] = true;
                 numHandledArgs++;
                 break;                
+              case "stubbaud":
+                myCmdParams.StubBaudRate = System.Int32.Parse(args[i + 1]);
+                argsHandled[i + 1] = true;
+                numHandledArgs++;
+                break;
               case "v":
                 myCmdParams.verbose = true;
                 break;
@@ -457,20 +886,22 @@ namespace TIBootAndFlash
         myCmdParams.UBLStartAddr = 0x00000100;
       
       //Setup default serial port name
-      if (myCmdParams.SerialPortName == null)
+      if (portNames.Count == 0)
       {
         int p = (int)Environment.OSVersion.Platform;
         if ((p == 4) || (p == 128)) //Check for unix/linux
         {
           Console.WriteLine("Platform is Unix/Linux.");
-          myCmdParams.SerialPortName = "/dev/ttyS0";
+          portNames.Add("/dev/ttyS0");
         }
         else
         {
           Console.WriteLine("Platform is Windows.");
-          myCmdParams.SerialPortName = "COM1";
+          portNames.Add("COM1");
         }
       }
+      myCmdParams.SerialPortNames = portNames.ToArray();
+
         return myCmdParams;
     }
 
@@ -481,6 +912,10 @@ namespace TIBootAndFlash
     /// <returns>Return code: 0 for correct exit, -1 for unexpected exit</returns>
     static Int32 Main(String[] args)
     {
+      FlashImages images;
+      Boolean interactive;
+      Int32 numSucceeded = 0;
+
       // Assumes that in AssemblyInfo.cs, the version is specified as 1.0.* or the like,
       // with only 2 numbers specified;  the next two are generated from the date.
       System.Version v = System.Reflection.Assembly.GetExecutingAssembly().GetName().Version;
@@ -509,55 +944,85 @@ namespace TIBootAndFlash
         Console.Write(cmdString + "\n\n\n");
       }
                              
+      // Load and prepare the images once, no matter how many targets there are
       try
       {
-        Console.WriteLine("Attempting to connect to device " + cmdParams.SerialPortName + "...");
-        MySP = new SerialPort(cmdParams.SerialPortName, cmdParams.SerialPortBaudRate, Parity.None, 8, StopBits.One);
-        MySP.Encoding = Encoding.ASCII;
-        MySP.Open();
+        images = new FlashImages(cmdParams);
       }
       catch(Exception e)
       {
-        if (e is UnauthorizedAccessException)
-        {
-          Console.WriteLine(e.Message);
-          Console.WriteLine("This application failed to open the COM port.");
-          Console.WriteLine("Most likely it is in use by some other application.");
-          return -1;
-        }
         Console.WriteLine(e.Message);
         return -1;
       }
 
+      // A single target keeps the full console output and progress bars,
+      // several targets share the console through a combined status line
+      interactive = (cmdParams.SerialPortNames.Length == 1);
+      sessions = new FlashSession[cmdParams.SerialPortNames.Length];
+      for (int i = 0; i < sessions.Length; i++)
+      {
+        sessions[i] = new FlashSession(cmdParams.SerialPortNames[i], cmdParams, images, interactive);
+        try
+        {
+          Console.WriteLine("Attempting to connect to device " + sessions[i].PortName + "...");
+          sessions[i].Open();
+        }
+        catch(Exception e)
+        {
+          if (e is UnauthorizedAccessException)
+          {
+            Console.WriteLine(e.Message);
+            Console.WriteLine("This application failed to open the COM port.");
+            Console.WriteLine("Most likely it is in use by some other application.");
+          }
+          else
+          {
+            Console.WriteLine(e.Message);
+          }
+          if (interactive)
+            return -1;
+          sessions[i].Status = "Failed to open port";
+        }
+      }
+
       Console.WriteLine("Press any key to end this program at any time.\n");
       
-      // Setup the thread that will actually do all the work of interfacing to
-      // the Device boot ROM.  Start that thread.
-      workerThread = new Thread(new ThreadStart(Program.WorkerThreadStart));
-      workerThread.Start();
-
-      // Wait for a key to terminate the program
-      while ((workerThread.IsAlive) && (!Console.KeyAvailable))
+      // Setup the threads that will actually do all the work of interfacing to
+      // the Device boot ROMs.  Start those threads.
+      activeSessions = sessions.Length;
+      foreach (FlashSession session in sessions)
       {
-        Thread.Sleep(1000);
+        if (session.IsOpen)
+          session.Start();
+        else
+          SessionFinished();
       }
                  
-      // If a key is pressed then abort the worker thread and close the serial port
+      // Wait for the sessions to finish or a key to terminate the program
+      while ((!sessionsDone.WaitOne(interactive ? 1000 : 500, false)) && (!Console.KeyAvailable))
+      {
+        if (!interactive)
+          DispProgress();
+      }
+
+      // If a key is pressed then abort the worker threads and close the serial ports
       try
       {
         if (Console.KeyAvailable)
-        {
           Console.ReadKey();
-          Console.WriteLine("Aborting program...");
-          workerThread.Abort();
+
+        foreach (FlashSession session in sessions)
+        {
+          if (session.IsRunning)
+          {
+            Console.WriteLine("Aborting program...");
+            break;
+          }
         }
-        else if (workerThread.IsAlive)
+        foreach (FlashSession session in sessions)
         {
-          Console.WriteLine("Aborting program...");
-          workerThread.Abort();
+          session.Abort();
         }
-        
-        while ((workerThread.ThreadState & ThreadState.Stopped) != ThreadState.Stopped){}
       }
       catch (Exception e)
       {
@@ -566,8 +1031,20 @@ namespace TIBootAndFlash
         Console.WriteLine(e.Message);
       }
       
-      if (workerThreadSucceeded)
+      foreach (FlashSession session in sessions)
+      {
+        if (session.Succeeded)
+          numSucceeded++;
+      }
+
+      if (!interactive)
+        DispResults();
+
+      if (numSucceeded == sessions.Length)
       {
+        // Clean up any embedded files we extracted
+        EmbeddedFileIO.CleanUpEmbeddedFiles();
+
         Console.WriteLine("\nOperation completed successfully.");
         return 0;
       }
@@ -580,186 +1057,486 @@ namespace TIBootAndFlash
       
     }
 
-    #endregion
-    //**********************************************************************************
-      
-
-    //**********************************************************************************
-    #region Code for UART interfacing thread
+    /// <summary>
+    /// Called by each session when its thread is done
+    /// </summary>
+    public static void SessionFinished()
+    {
+      if (Interlocked.Decrement(ref activeSessions) == 0)
+        sessionsDone.Set();
+    }
 
     /// <summary>
-    /// The main function of the thread where all the cool stuff happens
-    /// to interface with the device
+    /// Rewrite the combined status line for all sessions
     /// </summary>
-    public static void WorkerThreadStart()
+    private static void DispProgress()
     {
-      Boolean status;
-      // Try transmitting the first stage boot-loader (UBL) via the RBL
-      try
-      {      
-        String srchStr;
-        Byte[] imageData;
-        UARTBOOT_Header ackHeader = new UARTBOOT_Header();
-        
-        if (cmdParams.UBLFlashType == FlashType.NAND)
-          srchStr = "sft_"+devString+"_nand.bin";
-        else
-          srchStr = "sft_"+devString+"_nor.bin";
-      
-        // Extract the embedded SLT
-        EmbeddedFileIO.ExtractFile(System.Reflection.Assembly.GetExecutingAssembly(), srchStr, true);
-      
-        // Read the extracted embedded SFT data that we will transmit
-        imageData = FileIO.GetFileData(srchStr);
-        ackHeader.startAddr = 0x0100;   // Default for SFT
-        ackHeader.loadAddr  = 0x0020;   // Not used here, but this what the RBL uses
-        ackHeader.byteCnt   = (UInt32) imageData.Length;
-      
-        TransmitUBL(imageData,ackHeader);
-            
-      }
-      catch (Exception e)
+      Int64 bytesSent = 0, bytesTotal = 0;
+      Int32 numRunning = 0, numPassed = 0, numFailed = 0;
+
+      foreach (FlashSession session in sessions)
       {
-        if (e is ThreadAbortException)
-        {
-          Thread.Sleep(1000);
-        }
+        bytesSent += session.BytesSent;
+        bytesTotal += session.BytesTotal;
+        if (session.IsRunning)
+          numRunning++;
+        else if (session.Succeeded)
+          numPassed++;
         else
-        {
-          Console.WriteLine(e.Message);
-        }
-        return;
+          numFailed++;
       }
 
-      // Sleep in case we need to abort
-      Thread.Sleep(200);
-        
-      // Code to perform specified command
-      try
+      lock (Console.Out)
       {
+        Console.Write("\r {0,3:D}%  {1} active, {2} passed, {3} failed   ",
+          (bytesTotal == 0) ? 0 : (Int32)((bytesSent * 100) / bytesTotal), numRunning, numPassed, numFailed);
+      }
+    }
 
-      BOOTUBLSEQ1:
-        // Clear input buffer so we can start looking for BOOTUBL
-        MySP.DiscardInBuffer();
+    /// <summary>
+    /// Print the per-target result report
+    /// </summary>
+    private static void DispResults()
+    {
+      Int32 numPassed = 0;
 
-        Console.WriteLine("\nWaiting for SFT on the "+devString+"...");
-        
-        // Wait for the SFT on the device to send the ^BOOTUBL\0 sequence
-        if (!SerialIO.waitForSequence("BOOTUBL\0", "BOOTUBL\0", MySP, true))
-          goto BOOTUBLSEQ1;
-        
-        Console.WriteLine("BOOTUBL commmand received. Returning CMD and command...");
+      Console.WriteLine("\n\n{0,-20} {1,-6} {2,10}  {3}", "Port", "Result", "Time (s)", "Last status");
+      Console.WriteLine("{0,-20} {1,-6} {2,10}  {3}", "----", "------", "--------", "-----------");
+      foreach (FlashSession session in sessions)
+      {
+        Console.WriteLine("{0,-20} {1,-6} {2,10:F1}  {3}", session.PortName,
+          session.Succeeded ? "PASS" : "FAIL", session.Elapsed.TotalSeconds, session.Status);
+        if (session.Succeeded)
+          numPassed++;
+      }
+      Console.WriteLine("\n{0} of {1} targets flashed successfully.", numPassed, sessions.Length);
+    }
 
-        // 8 bytes acknowledge sequence = "    CMD\0"
-        MySP.Write("    CMD\0");
-        // 8 bytes of magic number
-        MySP.Write(((UInt32)cmdParams.CMDMagicFlag).ToString("X8"));
-        
-        Console.WriteLine("CMD value sent.  Waiting for DONE...");
-        
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
-          goto BOOTUBLSEQ1;
-        
-        Console.WriteLine("DONE received. Command was accepted.");
+    #endregion
+    //**********************************************************************************
+  }
 
-        // Take appropriate action depending on command
-        switch (cmdParams.CMDMagicFlag)
+  /// <summary>
+  /// Flashing session for one target on one serial port.  All per-target
+  /// state lives here so any number of sessions can run side by side.
+  /// </summary>
+  class FlashSession
+  {
+    //**********************************************************************************
+    #region Class variables and members
+
+    /// <summary>
+    /// Serial Port Object for this target
+    /// </summary>
+    private SerialPort MySP;
+
+    /// <summary>
+    /// Buffered I/O engine driving MySP
+    /// </summary>
+    private SerialEngine MyEngine;
+
+    /// <summary>
+    /// The thread used to actually execute everything for this target
+    /// </summary>
+    private Thread workerThread;
+
+    /// <summary>
+    /// Command line and program parameters (shared)
+    /// </summary>
+    private ProgramCmdParams cmdParams;
+
+    /// <summary>
+    /// Prepared image data (shared)
+    /// </summary>
+    private FlashImages images;
+
+    /// <summary>
+    /// Whether this session owns the console (single target)
+    /// </summary>
+    private Boolean interactive;
+
+    /// <summary>
+    /// Echo flags handed to SerialIO; target output is only shown when interactive
+    /// </summary>
+    private Boolean echo, verbose;
+
+    private ProgressBar progressBar;
+    private Int32 transferBase;
+    private volatile Int32 bytesSent;
+    private Int32 bytesTotal;
+    private volatile Boolean succeeded = false;
+    private volatile String status = "Not started";
+    private DateTime startTime, endTime;
+    private String portName;
+
+    #endregion
+    //**********************************************************************************
+
+
+    //**********************************************************************************
+    #region Public properties and methods
+
+    public String PortName
+    {
+      get { return portName; }
+    }
+
+    public Boolean IsOpen
+    {
+      get { return ((MySP != null) && MySP.IsOpen); }
+    }
+
+    public Boolean IsRunning
+    {
+      get { return ((workerThread != null) && workerThread.IsAlive); }
+    }
+
+    public Boolean Succeeded
+    {
+      get { return succeeded; }
+    }
+
+    public String Status
+    {
+      get { return status; }
+      set { status = value; }
+    }
+
+    public Int32 BytesSent
+    {
+      get { return bytesSent; }
+    }
+
+    public Int32 BytesTotal
+    {
+      get { return bytesTotal; }
+    }
+
+    public TimeSpan Elapsed
+    {
+      get
+      {
+        if (startTime == DateTime.MinValue)
+          return TimeSpan.Zero;
+        return (IsRunning ? DateTime.Now : endTime) - startTime;
+      }
+    }
+
+    public FlashSession(String portName, ProgramCmdParams cmdParams, FlashImages images, Boolean interactive)
+    {
+      this.portName = portName;
+      this.cmdParams = cmdParams;
+      this.images = images;
+      this.interactive = interactive;
+      this.echo = interactive;
+      this.verbose = interactive && cmdParams.verbose;
+
+      // Everything this session will push over the wire, for progress reporting
+      if (images.stubImage != null)
+        bytesTotal = images.stubImage.crcTable.Length + images.stubImage.hexData.Length + images.sftImage.data.Length;
+      else
+        bytesTotal = images.sftImage.crcTable.Length + images.sftImage.hexData.Length;
+      foreach (FlashCommand cmd in images.commands)
+      {
+        if (cmd.ublData != null)
+          bytesTotal += cmd.ublData.Length;
+        if (cmd.appData != null)
+          bytesTotal += cmd.appData.Length;
+      }
+    }
+
+    /// <summary>
+    /// Open the serial port for this target
+    /// </summary>
+    public void Open()
+    {
+      MySP = new SerialPort(portName, cmdParams.SerialPortBaudRate, Parity.None, 8, StopBits.One);
+      MySP.Encoding = Encoding.ASCII;
+      MySP.Open();
+      MyEngine = SerialEngine.GetEngine(MySP);
+    }
+
+    /// <summary>
+    /// Start the worker thread for this target
+    /// </summary>
+    public void Start()
+    {
+      startTime = DateTime.Now;
+      workerThread = new Thread(new ThreadStart(this.WorkerThreadStart));
+      workerThread.IsBackground = true;
+      workerThread.Start();
+    }
+
+    /// <summary>
+    /// Abort the worker thread (if still running) and close the port
+    /// </summary>
+    public void Abort()
+    {
+      if (IsRunning)
+      {
+        workerThread.Abort();
+        workerThread.Join();
+      }
+      if (IsOpen)
+        MySP.Close();
+    }
+
+    #endregion
+    //**********************************************************************************
+
+
+    //**********************************************************************************
+    #region Console output helpers
+
+    private void Log(String msg)
+    {
+      if (interactive)
+      {
+        Console.WriteLine(msg);
+        return;
+      }
+
+      status = msg.Trim();
+      if (cmdParams.verbose)
+      {
+        lock (Console.Out)
         {
-          case MagicFlags.UBL_MAGIC_NAND_FLASH:
-          {
-            status = TransmitUBLandAPP();
-            break;
-          }
-          case MagicFlags.UBL_MAGIC_NOR_FLASH:
-          {
-            status = TransmitUBLandAPP();
-            break;
-          }          
-          case MagicFlags.UBL_MAGIC_NOR_FLASH_NO_UBL:
-          {
-            status = TransmitAPP();
-            break;
-          }
-          case MagicFlags.UBL_MAGIC_NOR_ERASE:
-          {
-            status = TransmitErase();
-            break;
-          }
-          case MagicFlags.UBL_MAGIC_NAND_ERASE:
-          {
-            status = TransmitErase();
-            break;
-          }
-          default:
-          {
-            Console.WriteLine("Command not recognized!");
-            status = false;
-            break;
-          }
+          Console.WriteLine("\r[" + portName + "] " + status);
         }
-        if (!status)
-          goto BOOTUBLSEQ1;
+      }
+    }
+
+    private void BeginTransfer(String text)
+    {
+      transferBase = bytesSent;
+      if (interactive)
+      {
+        progressBar = new ProgressBar();
+        progressBar.Update(0.0,text);
+      }
+      else
+      {
+        status = text;
+      }
+    }
+
+    private void UpdateTransfer(Int32 sent, Int32 total)
+    {
+      bytesSent = transferBase + sent;
+      // EndTransfer completes the bar
+      if ((interactive) && (sent < total))
+        progressBar.Percent = (((Double)sent)/total);
+    }
+
+    private void EndTransfer(Int32 total, String text)
+    {
+      bytesSent = transferBase + total;
+      if (interactive)
+        progressBar.Update(100.0,text);
+      else
+        status = text;
+    }
+
+    #endregion
+    //**********************************************************************************
+      
+
+    //**********************************************************************************
+    #region Code for UART interfacing thread
+
+    /// <summary>
+    /// The main function of the thread where all the cool stuff happens
+    /// to interface with the device
+    /// </summary>
+    private void WorkerThreadStart()
+    {
+      try
+      {      
+        Run();
       }
       catch (Exception e)
       {
         if (e is ThreadAbortException)
         {
+          status = "Aborted";
           Thread.Sleep(1000);
         }
         else
         {
-          Console.WriteLine(e.Message);
+          status = e.Message;
+          if (interactive)
+            Console.WriteLine(e.Message);
         }
-        return;
       }
-        
-      // Wait for ^^^DONE that indicates SFT is exiting and so can this host program
-      if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
-        throw new Exception("Final DONE not returned.  Operation failed.");
-        
-      // Clean up any embedded files we extracted
-      EmbeddedFileIO.CleanUpEmbeddedFiles();
-        
+      finally
+      {
+        endTime = DateTime.Now;
+        Program.SessionFinished();
+      }
+    }
+
+    private void Run()
+    {
+      Boolean firstCmd = true;
+
+      // Try transmitting the first stage boot-loader (UBL) via the RBL
+      if (images.stubImage != null)
+      {
+        // Send the loader stub through the RBL, then let it pull the SFT
+        // over at the higher rate
+        TransmitUBL(images.stubImage, 0x0100);
+        TransmitViaStub(images.sftImage.data, images.sftStubCRC, 0x0100);
+      }
+      else
+      {
+        TransmitUBL(images.sftImage, 0x0100);
+      }
+
+      // Sleep in case we need to abort
+      Thread.Sleep(200);
+
+      // The SFT stays resident and returns to its BOOTUBL prompt after each
+      // command, so the whole list runs over this one connection
+      foreach (FlashCommand cmd in images.commands)
+      {
+        RunCommand(cmd, firstCmd);
+        firstCmd = false;
+      }
+
+      // Tell the SFT the session is over
+      EndSession();
+
       // Everything worked, so change boolean status
-      workerThreadSucceeded = true;
+      status = "Done";
+      succeeded = true;
     }
 
     /// <summary>
-    /// Function to Transmit the UBL via the device ROM Serial boot
+    /// Issue one command to the resident SFT and send its data
     /// </summary>
-    private static void TransmitUBL(Byte[] imageData,UARTBOOT_Header ackHeader)
+    private void RunCommand(FlashCommand cmd, Boolean firstCmd)
     {
-      // Local Variables for building up output
-      StringBuilder UBLsb;
-      CRC32 MyCRC;
-      ProgressBar progressBar;
-      Int32 blockCnt;
+      Boolean result;
 
-      UBLsb = new StringBuilder(imageData.Length * 2);
-      
-      // Read the data from the UBL file into the appropriate structures
-      for (int i=0; i<imageData.Length; i+=sizeof(UInt32))
+    BOOTUBLSEQ1:
+      // Clear input buffer so we can start looking for BOOTUBL (after a
+      // completed command the SFT's next BOOTUBL may already be buffered)
+      if (firstCmd)
+        MyEngine.DiscardInBuffer();
+      // Retries always start from an empty buffer
+      firstCmd = true;
+
+      Log("\nWaiting for SFT on the "+Program.devString+"...");
+
+      // Wait for the SFT on the device to send the ^BOOTUBL\0 sequence
+      if (!MyEngine.WaitForSequence("BOOTUBL\0", "BOOTUBL\0", echo))
+        goto BOOTUBLSEQ1;
+
+      Log("BOOTUBL commmand received. Returning CMD and command...");
+
+      // 8 bytes acknowledge sequence = "    CMD\0"
+      MyEngine.Write("    CMD\0");
+      // 8 bytes of magic number
+      MyEngine.Write(((UInt32)cmd.CMDMagicFlag).ToString("X8"));
+
+      Log("CMD value sent.  Waiting for DONE...");
+
+      if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
+        goto BOOTUBLSEQ1;
+
+      Log("DONE received. Command was accepted.");
+
+      // Take appropriate action depending on command
+      switch (cmd.CMDMagicFlag)
       {
-        UBLsb.AppendFormat("{0:X8}", System.BitConverter.ToUInt32(imageData,i));
+        case MagicFlags.UBL_MAGIC_NAND_FLASH:
+        {
+          result = TransmitUBLandAPP(cmd);
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NOR_FLASH:
+        {
+          result = TransmitUBLandAPP(cmd);
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NOR_FLASH_NO_UBL:
+        {
+          result = TransmitAPP(cmd);
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NOR_ERASE:
+        {
+          result = TransmitErase();
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NAND_ERASE:
+        {
+          result = TransmitErase();
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NAND_RAW_WRITE:
+        {
+          result = TransmitRaw(cmd);
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NAND_RAW_ERASE:
+        {
+          result = TransmitRawErase(cmd);
+          break;
+        }
+        case MagicFlags.UBL_MAGIC_NAND_RAW_VERIFY:
+        case MagicFlags.UBL_MAGIC_NAND_RAW_READ:
+        {
+          result = TransmitRawRead(cmd);
+          break;
+        }
+        default:
+        {
+          Log("Command not recognized!");
+          result = false;
+          break;
+        }
       }
-      
-      // Create CRC object and use it to calculate the UBL file's CRC
-      // Note that this CRC is not quite the standard CRC-32 algorithm
-      // commonly in use since the final register value is not XOR'd
-      // with 0xFFFFFFFF.  As a result the CRC value returned here
-      // will be the bitwise inverse of the standard CRC-32 value.
-      MyCRC = new CRC32(0x04C11DB7, 0xFFFFFFFF, 0x00000000, true, 1, CRCType.ONESHOT, CRCCalcMethod.LUT);
-      ackHeader.crcVal = MyCRC.CalculateCRC(imageData);
-      ackHeader.byteCnt = (UInt32) imageData.Length;
+      if (!result)
+        goto BOOTUBLSEQ1;
+        
+      // Wait for ^^^DONE that indicates the command completed
+      if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
+        throw new Exception("Final DONE not returned.  Operation failed.");
+    }
+
+    /// <summary>
+    /// Send the session exit command so the SFT stops prompting
+    /// </summary>
+    private void EndSession()
+    {
+      Log("\nWaiting for SFT on the "+Program.devString+"...");
 
+      if (!MyEngine.WaitForSequence("BOOTUBL\0", "BOOTUBL\0", echo))
+        throw new Exception("SFT did not return to its prompt.  Operation failed.");
+
+      MyEngine.Write("    CMD\0");
+      MyEngine.Write(((UInt32)MagicFlags.UBL_MAGIC_SESSION_EXIT).ToString("X8"));
+
+      if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
+        throw new Exception("Session exit was not accepted.  Operation failed.");
+
+      Log("Session ended.");
+    }
+
+    /// <summary>
+    /// Function to Transmit the UBL via the device ROM Serial boot
+    /// </summary>
+    private void TransmitUBL(RBLImage image, UInt32 startAddr)
+    {
       try
       {
       BOOTMESEQ:
-        Console.WriteLine("\nWaiting for the "+devString+"...");
+        Log("\nWaiting for the "+Program.devString+"...");
 
         // Wait for the device to send the ^BOOTME/0 sequence
-        if (SerialIO.waitForSequence(" BOOTME\0", " BOOTME\0", MySP, cmdParams.verbose))
-            Console.WriteLine("BOOTME commmand received. Returning ACK and header...");
+        if (MyEngine.WaitForSequence(" BOOTME\0", " BOOTME\0", verbose))
+            Log("BOOTME commmand received. Returning ACK and header...");
         else
             goto BOOTMESEQ;
 
@@ -767,71 +1544,127 @@ namespace TIBootAndFlash
         // 8 bytes acknowledge sequence = "    ACK\0"
 //#if (DM35x_REVB || DM36x_REVA)
 //#if (DM35x_REVB)
-//	MySP.Write("    ACK");
+//	MyEngine.Write("    ACK");
 //#else
-        MySP.Write("    ACK\0");
+        MyEngine.Write("    ACK\0");
 //#endif        
         // 8 bytes of CRC data = ASCII string of 8 hex characters
-        MySP.Write(ackHeader.crcVal.ToString("X8"));
+        MyEngine.Write(image.crcVal.ToString("X8"));
         
         // 4 bytes of UBL data size = ASCII string of 4 hex characters (3800h = 14336d)
-        MySP.Write(ackHeader.byteCnt.ToString("X4"));
+        MyEngine.Write(((UInt32)image.data.Length).ToString("X4"));
         
         // 4 bytes of start address = ASCII string of 4 hex characters (>=0100h)
-        MySP.Write(ackHeader.startAddr.ToString("X4"));
+        MyEngine.Write(startAddr.ToString("X4"));
         
         // 4 bytes of constant zeros = "0000"
-        MySP.Write("0000");
-        Console.WriteLine("ACK command sent. Waiting for BEGIN command... ");
+        MyEngine.Write("0000");
+        Log("ACK command sent. Waiting for BEGIN command... ");
 
         // Wait for the BEGIN sequence
-        if (SerialIO.waitForSequence("  BEGIN\0", " BOOTME\0", MySP,true))
-            Console.WriteLine("BEGIN commmand received. Sending CRC table...");
+        if (MyEngine.WaitForSequence("  BEGIN\0", " BOOTME\0", echo))
+            Log("BEGIN commmand received. Sending CRC table...");
         else
             goto BOOTMESEQ;
 
         // Send the 1024 byte (256 word) CRC table
-        progressBar = new ProgressBar();
-        progressBar.Update(0.0,"Sending CRC table...");
-        for (int i = 0; i < MyCRC.Length; i++)
-        {
-            MySP.Write(MyCRC[i].ToString("x8"));
-            progressBar.Percent = (((Double)(i+1))/MyCRC.Length);
-        }
-        progressBar.Update(100.0,"CRC table sent.");
-        Console.WriteLine("Waiting for DONE...");
+        BeginTransfer("Sending CRC table...");
+        MyEngine.Write(image.crcTable, 0, image.crcTable.Length, new SerialEngine.ProgressHandler(UpdateTransfer));
+        EndTransfer(image.crcTable.Length,"CRC table sent.");
+        Log("Waiting for DONE...");
 
         // Wait for the first DONE sequence
-        if (SerialIO.waitForSequence("   DONE\0", " BOOTME\0", MySP, cmdParams.verbose))
-            Console.WriteLine("DONE received.  Sending the UBL...");
+        if (MyEngine.WaitForSequence("   DONE\0", " BOOTME\0", verbose))
+            Log("DONE received.  Sending the UBL...");
         else
             goto BOOTMESEQ;
 
         // Send the contents of the UBL file (as hex text)
-        progressBar = new ProgressBar();
-        progressBar.Update(0.0,"Sending UBL...");
-        blockCnt = UBLsb.Length/128;
-        for (int i = 0; i < (blockCnt*128); i+=128)
-        {
-          MySP.Write(UBLsb.ToString(i,128));
-          progressBar.Percent = (((Double)(i+1))/UBLsb.Length);
-        }
-        // Write last (possibly partial) block
-        MySP.Write(UBLsb.ToString(blockCnt*128,UBLsb.Length - (blockCnt*128) ));
-        progressBar.Update(100.0,"UBL sent.");
+        BeginTransfer("Sending UBL...");
+        MyEngine.Write(image.hexData, 0, image.hexData.Length, new SerialEngine.ProgressHandler(UpdateTransfer));
+        EndTransfer(image.hexData.Length,"UBL sent.");
 
         // Wait for the second DONE sequence
-        if (SerialIO.waitForSequence("   DONE\0", " BOOTME\0", MySP, cmdParams.verbose))
-            Console.WriteLine("DONE received.  UBL was accepted.");
+        if (MyEngine.WaitForSequence("   DONE\0", " BOOTME\0", verbose))
+            Log("DONE received.  UBL was accepted.");
         else
             goto BOOTMESEQ;
 
-        Console.WriteLine("UBL transmitted successfully.\n");
+        Log("UBL transmitted successfully.\n");
 
       }
       catch (ObjectDisposedException e)
       {
-        Console.WriteLine(e.StackTrace);
+        Log(e.StackTrace);
+        throw e;
+      }
+    }
+    
+    /// <summary>
+    /// Function to transmit an image in binary via the SFT loader stub, which
+    /// the RBL has just started.  The stub raises the UART rate for the data
+    /// and drops back to the original rate before jumping to the image.
+    /// </summary>
+    private void TransmitViaStub(Byte[] imageData, UInt32 crcVal, UInt32 startAddr)
+    {
+      try
+      {
+      STUBSEQ:
+        Log("\nWaiting for the SFT loader stub...");
+
+        // Wait for the stub to send the ^^^STUB/0 sequence
+        if (!MyEngine.WaitForSequence("   STUB\0", "   STUB\0", verbose))
+          goto STUBSEQ;
+        
+        Log("STUB commmand received. Returning ACK and header...");
+        
+        // 8 bytes acknowledge sequence = "    ACK\0"
+        MyEngine.Write("    ACK\0");
+        // 8 bytes each of CRC, data size, entry point and baud rate = ASCII strings of 8 hex characters
+        MyEngine.Write(crcVal.ToString("X8"));
+        MyEngine.Write(((UInt32)imageData.Length).ToString("X8"));
+        MyEngine.Write(startAddr.ToString("X8"));
+        MyEngine.Write(((UInt32)cmdParams.StubBaudRate).ToString("X8"));
+        // 4 bytes of constant zeros = "0000"
+        MyEngine.Write("0000");
+        Log("ACK command sent. Waiting for BEGIN command... ");
+        
+        // A BADCNT or BADBAUD reply won't get better by retrying
+        if (!MyEngine.WaitForSequence("  BEGIN\0", "BAD", echo))
+          throw new Exception("SFT loader stub rejected the image size or baud rate.");
+        
+        // The stub switches rate as soon as BEGIN has left its UART
+        MySP.BaudRate = cmdParams.StubBaudRate;
+        
+        try
+        {
+          // Send the image data in binary
+          BeginTransfer("Sending SFT...");
+          MyEngine.Write(imageData, 0, imageData.Length, new SerialEngine.ProgressHandler(UpdateTransfer));
+          EndTransfer(imageData.Length,"SFT sent.");
+          
+          if (MyEngine.WaitForSequence("   DONE\0", "BAD", verbose))
+          {
+            Log("DONE received.  SFT was accepted.");
+          }
+          else
+          {
+            // Stub reported a CRC mismatch and will announce itself again
+            MySP.BaudRate = cmdParams.SerialPortBaudRate;
+            bytesSent = transferBase;
+            goto STUBSEQ;
+          }
+        }
+        finally
+        {
+          MySP.BaudRate = cmdParams.SerialPortBaudRate;
+        }
+        
+        Log("SFT transmitted successfully.\n");
+      }
+      catch (ObjectDisposedException e)
+      {
+        Log(e.StackTrace);
         throw e;
       }
     }
@@ -842,85 +1675,291 @@ namespace TIBootAndFlash
     /// If the the TI supplied SLT is modified or a different boot loader is
     /// used, this code will need to be modified.
     /// </summary>
-    private static Boolean TransmitImage(Byte[] imageData, UARTBOOT_Header ackHeader)
+    private Boolean TransmitImage(Byte[] imageData, UARTBOOT_Header ackHeader)
     {
-      ProgressBar progressBar;
-      UInt32 blockCnt;
-      
       try
       {
-        Console.WriteLine("Waiting for SENDIMG sequence...");
-        if (!SerialIO.waitForSequence("SENDIMG\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        Log("Waiting for SENDIMG sequence...");
+        if (!MyEngine.WaitForSequence("SENDIMG\0", "BOOTUBL\0", verbose))
           return false;
 
-        Console.WriteLine("SENDIMG received. Returning ACK and header for image data...");
+        Log("SENDIMG received. Returning ACK and header for image data...");
         
         // Output 36 Bytes for the ACK sequence and header
         // 8 bytes acknowledge sequence = "    ACK\0"
-        MySP.Write("    ACK\0");
+        MyEngine.Write("    ACK\0");
         // 8 bytes of magic number
-        MySP.Write(String.Format("{0:X8}", ackHeader.magicNum));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.magicNum));
         // 8 bytes of binary execution address = ASCII string of 8 hex characters
-        MySP.Write(String.Format("{0:X8}", ackHeader.startAddr));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.startAddr));
         // 8 bytes of data size = ASCII string of 8 hex characters
-        MySP.Write(String.Format("{0:X8}", ackHeader.byteCnt));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.byteCnt));
         // 8 bytes of binary load address = ASCII string of 8 hex characters
-        MySP.Write(String.Format("{0:X8}", ackHeader.loadAddr));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.loadAddr));
         // 4 bytes of constant zeros = "0000"
-        MySP.Write("0000");
+        MyEngine.Write("0000");
 
-        Console.WriteLine("ACK command sent. Waiting for BEGIN command... ");
+        Log("ACK command sent. Waiting for BEGIN command... ");
 
         // Wait for the ^^BEGIN\0 sequence
-        if (!SerialIO.waitForSequence("  BEGIN\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        if (!MyEngine.WaitForSequence("  BEGIN\0", "BOOTUBL\0", verbose))
           return false;
           
-        Console.WriteLine("BEGIN commmand received.");
+        Log("BEGIN commmand received.");
 
         // Send the image data
-        progressBar = new ProgressBar();
-        progressBar.Update(0.0,"Sending Image data...");
-        blockCnt = ackHeader.byteCnt/128;
-        for (int i = 0; i < (blockCnt*128); i+=128)
-        {
-          MySP.Write(imageData, i, 128);
-          progressBar.Percent = (((Double)(i+1))/ackHeader.byteCnt);
-        }
-        // Write last (possibly partial) block
-        MySP.Write(imageData, (Int32) (blockCnt*128),(Int32) (ackHeader.byteCnt - (blockCnt*128)) );
-        progressBar.Update(100.0,"Image data sent.");
+        BeginTransfer("Sending Image data...");
+        MyEngine.Write(imageData, 0, (Int32) ackHeader.byteCnt, new SerialEngine.ProgressHandler(UpdateTransfer));
+        EndTransfer((Int32) ackHeader.byteCnt,"Image data sent.");
         
-        Console.WriteLine("Waiting for DONE...");
+        Log("Waiting for DONE...");
 
         // Wait for first ^^^DONE\0 to indicate data received
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", verbose))
           return false;
           
-        Console.WriteLine("DONE received.  All bytes of image data received...");
+        Log("DONE received.  All bytes of image data received...");
       }
       catch (ObjectDisposedException e)
       {
-        Console.WriteLine(e.StackTrace);
+        Log(e.StackTrace);
         throw e;
       }
       return true;
     }    
 
+    /// <summary>
+    /// Function to stream a raw image into a range of NAND blocks.  The SFT
+    /// asks for one erase block of data at a time, once it has found and
+    /// erased a good block for it, so bad blocks are skipped on the target.
+    /// </summary>
+    private Boolean TransmitRaw(FlashCommand cmd)
+    {
+      Byte[] countData = new Byte[8];
+      Int32 sent = 0, count;
+
+      try
+      {
+        Log("Waiting for SENDIMG sequence...");
+        if (!MyEngine.WaitForSequence("SENDIMG\0", "BOOTUBL\0", verbose))
+          return false;
+
+        Log("SENDIMG received. Returning ACK and partition for raw image...");
+
+        // 8 bytes acknowledge sequence = "    ACK\0"
+        MyEngine.Write("    ACK\0");
+        // 8 bytes each of start block, block limit and image length
+        MyEngine.Write(String.Format("{0:X8}", cmd.RawStartBlock));
+        MyEngine.Write(String.Format("{0:X8}", cmd.RawBlockCount));
+        MyEngine.Write(String.Format("{0:X8}", cmd.appData.Length));
+        // 4 bytes of constant zeros = "0000"
+        MyEngine.Write("0000");
+
+        Log("ACK command sent. Waiting for BEGIN command... ");
+
+        if (!MyEngine.WaitForSequence("  BEGIN\0", "BOOTUBL\0", verbose))
+          return false;
+
+        BeginTransfer("Writing raw image to NAND...");
+        while (sent < cmd.appData.Length)
+        {
+          Int32 blockBase = sent;
+
+          // ^SENDBLK\0 is followed by the byte count wanted, as 8 hex characters
+          if (!MyEngine.WaitForSequence("SENDBLK\0", "BOOTUBL\0", verbose))
+            return false;
+          MyEngine.Read(countData, 0, 8);
+          count = Int32.Parse(Encoding.ASCII.GetString(countData), NumberStyles.AllowHexSpecifier);
+          if ((count <= 0) || (count > (cmd.appData.Length - sent)))
+            throw new Exception("SFT requested an invalid block length (" + count + ").");
+
+          MyEngine.Write(cmd.appData, sent, count, delegate(Int32 bytesDone, Int32 bytesTotal)
+          {
+            UpdateTransfer(blockBase + bytesDone, cmd.appData.Length);
+          });
+          sent += count;
+        }
+        EndTransfer(cmd.appData.Length, "Raw image sent.");
+
+        // ^^^DONE\0 that indicates that the image is in flash
+        status = "Writing last block to flash...";
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
+          return false;
+      }
+      catch (ObjectDisposedException e)
+      {
+        Log(e.StackTrace);
+        throw e;
+      }
+      return true;
+    }
+
+    /// <summary>
+    /// Send the partition for a raw command: start block, block limit and
+    /// image length (zero when there is no image)
+    /// </summary>
+    private Boolean SendRawHeader(FlashCommand cmd, UInt32 byteCnt)
+    {
+      Log("Waiting for SENDIMG sequence...");
+      if (!MyEngine.WaitForSequence("SENDIMG\0", "BOOTUBL\0", verbose))
+        return false;
+
+      Log("SENDIMG received. Returning ACK and partition...");
+
+      // 8 bytes acknowledge sequence = "    ACK\0"
+      MyEngine.Write("    ACK\0");
+      // 8 bytes each of start block, block limit and image length
+      MyEngine.Write(String.Format("{0:X8}", cmd.RawStartBlock));
+      MyEngine.Write(String.Format("{0:X8}", cmd.RawBlockCount));
+      MyEngine.Write(String.Format("{0:X8}", byteCnt));
+      // 4 bytes of constant zeros = "0000"
+      MyEngine.Write("0000");
+
+      Log("ACK command sent. Waiting for BEGIN command... ");
+
+      return MyEngine.WaitForSequence("  BEGIN\0", "BOOTUBL\0", verbose);
+    }
+
+    /// <summary>
+    /// Erase the good blocks of a range of NAND blocks
+    /// </summary>
+    private Boolean TransmitRawErase(FlashCommand cmd)
+    {
+      try
+      {
+        if (!SendRawHeader(cmd, 0))
+          return false;
+
+        status = "Erasing...";
+
+        // ^^^DONE\0 that indicates the partition is erased
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
+          return false;
+      }
+      catch (ObjectDisposedException e)
+      {
+        Log(e.StackTrace);
+        throw e;
+      }
+      return true;
+    }
+
+    /// <summary>
+    /// Read a raw image back from a range of NAND blocks.  The SFT skips bad
+    /// blocks just as it does when writing, and reports the standard CRC-32
+    /// of what it read.  To verify, that CRC is compared with the image file's;
+    /// to read back, the data is also sent (one erase block per DATABLK) and
+    /// saved once its CRC checks out.
+    /// </summary>
+    private Boolean TransmitRawRead(FlashCommand cmd)
+    {
+      Boolean readBack = (cmd.CMDMagicFlag == MagicFlags.UBL_MAGIC_NAND_RAW_READ);
+      UInt32 byteCnt = readBack ? cmd.RawByteCount : (UInt32) cmd.appData.Length;
+      Byte[] hexData = new Byte[16];
+      Byte[] data = null;
+      Int32 received = 0, count;
+      UInt32 targetCRC, eccErrors, hostCRC;
+      CRC32 MyCRC;
+
+      try
+      {
+        if (!SendRawHeader(cmd, byteCnt))
+          return false;
+
+        if (readBack)
+        {
+          data = new Byte[byteCnt];
+          BeginTransfer("Reading raw image from NAND...");
+          while (received < data.Length)
+          {
+            // ^DATABLK\0 is followed by the byte count sent, as 8 hex characters
+            if (!MyEngine.WaitForSequence("DATABLK\0", "BOOTUBL\0", verbose))
+              return false;
+            MyEngine.Read(hexData, 0, 8);
+            count = Int32.Parse(Encoding.ASCII.GetString(hexData, 0, 8), NumberStyles.AllowHexSpecifier);
+            if ((count <= 0) || (count > (data.Length - received)))
+              throw new Exception("SFT sent an invalid block length (" + count + ").");
+
+            MyEngine.Read(data, received, count);
+            received += count;
+            UpdateTransfer(received, data.Length);
+          }
+          EndTransfer(data.Length, "Raw image received.");
+        }
+        else
+        {
+          status = "Reading raw image from NAND...";
+        }
+
+        // ^^CRC32\0 is followed by the CRC and the count of pages with
+        // uncorrectable ECC errors, each as 8 hex characters
+        if (!MyEngine.WaitForSequence("  CRC32\0", "BOOTUBL\0", verbose))
+          return false;
+        MyEngine.Read(hexData, 0, 16);
+        targetCRC = UInt32.Parse(Encoding.ASCII.GetString(hexData, 0, 8), NumberStyles.AllowHexSpecifier);
+        eccErrors = UInt32.Parse(Encoding.ASCII.GetString(hexData, 8, 8), NumberStyles.AllowHexSpecifier);
+
+        MyCRC = new CRC32(0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, 1, CRCType.ONESHOT, CRCCalcMethod.LUT);
+        hostCRC = MyCRC.CalculateCRC(readBack ? data : cmd.appData);
+
+        if (readBack)
+        {
+          if (hostCRC != targetCRC)
+            throw new Exception("Raw image read back was corrupted on the serial link (CRC mismatch).");
+          FileIO.SetFileData(ReadBackFileName(cmd.RawOutFileName), data, true);
+          Log("Raw image saved to " + ReadBackFileName(cmd.RawOutFileName) + ".");
+        }
+        else if (hostCRC != targetCRC)
+        {
+          throw new Exception(String.Format("Verify failed: NAND CRC is 0x{0:X8}, {1} CRC is 0x{2:X8}.",
+                                            targetCRC, cmd.APPFileName, hostCRC));
+        }
+        if (eccErrors != 0)
+          throw new Exception(eccErrors + " page(s) had uncorrectable ECC errors.");
+
+        if (!readBack)
+          Log("Verify passed (CRC-32 0x" + hostCRC.ToString("X8") + ").");
+
+        // ^^^DONE\0 that indicates the read is complete
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
+          return false;
+      }
+      catch (ObjectDisposedException e)
+      {
+        Log(e.StackTrace);
+        throw e;
+      }
+      return true;
+    }
+
+    /// <summary>
+    /// Name of the read-back file for this target; each board gets its own
+    /// when several are run at once
+    /// </summary>
+    private String ReadBackFileName(String fileName)
+    {
+      if (interactive)
+        return fileName;
+      return fileName + "." + Path.GetFileName(portName);
+    }
+
     /// <summary>
     /// Send command and wait for erase response. (NOR and NAND global erase)
     /// </summary>
-    private static Boolean TransmitErase()
+    private Boolean TransmitErase()
     {
       try
       {
+        status = "Erasing...";
+
         // ^^^DONE\0 that indicates command was executed successfully
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
           return false;
 
       }
       catch (ObjectDisposedException e)
       {
-        Console.WriteLine(e.StackTrace);
+        Log(e.StackTrace);
         throw e;
       }
       return true;
@@ -929,33 +1968,32 @@ namespace TIBootAndFlash
     /// <summary>
     /// Function to transmit the UBL and application for flash
     /// </summary>
-    private static Boolean TransmitAPP()
+    private Boolean TransmitAPP(FlashCommand cmd)
     {         
-      Byte[] imageData;
       UARTBOOT_Header ackHeader = new UARTBOOT_Header();
 
       try
       {          
         // Now Send the application image that will be written to flash
-        Console.WriteLine("Sending the Application image");
-        imageData = FileIO.GetFileData(cmdParams.APPFileName);
+        Log("Sending the Application image");
         ackHeader.magicNum = ((UInt32)MagicFlags.UBL_MAGIC_BIN_IMG);
         ackHeader.startAddr = cmdParams.APPStartAddr;
-        ackHeader.byteCnt = (UInt32) imageData.Length;
+        ackHeader.byteCnt = (UInt32) cmd.appData.Length;
         ackHeader.loadAddr = cmdParams.APPLoadAddr;
         
-        if (!TransmitImage(imageData, ackHeader))
+        if (!TransmitImage(cmd.appData, ackHeader))
           return false;
         
         // ^^^DONE\0 that indicates that application flashing is complete
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
+        status = "Writing application to flash...";
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
           return false;
           
         return true;
       }
       catch (ObjectDisposedException e)
       {
-        Console.WriteLine(e.StackTrace);
+        Log(e.StackTrace);
         throw e;
       }
     }
@@ -964,49 +2002,48 @@ namespace TIBootAndFlash
     /// <summary>
     /// Function to transmit the UBL and application for flash
     /// </summary>
-    private static Boolean TransmitUBLandAPP()
+    private Boolean TransmitUBLandAPP(FlashCommand cmd)
     {         
-      Byte[] imageData;
       UARTBOOT_Header ackHeader = new UARTBOOT_Header();
 
       try
       {   
         // First send the UBL image that will be written to flash\
-        Console.WriteLine("Sending the UBL image");
-        imageData = FileIO.GetFileData(cmdParams.UBLFileName);
+        Log("Sending the UBL image");
         ackHeader.magicNum = (UInt32)cmdParams.UBLMagicFlag;
         ackHeader.startAddr = cmdParams.UBLStartAddr;
-        ackHeader.byteCnt = (UInt32) imageData.Length;
+        ackHeader.byteCnt = (UInt32) cmd.ublData.Length;
         ackHeader.loadAddr = 0x0020;    // Not used here, but this is what RBL assumes
         
         // Actually transmit the data
-        if (!TransmitImage(imageData, ackHeader))
+        if (!TransmitImage(cmd.ublData, ackHeader))
           return false;
         
         // ^^^DONE\0 that indicates that UBL flashing is complete
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
+        status = "Writing UBL to flash...";
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
           return false;
         
         // Now Send the application image that will be written to flash
-        Console.WriteLine("Sending the Application image");
-        imageData = FileIO.GetFileData(cmdParams.APPFileName);
+        Log("Sending the Application image");
         ackHeader.magicNum = ((UInt32)MagicFlags.UBL_MAGIC_BIN_IMG);
         ackHeader.startAddr = cmdParams.APPStartAddr;
-        ackHeader.byteCnt = (UInt32) imageData.Length;
+        ackHeader.byteCnt = (UInt32) cmd.appData.Length;
         ackHeader.loadAddr = cmdParams.APPLoadAddr;
         
-        if (!TransmitImage(imageData, ackHeader))
+        if (!TransmitImage(cmd.appData, ackHeader))
           return false;
         
         // ^^^DONE\0 that indicates that application flashing is complete
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
+        status = "Writing application to flash...";
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", echo))
           return false;
           
         return true;
       }
       catch (ObjectDisposedException e)
       {
-        Console.WriteLine(e.StackTrace);
+        Log(e.StackTrace);
         throw e;
       }
     }
@@ -63,8 +63,13 @@ extern far "c" {
 #define UBL_MAGIC_NOR_ERASE         (0xA1ACEDAA)		/* Download via UART & erase the NOR Flash */
 #define UBL_MAGIC_NAND_FLASH        (0xA1ACEDCC)		/* Download via UART & Flash NAND with UBL and U-boot */
 #define UBL_MAGIC_NAND_ERASE        (0xA1ACEDDD)		/* Download via UART & erase the NAND Flash */
+#define UBL_MAGIC_NAND_RAW_WRITE    (0xA1ACED88)		/* Download via UART & write a raw image to a range of NAND blocks */
+#define UBL_MAGIC_NAND_RAW_ERASE    (0xA1ACED89)		/* Erase the good blocks of a range of NAND blocks */
+#define UBL_MAGIC_NAND_RAW_VERIFY   (0xA1ACED8A)		/* Return the CRC-32 of a raw image read from a range of NAND blocks */
+#define UBL_MAGIC_NAND_RAW_READ     (0xA1ACED8B)		/* Read a raw image from a range of NAND blocks back over UART */
 #define UBL_MAGIC_SDMMC_FLASH       (0xA1ACEDEE)    /* Download via UART & Burn SD/MMC with UBL and U-boot */
 #define UBL_MAGIC_SDMMC_ERASE       (0xA1ACEDFF)    /* Download via UART erase the SD/MMC Flash */        
+#define UBL_MAGIC_SESSION_EXIT      (0xA1ACEDBB)    /* End the resident UART session */
 
 // Define max UBL image size (DRAM size - 2048)
 #define UBL_IMAGE_SIZE              (((Uint32)&DRAMSize) - 0x800)
@@ -0,0 +1,63 @@
+/* --------------------------------------------------------------------------
+  FILE        : stub.h
+  PROJECT     : TI Booting and Flashing Utilities
+  DESC        : Serial Flasher Target loader stub header file
+ ----------------------------------------------------------------------------- */
+
+#ifndef _STUB_H_
+#define _STUB_H_
+
+#include "tistdtypes.h"
+
+// Prevent C++ name mangling
+#ifdef __cplusplus
+extern far "c" {
+#endif
+
+/***********************************************************
+* Global Macro Declarations                                *
+***********************************************************/
+
+// Reference clock of the UART baud generator (override in device.h if the
+// UART is not clocked from the main oscillator)
+#if !defined(DEVICE_UART0_CLK_FREQ)
+  #define DEVICE_UART0_CLK_FREQ   (DEVICE_OSC_FREQ)
+#endif
+
+// Largest relative baud rate error accepted, as a right shift of the clock (1/32 ~ 3%)
+#define STUB_BAUD_ERROR_SHIFT     (5)
+
+// Delay before re-announcing the stub so the host can restore its baud rate
+#define STUB_RETRY_DELAY          (0x00100000)
+
+
+/***********************************************************
+* Global Typedef declarations                              *
+***********************************************************/
+
+typedef struct _STUB_HEADER_
+{
+  Uint32      crcVal;
+  Uint32      byteCnt;
+  Uint32      startAddr;
+  Uint32      baudRate;
+}
+STUB_HeaderObj,*STUB_HeaderHandle;
+
+
+/***********************************************************
+* Global Function Declarations                             *
+***********************************************************/
+
+extern void main( void );
+
+
+/***********************************************************
+* End file                                                 *
+***********************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_STUB_H_
@@ -0,0 +1,293 @@
+/* --------------------------------------------------------------------------
+  FILE        : stub.c
+  PROJECT     : TI Booting and Flashing Utilities
+  DESC        : Minimal first stage loader for the serial flasher target.
+                The stub is small enough that sending it through the slow
+                ASCII-hex RBL protocol is cheap.  Once running it raises the
+                UART baud rate and pulls the real SFT (or SLT) image over in
+                binary, then jumps to it.
+ ----------------------------------------------------------------------------- */
+
+// General type include
+#include "tistdtypes.h"
+
+// Device specific CSL
+#include "device.h"
+
+// This module's header file
+#include "stub.h"
+
+
+/************************************************************
+* Explicit External Declarations                            *
+************************************************************/
+
+extern __FAR__ Uint32 STUBLoadStart, STUBLoadEnd;
+
+
+/************************************************************
+* Local Macro Declarations                                  *
+************************************************************/
+
+
+/************************************************************
+* Local Typedef Declarations                                *
+************************************************************/
+
+
+/************************************************************
+* Local Function Declarations                               *
+************************************************************/
+
+static void   LOCAL_sendSequence(String s);
+static Uint8  LOCAL_recvByte(void);
+static Uint32 LOCAL_checkSequence(String s, Bool includeNull);
+static Uint32 LOCAL_recvHexInt(void);
+static Uint32 LOCAL_calcDivisor(Uint32 baudRate);
+static void   LOCAL_setDivisor(Uint32 divisor);
+static Uint32 LOCAL_calcCRC32(Uint8 *data, Uint32 size);
+static void   LOCAL_delay(Uint32 loopcnt);
+
+
+/************************************************************
+* Local Variable Definitions                                *
+************************************************************/
+
+
+/************************************************************
+* Global Variable Definitions                               *
+************************************************************/
+
+
+/************************************************************
+* Global Function Definitions                               *
+************************************************************/
+
+// Main entry point
+void main(void)
+{
+  STUB_HeaderObj  stubHeader;
+  Uint32          origDivisor, divisor, maxByteCnt, i;
+  Uint8           *imageBuff;
+  void            (*entry)(void);
+
+  // Wait until the RBL is done using the UART.
+  while((UART0->LSR & 0x40) == 0 );
+
+  // Remember the divisor the RBL programmed so we can go back to it
+  UART0->LCR |= 0x80;
+  origDivisor = (UART0->DLL & 0xFF) | ((UART0->DLH & 0xFF) << 8);
+  UART0->LCR &= ~0x80;
+
+  // Images land where the RBL would have put them (written through the data
+  // side alias) and are limited to the space below the relocated stub
+  imageBuff  = (Uint8 *) &STUBLoadStart;
+  maxByteCnt = ((Uint32)&STUBLoadEnd) - ((Uint32)&STUBLoadStart);
+
+  while (1)
+  {
+    // Stub sends '   STUB/0'
+    LOCAL_sendSequence("   STUB");
+
+    // Recv ACK command followed by the header
+    if (LOCAL_checkSequence("    ACK", TRUE) != E_PASS)
+      continue;
+
+    stubHeader.crcVal    = LOCAL_recvHexInt();
+    stubHeader.byteCnt   = LOCAL_recvHexInt();
+    stubHeader.startAddr = LOCAL_recvHexInt();
+    stubHeader.baudRate  = LOCAL_recvHexInt();
+    if (LOCAL_checkSequence("0000", FALSE) != E_PASS)
+      continue;
+
+    // Verify that the data size is appropriate
+    if ((stubHeader.byteCnt == 0) || (stubHeader.byteCnt > maxByteCnt))
+    {
+      LOCAL_sendSequence(" BADCNT");
+      continue;
+    }
+
+    // A baud rate of zero means stay at the current rate
+    if (stubHeader.baudRate == 0)
+    {
+      divisor = origDivisor;
+    }
+    else
+    {
+      divisor = LOCAL_calcDivisor(stubHeader.baudRate);
+      if (divisor == 0)
+      {
+        LOCAL_sendSequence("BADBAUD");
+        continue;
+      }
+    }
+
+    // Send BEGIN at the old rate, then switch once it has left the shifter
+    LOCAL_sendSequence("  BEGIN");
+    while((UART0->LSR & 0x40) == 0 );
+    LOCAL_setDivisor(divisor);
+
+    // Receive the raw binary image
+    for (i = 0; i < stubHeader.byteCnt; i++)
+    {
+      imageBuff[i] = LOCAL_recvByte();
+    }
+
+    if (LOCAL_calcCRC32(imageBuff, stubHeader.byteCnt) != stubHeader.crcVal)
+    {
+      LOCAL_sendSequence(" BADCRC");
+      while((UART0->LSR & 0x40) == 0 );
+      LOCAL_setDivisor(origDivisor);
+      LOCAL_delay(STUB_RETRY_DELAY);
+      continue;
+    }
+
+    // Return DONE at the new rate, then fall back to the rate the image expects
+    LOCAL_sendSequence("   DONE");
+    while((UART0->LSR & 0x40) == 0 );
+    LOCAL_setDivisor(origDivisor);
+    break;
+  }
+
+  // Invalidate the I-cache since the code under the stub was just replaced
+  asm(" MOV r0, #0");
+  asm(" MCR p15,#0,r0,c7,c5,#0");
+
+  // Jump to entry point of the downloaded image
+  entry = (void (*)(void)) stubHeader.startAddr;
+  (*entry)();
+}
+
+
+/************************************************************
+* Local Function Definitions                                *
+************************************************************/
+
+// Send a string including its null terminator
+static void LOCAL_sendSequence(String s)
+{
+  Uint32 i = 0;
+
+  do
+  {
+    while (((UART0->LSR) & 0x20) == 0);
+    (UART0->THR) = s[i];
+  }
+  while (s[i++] != 0);
+}
+
+static Uint8 LOCAL_recvByte(void)
+{
+  while (((UART0->LSR) & 0x01) == 0);
+  return (Uint8) ((UART0->RBR) & 0xFF);
+}
+
+// Receive a string, optionally including its null terminator
+static Uint32 LOCAL_checkSequence(String s, Bool includeNull)
+{
+  Uint32 i = 0;
+
+  while (s[i] != 0)
+  {
+    if (LOCAL_recvByte() != (Uint8) s[i++])
+      return E_FAIL;
+  }
+
+  if (includeNull && (LOCAL_recvByte() != 0))
+    return E_FAIL;
+
+  return E_PASS;
+}
+
+// Receive 8 ASCII hex characters as one 32-bit value
+static Uint32 LOCAL_recvHexInt(void)
+{
+  Uint32 i, temp, value = 0;
+
+  for (i = 0; i < 8; i++)
+  {
+    // Converting ascii to Hex
+    temp = LOCAL_recvByte() - 48;
+    if (temp > 22)      // To support lower case a,b,c,d,e,f
+      temp = temp - 39;
+    else if (temp > 9)  // To support upper case A,B,C,D,E,F
+      temp = temp - 7;
+    value = (value << 4) | (temp & 0xF);
+  }
+  return value;
+}
+
+// Nearest divisor for the requested rate, or 0 if the rate can't be hit
+// closely enough.  No hardware divide on the ARM926, so subtract instead.
+static Uint32 LOCAL_calcDivisor(Uint32 baudRate)
+{
+  Uint32 divisor = 0, rem, step, actual;
+
+  if ((baudRate == 0) || (baudRate > (DEVICE_UART0_CLK_FREQ / DEVICE_UART0_OVERSAMPLE_CNT)))
+    return 0;
+
+  step = baudRate * DEVICE_UART0_OVERSAMPLE_CNT;
+  rem  = DEVICE_UART0_CLK_FREQ + (step >> 1);
+  while (rem >= step)
+  {
+    rem -= step;
+    divisor++;
+  }
+
+  if ((divisor == 0) || (divisor > 0xFFFF))
+    return 0;
+
+  // Reject rates the divider can't get within tolerance of
+  actual = divisor * step;
+  if (actual > DEVICE_UART0_CLK_FREQ)
+    actual = actual - DEVICE_UART0_CLK_FREQ;
+  else
+    actual = DEVICE_UART0_CLK_FREQ - actual;
+  if (actual > (DEVICE_UART0_CLK_FREQ >> STUB_BAUD_ERROR_SHIFT))
+    return 0;
+
+  return divisor;
+}
+
+static void LOCAL_setDivisor(Uint32 divisor)
+{
+  // Divisor latch access works for both the shared and dedicated DLL/DLH maps
+  UART0->LCR |= 0x80;
+  UART0->DLL = (divisor & 0xFF);
+  UART0->DLH = ((divisor >> 8) & 0xFF);
+  UART0->LCR &= ~0x80;
+
+  // Enable and clear the FIFOs so back-to-back bytes at high rates aren't lost
+  UART0->FCR = 0x0007;
+}
+
+// CRC-32 (reflected, init xor val = 0xFFFFFFFF, final xor val = 0xFFFFFFFF),
+// computed bitwise to avoid the 1 KB table
+static Uint32 LOCAL_calcCRC32(Uint8 *data, Uint32 size)
+{
+  Uint32 i, j, crc = 0xFFFFFFFF;
+
+  for (i = 0; i < size; i++)
+  {
+    crc ^= data[i];
+    for (j = 0; j < 8; j++)
+    {
+      crc = (crc >> 1) ^ ((crc & 0x1) ? 0xEDB88320 : 0x0);
+    }
+  }
+  return (crc ^ 0xFFFFFFFF);
+}
+
+static void LOCAL_delay(Uint32 loopcnt)
+{
+  Uint32 i;
+  for (i = 0; i < loopcnt; i++)
+  {
+    asm("   NOP");
+  }
+}
+
+
+/************************************************************
+* End file                                                  *
+************************************************************/
@@ -58,6 +58,17 @@ extern __FAR__ Uint32 DRAMSize;
 * Local Typedef Declarations                                *
 ************************************************************/
 
+#if defined(UBL_NAND)
+// Description of a raw image to be written to a range of NAND blocks
+typedef struct _UARTBOOT_RAW_HEADER_
+{
+  Uint32      startBlock;   // First block of the partition
+  Uint32      blockCnt;     // Blocks in the partition, bad ones included
+  Uint32      byteCnt;      // Length of the image
+}
+UARTBOOT_RawHeaderObj, *UARTBOOT_RawHeaderHandle;
+#endif
+
 
 /************************************************************
 * Local Function Declarations                               *
@@ -69,6 +80,11 @@ static Uint32 LOCAL_recvHeaderAndData(UARTBOOT_HeaderHandle ackHeader);
 #if defined(UBL_NAND)
   //static Uint32 LOCAL_NANDWriteHeaderAndData(NAND_InfoHandle hNandInfo, Uint32 startBlock, Uint32 endBlock, NANDBOOT_HeaderHandle nandBoot, Uint8 *srcBuf);
   static Uint32 LOCAL_NANDWriteHeaderAndData(NAND_InfoHandle hNandInfo, NANDBOOT_HeaderHandle nandBoot, Uint8 *srcBuf);
+  static Uint32 LOCAL_recvRawHeader(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader, Bool hasImage);
+  static Uint32 LOCAL_NANDWriteRaw(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader);
+  static Uint32 LOCAL_NANDEraseRaw(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader);
+  static Uint32 LOCAL_NANDReadRaw(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader, Bool sendData);
+  static Uint32 *LOCAL_makeCRC32Table(void);
 #endif
 
 /************************************************************
@@ -94,6 +110,7 @@ Uint32 UARTBOOT_copy(void)
 #if defined(UBL_NAND)
   NANDBOOT_HeaderObj  nandBoot;
   NAND_InfoHandle     hNandInfo;
+  UARTBOOT_RawHeaderObj rawHeader;
 #elif defined(UBL_NOR)
   NORBOOT_HeaderObj   norBoot;
   NOR_InfoHandle      hNorInfo;
@@ -102,6 +119,10 @@ Uint32 UARTBOOT_copy(void)
   Uint32              bootCmd;
 
 UART_tryAgain:
+  // Each command starts with an empty heap, since the SFT stays resident
+  // and serves commands until the host ends the session
+  UTIL_setCurrMemPtr(0);
+
   DEBUG_printString("Starting UART Boot...\r\n");
 
   // UBL Sends 'BOOTUBL/0'
@@ -118,6 +139,11 @@ UART_tryAgain:
 
   switch(bootCmd)
   {
+    case UBL_MAGIC_SESSION_EXIT:
+    {
+      // Command acceptance was the only response expected
+      return E_PASS;
+    }
 #if defined(UBL_NOR)
     case UBL_MAGIC_NOR_FLASH_NO_UBL:
     {
@@ -373,6 +399,81 @@ UART_tryAgain:
       gEntryPoint = 0x0; 
       break;
     }
+    case UBL_MAGIC_NAND_RAW_WRITE:
+    {
+      // Initialize the NAND Flash
+      hNandInfo = NAND_open((Uint32)&EMIFStart, (Uint8) DEVICE_emifBusWidth() );
+      if ( hNandInfo ==  NULL )
+      {
+        DEBUG_printString("NAND_open() failed!");
+        goto UART_tryAgain;
+      }
+
+      // Buffer for verifying written pages
+      hNandReadBuf = UTIL_allocMem(hNandInfo->dataBytesPerPage);
+
+      // Get the partition and image description
+      if (LOCAL_recvRawHeader(hNandInfo, &rawHeader, TRUE) != E_PASS)
+        goto UART_tryAgain;
+
+      // Stream the image into the partition, one erase block at a time
+      DEBUG_printString("Writing raw image to NAND flash\r\n");
+      if (LOCAL_NANDWriteRaw(hNandInfo, &rawHeader) != E_PASS)
+      {
+        DEBUG_printString("Writing failed!");
+        goto UART_tryAgain;
+      }
+
+      // Return DONE when the image has been written
+      if ( LOCAL_sendSequence("   DONE") != E_PASS )
+        return E_FAIL;
+
+      // Set the entry point to nowhere, since there isn't an appropriate binary image to run
+      gEntryPoint = 0x0;
+      break;
+    }
+    case UBL_MAGIC_NAND_RAW_ERASE:
+    case UBL_MAGIC_NAND_RAW_VERIFY:
+    case UBL_MAGIC_NAND_RAW_READ:
+    {
+      Uint32 status;
+
+      // Initialize the NAND Flash
+      hNandInfo = NAND_open((Uint32)&EMIFStart, (Uint8) DEVICE_emifBusWidth() );
+      if ( hNandInfo ==  NULL )
+      {
+        DEBUG_printString("NAND_open() failed!");
+        goto UART_tryAgain;
+      }
+
+      // Get the partition, and the image length to verify or read back
+      if (LOCAL_recvRawHeader(hNandInfo, &rawHeader, (bootCmd != UBL_MAGIC_NAND_RAW_ERASE)) != E_PASS)
+        goto UART_tryAgain;
+
+      if (bootCmd == UBL_MAGIC_NAND_RAW_ERASE)
+      {
+        DEBUG_printString("Erasing NAND partition\r\n");
+        status = LOCAL_NANDEraseRaw(hNandInfo, &rawHeader);
+      }
+      else
+      {
+        DEBUG_printString("Reading raw image from NAND flash\r\n");
+        status = LOCAL_NANDReadRaw(hNandInfo, &rawHeader, (bootCmd == UBL_MAGIC_NAND_RAW_READ));
+      }
+      if (status != E_PASS)
+      {
+        DEBUG_printString("Operation failed!");
+        goto UART_tryAgain;
+      }
+
+      // Return DONE when the operation has been completed
+      if ( LOCAL_sendSequence("   DONE") != E_PASS )
+        return E_FAIL;
+
+      // Set the entry point to nowhere, since there isn't an appropriate binary image to run
+      gEntryPoint = 0x0;
+      break;
+    }
 #elif defined(UBL_SDMMC)
     case UBL_MAGIC_SDMMC_FLASH:
     {
@@ -386,13 +487,14 @@ UART_tryAgain:
     default:
     {
       DEBUG_printString("Boot command not supported!");
-      return E_FAIL;
+      goto UART_tryAgain;
     }
   }
   
+  // Signal completion, then return to the prompt for the next command
   LOCAL_sendSequence("   DONE");
 
-  return E_PASS;
+  goto UART_tryAgain;
 }
 
 
@@ -694,6 +796,370 @@ static Uint32 LOCAL_NANDWriteHeaderAndData(NAND_InfoHandle hNandInfo, NANDBOOT_H
   // We succeeded in writing all copies that would fit
   return E_PASS;
 }
+
+// Get the partition (start block, block limit) and length of a raw image.
+// The length is ignored when the command has no image (partition erase).
+static Uint32 LOCAL_recvRawHeader(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader, Bool hasImage)
+{
+  Uint32 error = E_PASS;
+  Uint32 blockBytes, numBlks, bytesLeft;
+
+  // Issue command to host to send image description
+  if ( LOCAL_sendSequence("SENDIMG") != E_PASS)
+  {
+    return E_FAIL;
+  }
+
+  // Recv ACK command
+  if(UART_checkSequence("    ACK", TRUE) != E_PASS)
+  {
+    return E_FAIL;
+  }
+
+  // Get the header elements
+  error =  UART_recvHexData( 4, (Uint32 *) &(rawHeader->startBlock) );
+  error |= UART_recvHexData( 4, (Uint32 *) &(rawHeader->blockCnt)   );
+  error |= UART_recvHexData( 4, (Uint32 *) &(rawHeader->byteCnt)    );
+  error |= UART_checkSequence("0000", FALSE);
+  if(error != E_PASS)
+  {
+    return E_FAIL;
+  }
+
+  // Block 0 is left alone, as with the global erase, and the partition must fit the device
+  if ( (rawHeader->startBlock == 0) || (rawHeader->blockCnt == 0) ||
+       (rawHeader->blockCnt > hNandInfo->numBlocks) ||
+       (rawHeader->startBlock > (hNandInfo->numBlocks - rawHeader->blockCnt)) )
+  {
+    LOCAL_sendSequence("BADADDR");  // trailing /0 will come along
+    return E_FAIL;
+  }
+
+  // Get the number of blocks the image needs if there are no bad blocks
+  blockBytes = hNandInfo->dataBytesPerPage * hNandInfo->pagesPerBlock;
+  numBlks = 0;
+  bytesLeft = rawHeader->byteCnt;
+  while (bytesLeft > 0)
+  {
+    bytesLeft -= (bytesLeft < blockBytes) ? bytesLeft : blockBytes;
+    numBlks++;
+  }
+
+  // Verify that the image fits in the partition
+  if (hasImage && ((rawHeader->byteCnt == 0) || (numBlks > rawHeader->blockCnt)))
+  {
+    LOCAL_sendSequence(" BADCNT");  // trailing /0 will come along
+    return E_FAIL;
+  }
+
+  // Send BEGIN command
+  if (LOCAL_sendSequence("  BEGIN") != E_PASS)
+    return E_FAIL;
+
+  return E_PASS;
+}
+
+// Write a raw image to a partition, skipping bad blocks the way Linux MTD
+// does: data meant for a bad block goes to the next good one, and bad blocks
+// count against the partition size.  The image is pulled from the host one
+// erase block at a time, only once a freshly erased good block is ready for
+// it, so there is no limit on its size and no UART overrun while the flash
+// is busy.  Pages that are all 0xFF are left erased.
+static Uint32 LOCAL_NANDWriteRaw(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader)
+{
+  Uint8     *blockBuf, *pageBuf;
+  Uint32    currBlockNum, endBlockNum, currPageNum;
+  Uint32    blockBytes, bytesLeft, recvLen, i;
+  Bool      haveData = FALSE, isBlank;
+
+  blockBytes   = hNandInfo->dataBytesPerPage * hNandInfo->pagesPerBlock;
+  blockBuf     = (Uint8 *) UTIL_allocMem(blockBytes);
+  currBlockNum = rawHeader->startBlock;
+  endBlockNum  = rawHeader->startBlock + rawHeader->blockCnt - 1;
+  bytesLeft    = rawHeader->byteCnt;
+  recvLen      = 0;
+
+  // Unprotect the partition
+  if (NAND_unProtectBlocks(hNandInfo, rawHeader->startBlock, rawHeader->blockCnt) != E_PASS)
+  {
+    DEBUG_printString("Unprotect failed\r\n");
+    return E_FAIL;
+  }
+
+  // Check if device is write protected
+  if (NAND_isWriteProtected(hNandInfo))
+  {
+    DEBUG_printString("NAND is write protected!\r\n");
+    return E_FAIL;
+  }
+
+  while (bytesLeft > 0)
+  {
+    // Find the next good block and erase it
+    if (currBlockNum > endBlockNum)
+    {
+      DEBUG_printString("No good blocks left in partition!!!\r\n");
+      return E_FAIL;
+    }
+    if (NAND_badBlockCheck(hNandInfo, currBlockNum) != E_PASS)
+    {
+      DEBUG_printString("NAND block ");
+      DEBUG_printHexInt(currBlockNum);
+      DEBUG_printString(" is bad, skipping it.\r\n");
+      currBlockNum++;
+      continue;
+    }
+    if (NAND_eraseBlocks(hNandInfo, currBlockNum, 1) != E_PASS)
+    {
+      // Attempt to mark block bad
+      NAND_badBlockMark(hNandInfo, currBlockNum);
+      currBlockNum++;
+      DEBUG_printString("Erase failed\r\n");
+      continue;
+    }
+
+    // Ask for the next block of the image, unless we are still holding the
+    // data of a block that failed to program
+    if (!haveData)
+    {
+      recvLen = (bytesLeft < blockBytes) ? bytesLeft : blockBytes;
+
+      if (LOCAL_sendSequence("SENDBLK") != E_PASS)
+        return E_FAIL;
+      if (UART_sendHexInt(recvLen) != E_PASS)
+        return E_FAIL;
+
+      i = recvLen;
+      if ((UART_recvStringN((String)blockBuf, &i, FALSE) != E_PASS) || (i != recvLen))
+      {
+        DEBUG_printString("\r\nUART Receive Error\r\n");
+        return E_FAIL;
+      }
+
+      // Pad the tail of the last block
+      for (i = recvLen; i < blockBytes; i++)
+      {
+        blockBuf[i] = 0xFF;
+      }
+      haveData = TRUE;
+    }
+
+    // Program and verify the block page by page
+    pageBuf = blockBuf;
+    for (currPageNum = 0; currPageNum < hNandInfo->pagesPerBlock; currPageNum++)
+    {
+      // Blank pages are already in the erased state
+      isBlank = TRUE;
+      for (i = 0; i < (hNandInfo->dataBytesPerPage >> 2); i++)
+      {
+        if (((Uint32 *)pageBuf)[i] != 0xFFFFFFFF)
+        {
+          isBlank = FALSE;
+          break;
+        }
+      }
+
+      if (!isBlank)
+      {
+        if (NAND_writePage(hNandInfo, currBlockNum, currPageNum, pageBuf) != E_PASS)
+        {
+          DEBUG_printString("Write failed, skipping block!\r\n");
+          break;
+        }
+
+        UTIL_waitLoop(200);
+
+        if (NAND_verifyPage(hNandInfo, currBlockNum, currPageNum, pageBuf, hNandReadBuf) != E_PASS)
+        {
+          DEBUG_printString("Write verify failed, skipping block!\r\n");
+          break;
+        }
+      }
+      pageBuf += hNandInfo->dataBytesPerPage;
+    }
+
+    // On failure retire the block and rewrite the same data to the next one
+    if (currPageNum < hNandInfo->pagesPerBlock)
+    {
+      NAND_badBlockMark(hNandInfo, currBlockNum);
+      currBlockNum++;
+      continue;
+    }
+
+    bytesLeft -= recvLen;
+    haveData = FALSE;
+    currBlockNum++;
+  }
+
+  // Protect all blocks
+  NAND_protectBlocks(hNandInfo);
+
+  return E_PASS;
+}
+
+// Erase every good block of a partition.  Blocks marked bad are left alone,
+// as Linux MTD does, and a block that fails to erase is marked bad.
+static Uint32 LOCAL_NANDEraseRaw(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader)
+{
+  Uint32 currBlockNum, endBlockNum;
+
+  endBlockNum = rawHeader->startBlock + rawHeader->blockCnt - 1;
+
+  // Unprotect the partition
+  if (NAND_unProtectBlocks(hNandInfo, rawHeader->startBlock, rawHeader->blockCnt) != E_PASS)
+  {
+    DEBUG_printString("Unprotect failed\r\n");
+    return E_FAIL;
+  }
+
+  for (currBlockNum = rawHeader->startBlock; currBlockNum <= endBlockNum; currBlockNum++)
+  {
+    if (NAND_badBlockCheck(hNandInfo, currBlockNum) != E_PASS)
+    {
+      DEBUG_printString("NAND block ");
+      DEBUG_printHexInt(currBlockNum);
+      DEBUG_printString(" is bad, skipping it.\r\n");
+      continue;
+    }
+    if (NAND_eraseBlocks(hNandInfo, currBlockNum, 1) != E_PASS)
+    {
+      // Attempt to mark block bad
+      NAND_badBlockMark(hNandInfo, currBlockNum);
+      DEBUG_printString("Erase failed\r\n");
+    }
+  }
+
+  // Protect all blocks
+  NAND_protectBlocks(hNandInfo);
+
+  return E_PASS;
+}
+
+// Read a raw image back from a partition, skipping bad blocks the same way
+// LOCAL_NANDWriteRaw does.  The standard CRC-32 of the image is calculated
+// as it is read; with sendData each erase block's worth of data is also sent
+// to the host, as DATABLK, the byte count as 8 hex characters, then the
+// bytes.  Finally "  CRC32" is sent, followed by the CRC and the number of
+// pages that had uncorrectable ECC errors, each as 8 hex characters.
+// Pages never programmed since the last erase read as all 0xFF.
+static Uint32 LOCAL_NANDReadRaw(NAND_InfoHandle hNandInfo, UARTBOOT_RawHeaderHandle rawHeader, Bool sendData)
+{
+  Uint8     *blockBuf, *pageBuf, *spareBuf;
+  Uint32    *crcTable;
+  Uint32    currBlockNum, endBlockNum, currPageNum;
+  Uint32    blockBytes, bytesLeft, sendLen, i;
+  Uint32    crc = 0xFFFFFFFF, eccErrors = 0;
+  Bool      isBlank;
+
+  blockBytes   = hNandInfo->dataBytesPerPage * hNandInfo->pagesPerBlock;
+  blockBuf     = (Uint8 *) UTIL_allocMem(blockBytes);
+  spareBuf     = (Uint8 *) UTIL_allocMem(hNandInfo->spareBytesPerPage);
+  crcTable     = LOCAL_makeCRC32Table();
+  currBlockNum = rawHeader->startBlock;
+  endBlockNum  = rawHeader->startBlock + rawHeader->blockCnt - 1;
+  bytesLeft    = rawHeader->byteCnt;
+
+  while (bytesLeft > 0)
+  {
+    // Find the next good block
+    if (currBlockNum > endBlockNum)
+    {
+      DEBUG_printString("No good blocks left in partition!!!\r\n");
+      return E_FAIL;
+    }
+    if (NAND_badBlockCheck(hNandInfo, currBlockNum) != E_PASS)
+    {
+      currBlockNum++;
+      continue;
+    }
+
+    // Read only the pages holding image data
+    sendLen = (bytesLeft < blockBytes) ? bytesLeft : blockBytes;
+    pageBuf = blockBuf;
+    for (currPageNum = 0; (currPageNum * hNandInfo->dataBytesPerPage) < sendLen; currPageNum++)
+    {
+      if (NAND_readPage(hNandInfo, currBlockNum, currPageNum, pageBuf) != E_PASS)
+      {
+        // An erased page carries no ECC, so check for one before counting an error
+        NAND_readSpareBytesOfPage(hNandInfo, currBlockNum, currPageNum, spareBuf);
+        isBlank = TRUE;
+        for (i = 0; i < hNandInfo->spareBytesPerPage; i++)
+        {
+          if (spareBuf[i] != 0xFF)
+          {
+            isBlank = FALSE;
+            break;
+          }
+        }
+
+        if (isBlank)
+        {
+          for (i = 0; i < hNandInfo->dataBytesPerPage; i++)
+          {
+            pageBuf[i] = 0xFF;
+          }
+        }
+        else
+        {
+          DEBUG_printString("Uncorrectable ECC error in block ");
+          DEBUG_printHexInt(currBlockNum);
+          DEBUG_printString(", page ");
+          DEBUG_printHexInt(currPageNum);
+          DEBUG_printString("\r\n");
+          eccErrors++;
+        }
+      }
+      pageBuf += hNandInfo->dataBytesPerPage;
+    }
+
+    // Standard CRC-32 (reflected, init and final xor 0xFFFFFFFF)
+    for (i = 0; i < sendLen; i++)
+    {
+      crc = (crc >> 8) ^ crcTable[(crc ^ blockBuf[i]) & 0xFF];
+    }
+
+    if (sendData)
+    {
+      if (LOCAL_sendSequence("DATABLK") != E_PASS)
+        return E_FAIL;
+      if (UART_sendHexInt(sendLen) != E_PASS)
+        return E_FAIL;
+      if (UART_sendStringN((String)blockBuf, sendLen) != E_PASS)
+        return E_FAIL;
+    }
+
+    bytesLeft -= sendLen;
+    currBlockNum++;
+  }
+
+  // Report the result
+  if (LOCAL_sendSequence("  CRC32") != E_PASS)
+    return E_FAIL;
+  if (UART_sendHexInt(crc ^ 0xFFFFFFFF) != E_PASS)
+    return E_FAIL;
+  if (UART_sendHexInt(eccErrors) != E_PASS)
+    return E_FAIL;
+
+  return E_PASS;
+}
+
+// Build the lookup table for the reflected CRC-32 polynomial
+static Uint32 *LOCAL_makeCRC32Table(void)
+{
+  Uint32 *table = (Uint32 *) UTIL_allocMem(256 * sizeof(Uint32));
+  Uint32 i, j, crc;
+
+  for (i = 0; i < 256; i++)
+  {
+    crc = i;
+    for (j = 0; j < 8; j++)
+    {
+      crc = (crc >> 1) ^ ((crc & 0x1) ? 0xEDB88320 : 0x0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
 #endif
 
 
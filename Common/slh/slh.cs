@@ -16,6 +16,7 @@ using UtilLib;
 using UtilLib.IO;
 using UtilLib.CRC;
 using UtilLib.ConsoleUtility;
+using UtilLib.HexConv;
 
 [assembly: AssemblyTitle("SerialLoaderHost")]
 [assembly: AssemblyVersion("1.50.*")]
@@ -96,6 +97,16 @@ namespace TIBootAndFlash
     /// Global main Serial Port Object
     /// </summary>
     public static SerialPort MySP;
+
+    /// <summary>
+    /// Buffered I/O engine driving MySP
+    /// </summary>
+    public static SerialEngine MyEngine;
+
+    /// <summary>
+    /// Progress bar for the transfer currently in progress
+    /// </summary>
+    private static ProgressBar progressBar;
             
     /// <summary>
     /// The main thread used to actually execute everything
@@ -353,6 +364,7 @@ namespace TIBootAndFlash
         MySP = new SerialPort(cmdParams.SerialPortName, 115200, Parity.None, 8, StopBits.One);
         MySP.Encoding = Encoding.ASCII;
         MySP.Open();
+        MyEngine = SerialEngine.GetEngine(MySP);
       }
       catch(Exception e)
       {
@@ -443,7 +455,7 @@ namespace TIBootAndFlash
           TransmitSLTAndApp();
           
           // Wait for second ^^^DONE that indicates SLT is done
-          if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, true))
+          if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", true))
             throw new Exception("Final DONE not returned.  Operation failed.");
           
           break;
@@ -468,18 +480,8 @@ namespace TIBootAndFlash
     private static void TransmitUBL(Byte[] imageData,UARTBOOT_Header ackHeader)
     {
       // Local Variables for building up output
-      StringBuilder UBLsb;
       CRC32 MyCRC;
-      ProgressBar progressBar;
-      Int32 blockCnt;      
-
-      UBLsb = new StringBuilder(imageData.Length * 2);
-      
-      // Read the data from the UBL file into the appropriate structures
-      for (int i=0; i<imageData.Length; i+=sizeof(UInt32))
-      {
-        UBLsb.AppendFormat("{0:X8}", System.BitConverter.ToUInt32(imageData,i));
-      }
+      Byte[] UBLData, CRCTableData;
 
       // Create CRC object and use it to calculate the UBL file's CRC
       // Note that this CRC is not quite the standard CRC-32 algorithm
@@ -490,13 +492,22 @@ namespace TIBootAndFlash
       ackHeader.crcVal = MyCRC.CalculateCRC(imageData);
       ackHeader.byteCnt = (UInt32) imageData.Length;
 
+      // Build the hex text of the UBL and the CRC table up front so each goes
+      // out as bulk writes
+      UBLData = HexCodec.EncodeWords(imageData, false);
+      CRCTableData = new Byte[MyCRC.Length * 8];
+      for (int i = 0; i < MyCRC.Length; i++)
+      {
+        HexCodec.PutWord(MyCRC[i], CRCTableData, i * 8, true);
+      }
+
       try
       {
       BOOTMESEQ:
         Console.WriteLine("\nWaiting for the "+devString+"...");
 
         // Wait for the device to send the ^BOOTME/0 sequence
-        if (SerialIO.waitForSequence(" BOOTME\0", " BOOTME\0", MySP, cmdParams.verbose))
+        if (MyEngine.WaitForSequence(" BOOTME\0", " BOOTME\0", cmdParams.verbose))
             Console.WriteLine("BOOTME commmand received. Returning ACK and header...");
         else
             goto BOOTMESEQ;
@@ -504,25 +515,25 @@ namespace TIBootAndFlash
         // Output 28 Bytes for the ACK sequence and header
         // 8 bytes acknowledge sequence = "    ACK\0"
 #if (DM35x_REVB || DM36x_REVA)
-        MySP.Write("    ACK");
+        MyEngine.Write("    ACK");
 #else
-        MySP.Write("    ACK\0");
+        MyEngine.Write("    ACK\0");
 #endif
         // 8 bytes of CRC data = ASCII string of 8 hex characters
-        MySP.Write(ackHeader.crcVal.ToString("X8"));
+        MyEngine.Write(ackHeader.crcVal.ToString("X8"));
         
         // 4 bytes of UBL data size = ASCII string of 4 hex characters (3800h = 14336d)
-        MySP.Write(ackHeader.byteCnt.ToString("X4"));
+        MyEngine.Write(ackHeader.byteCnt.ToString("X4"));
         
         // 4 bytes of start address = ASCII string of 4 hex characters (>=0100h)
-        MySP.Write(ackHeader.startAddr.ToString("X4"));
+        MyEngine.Write(ackHeader.startAddr.ToString("X4"));
         
         // 4 bytes of constant zeros = "0000"
-        MySP.Write("0000");
+        MyEngine.Write("0000");
         Console.WriteLine("ACK command sent. Waiting for BEGIN command... ");
 
         // Wait for the BEGIN sequence
-        if (SerialIO.waitForSequence("  BEGIN\0", " BOOTME\0", MySP,true))
+        if (MyEngine.WaitForSequence("  BEGIN\0", " BOOTME\0", true))
             Console.WriteLine("BEGIN commmand received. Sending CRC table...");
         else
             goto BOOTMESEQ;
@@ -530,16 +541,12 @@ namespace TIBootAndFlash
         // Send the 1024 byte (256 word) CRC table
         progressBar = new ProgressBar();
         progressBar.Update(0.0,"Sending CRC table...");
-        for (int i = 0; i < MyCRC.Length; i++)
-        {
-            MySP.Write(MyCRC[i].ToString("x8"));
-            progressBar.Percent = (((Double)(i+1))/MyCRC.Length);
-        }
+        MyEngine.Write(CRCTableData, 0, CRCTableData.Length, new SerialEngine.ProgressHandler(UpdateProgress));
         progressBar.Update(100.0,"CRC table sent.");
         Console.WriteLine("Waiting for DONE...");
 
         // Wait for the first DONE sequence
-        if (SerialIO.waitForSequence("   DONE\0", " BOOTME\0", MySP, cmdParams.verbose))
+        if (MyEngine.WaitForSequence("   DONE\0", " BOOTME\0", cmdParams.verbose))
             Console.WriteLine("DONE received.  Sending the UBL...");
         else
             goto BOOTMESEQ;
@@ -547,18 +554,11 @@ namespace TIBootAndFlash
         // Send the contents of the UBL file (as hex text)
         progressBar = new ProgressBar();
         progressBar.Update(0.0,"Sending UBL...");
-        blockCnt = UBLsb.Length/128;
-        for (int i = 0; i < (blockCnt*128); i+=128)
-        {
-          MySP.Write(UBLsb.ToString(i,128));
-          progressBar.Percent = (((Double)(i+1))/UBLsb.Length);
-        }
-        // Write last (possibly partial) block
-        MySP.Write(UBLsb.ToString(blockCnt*128,UBLsb.Length - (blockCnt*128) ));
+        MyEngine.Write(UBLData, 0, UBLData.Length, new SerialEngine.ProgressHandler(UpdateProgress));
         progressBar.Update(100.0,"UBL sent.");
 
         // Wait for the second DONE sequence
-        if (SerialIO.waitForSequence("   DONE\0", " BOOTME\0", MySP, cmdParams.verbose))
+        if (MyEngine.WaitForSequence("   DONE\0", " BOOTME\0", cmdParams.verbose))
             Console.WriteLine("DONE received.  UBL was accepted.");
         else
             goto BOOTMESEQ;
@@ -581,33 +581,30 @@ namespace TIBootAndFlash
     /// </summary>
     private static Boolean TransmitImage(Byte[] imageData, UARTBOOT_Header ackHeader)
     {
-      ProgressBar progressBar;
-      UInt32 blockCnt;
-
       try
       {
         Console.WriteLine("Waiting for SENDIMG sequence...");
-        if (!SerialIO.waitForSequence("SENDIMG\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        if (!MyEngine.WaitForSequence("SENDIMG\0", "BOOTUBL\0", cmdParams.verbose))
           return false;
           
         Console.WriteLine("SENDIMG received. Returning ACK and header for image data...");
 
         // Output 36 Bytes for the ACK sequence and header
         // 8 bytes acknowledge sequence = "    ACK\0"
-        MySP.Write("    ACK\0");
+        MyEngine.Write("    ACK\0");
         // 8 bytes of binary execution address = ASCII string of 8 hex characters
-        MySP.Write(String.Format("{0:X8}", ackHeader.startAddr));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.startAddr));
         // 8 bytes of data size = ASCII string of 8 hex characters
-        MySP.Write(String.Format("{0:X8}", ackHeader.byteCnt));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.byteCnt));
         // 8 bytes of binary load address = ASCII string of 8 hex characters
-        MySP.Write(String.Format("{0:X8}", ackHeader.loadAddr));
+        MyEngine.Write(String.Format("{0:X8}", ackHeader.loadAddr));
         // 4 bytes of constant zeros = "0000"
-        MySP.Write("0000");
+        MyEngine.Write("0000");
 
         Console.WriteLine("ACK command sent. Waiting for BEGIN command... ");
 
         // Wait for the ^^BEGIN\0 sequence
-        if (!SerialIO.waitForSequence("  BEGIN\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        if (!MyEngine.WaitForSequence("  BEGIN\0", "BOOTUBL\0", cmdParams.verbose))
           return false;
         
         Console.WriteLine("BEGIN commmand received.");
@@ -615,20 +612,13 @@ namespace TIBootAndFlash
         // Send the image data
         progressBar = new ProgressBar();
         progressBar.Update(0.0,"Sending Image data...");
-        blockCnt = ackHeader.byteCnt/128;
-        for (int i = 0; i < (blockCnt*128); i+=128)
-        {
-          MySP.Write(imageData, i, 128);
-          progressBar.Percent = (((Double)(i+1))/ackHeader.byteCnt);
-        }
-        // Write last (possibly partial) block
-        MySP.Write(imageData, (Int32) (blockCnt*128),(Int32) (ackHeader.byteCnt - (blockCnt*128)) );
+        MyEngine.Write(imageData, 0, (Int32) ackHeader.byteCnt, new SerialEngine.ProgressHandler(UpdateProgress));
         progressBar.Update(100.0,"Image data sent.");
         
         Console.WriteLine("Waiting for DONE...");
 
         // Wait for first ^^^DONE\0 to indicate data received
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", cmdParams.verbose))
           return false;
         
         Console.WriteLine("DONE received.  All bytes of image data received...");
@@ -686,25 +676,25 @@ namespace TIBootAndFlash
       BOOTUBLSEQ1:
         // Send the UBL command
         // Clear input buffer so we can start looking for BOOTUBL
-        MySP.DiscardInBuffer();
+        MyEngine.DiscardInBuffer();
 
         Console.WriteLine("\nWaiting for SLT on the "+devString+"...");
         
         // Wait for the UBL on the device to send the ^BOOTUBL\0 sequence
-        if (!SerialIO.waitForSequence("BOOTUBL\0", "BOOTUBL\0", MySP, true))
+        if (!MyEngine.WaitForSequence("BOOTUBL\0", "BOOTUBL\0", true))
           goto BOOTUBLSEQ1;
         
         Console.WriteLine("BOOTUBL commmand received. Returning CMD and command...");
 
         // 8 bytes acknowledge sequence = "    CMD\0"
-        MySP.Write("    CMD\0");
+        MyEngine.Write("    CMD\0");
         // 8 bytes of magic number
-        MySP.Write(((UInt32)cmdParams.CMDMagicFlag).ToString("X8"));
+        MyEngine.Write(((UInt32)cmdParams.CMDMagicFlag).ToString("X8"));
         
         Console.WriteLine("CMD value sent.  Waiting for DONE...");
         
         // Wait for ^^^DONE letting us know the command was accepted
-        if (!SerialIO.waitForSequence("   DONE\0", "BOOTUBL\0", MySP, cmdParams.verbose))
+        if (!MyEngine.WaitForSequence("   DONE\0", "BOOTUBL\0", cmdParams.verbose))
           goto BOOTUBLSEQ1;
           
         Console.WriteLine("DONE received. Command was accepted.");
@@ -734,7 +724,16 @@ namespace TIBootAndFlash
       }        
     }
                 
-    #endregion 
+    /// <summary>
+    /// Progress callback for the bulk writes; the caller completes the bar
+    /// </summary>
+    private static void UpdateProgress(Int32 bytesDone, Int32 bytesTotal)
+    {
+      if (bytesDone < bytesTotal)
+        progressBar.Percent = (((Double)bytesDone)/bytesTotal);
+    }
+
+    #endregion
     //**********************************************************************************
 
     }
@@ -0,0 +1,89 @@
+/* --------------------------------------------------------------------------
+  FILE        : sdmmcfat.h
+  PROJECT     : TI Booting and Flashing Utilities
+  DESC        : Structures and macros for the read-only FAT16/FAT32 boot
+                path of the SD/MMC UBL.
+ ----------------------------------------------------------------------------- */
+
+#ifndef _SDMMCFAT_H_
+#define _SDMMCFAT_H_
+
+#include "tistdtypes.h"
+
+// SD/MMC driver
+#include "sdmmc.h"
+
+// Prevent C++ name mangling
+#ifdef __cplusplus
+extern far "c" {
+#endif
+
+/************************************************************
+* Global Macro Declarations                                 *
+************************************************************/
+
+// Only 512 byte sectors are supported (the SD/MMC block size)
+#define SDMMCFAT_SECTOR_SIZE          (512)
+#define SDMMCFAT_SECTOR_SHIFT         (9)
+
+// Number of FAT sectors held in RAM at once (16 KB covers 4096 FAT32 or
+// 8192 FAT16 clusters, i.e. the whole chain of any contiguous boot image)
+#define SDMMCFAT_FAT_CACHE_SECTORS    (32)
+
+// Longest single multi-block read, bounded by the 16-bit MMCNBLK count
+// and the word counter in SDMMCReadNWords()
+#define SDMMCFAT_MAX_READ_SECTORS     (4096)
+
+// Byte addressing in the SD/MMC driver limits reads to the first 4 GB
+#define SDMMCFAT_MAX_SECTOR           (0x00800000)
+
+#define SDMMCFAT_DIR_ENTRY_SIZE       (32)
+#define SDMMCFAT_DIR_ENTRY_SHIFT      (5)
+#define SDMMCFAT_NAME_LEN             (11)
+
+// Legacy U-Boot image header (big-endian fields)
+#define SDMMCFAT_UIMAGE_MAGIC         (0x27051956)
+#define SDMMCFAT_UIMAGE_HEADER_SIZE   (64)
+
+
+/************************************************************
+* Global Typedef declarations                               *
+************************************************************/
+
+typedef struct _SDMMCFAT_INFO_
+{
+  SDMMC_InfoHandle hSDMMCInfo;
+  Uint32  fat32;              // TRUE for FAT32, FALSE for FAT16
+  Uint32  fatStart;           // First sector of the first FAT
+  Uint32  fatSectors;         // Sectors in one FAT
+  Uint32  rootStart;          // First sector of the FAT16 root directory
+  Uint32  rootSectors;        // Sectors in the FAT16 root directory
+  Uint32  rootCluster;        // First cluster of the FAT32 root directory
+  Uint32  dataStart;          // Sector of cluster 2
+  Uint32  clusterShift;       // log2(sectors per cluster)
+  Uint32  clusterCnt;         // Number of data clusters
+  Uint8   *sectorBuf;         // One sector scratch buffer
+  Uint8   *clusterBuf;        // One cluster directory buffer
+  Uint8   *fatCache;          // Cached window of FAT sectors
+  Uint32  fatCacheSector;     // First FAT sector held in fatCache
+  Uint32  fatCacheCnt;        // Number of valid sectors in fatCache
+}
+SDMMCFAT_InfoObj, *SDMMCFAT_InfoHandle;
+
+
+/******************************************************
+* Global Function Declarations                        *
+******************************************************/
+
+extern Uint32 SDMMCFAT_boot(SDMMC_InfoHandle hSDMMCInfo);
+
+
+/***********************************************************
+* End file                                                 *
+***********************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_SDMMCFAT_H_
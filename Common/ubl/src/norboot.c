@@ -47,6 +47,9 @@ extern Uint32 gEntryPoint;
 * Local Macro Declarations                                  *
 ************************************************************/
 
+// Words moved per pass of the unrolled copy loop
+#define NORBOOT_COPY_BLOCK_WORDS   (8)
+
 
 /************************************************************
 * Local Typedef Declarations                                *
@@ -57,6 +60,8 @@ extern Uint32 gEntryPoint;
 * Local Function Declarations                               *
 ************************************************************/
 
+static void LOCAL_blockCopy(Uint32 *dest, const Uint32 *src, Uint32 numWords);
+
 
 /************************************************************
 * Local Variable Definitions                                *
@@ -77,9 +82,9 @@ Uint32 NORBOOT_copy(void)
 {
   NOR_InfoHandle hNorInfo = NULL;
   volatile NORBOOT_HeaderHandle	hNorHeader = 0;
-  VUint32 *norPtr = NULL;
-  VUint32	*ramPtr = NULL;
-  Uint32 count = 0, blkSize, blkAddress;
+  Uint32 *norPtr = NULL;
+  Uint32 *ramPtr = NULL;
+  Uint32 blkSize, blkAddress;
 
   DEBUG_printString("Starting NOR Copy...\r\n");
 
@@ -105,11 +110,8 @@ Uint32 NORBOOT_copy(void)
 
   ramPtr = (Uint32 *) hNorHeader->ldAddress;
 
-  // Copy data to RAM
-  for(count = 0; count < ((hNorHeader->appSize + 3)/4); count ++)
-  {
-    ramPtr[count] = norPtr[count];
-  }
+  // Copy data to RAM (NOR is in read array mode, so plain memory reads work)
+  LOCAL_blockCopy(ramPtr, norPtr, ((hNorHeader->appSize + 3) >> 2));
   gEntryPoint = hNorHeader->entryPoint;
 
   // Since our entry point is set, just return success
@@ -123,6 +125,31 @@ Uint32 NORBOOT_copy(void)
 * Local Function Definitions                                *
 ************************************************************/
 
+// Copy in blocks of eight words through non-volatile pointers, which cuts
+// the loop overhead per word. Each NOR read is still a separate
+// asynchronous AEMIF access; no burst or page mode reads are used.
+static void LOCAL_blockCopy(Uint32 *dest, const Uint32 *src, Uint32 numWords)
+{
+  Uint32 w0, w1, w2, w3, w4, w5, w6, w7;
+
+  while (numWords >= NORBOOT_COPY_BLOCK_WORDS)
+  {
+    w0 = src[0]; w1 = src[1]; w2 = src[2]; w3 = src[3];
+    w4 = src[4]; w5 = src[5]; w6 = src[6]; w7 = src[7];
+    dest[0] = w0; dest[1] = w1; dest[2] = w2; dest[3] = w3;
+    dest[4] = w4; dest[5] = w5; dest[6] = w6; dest[7] = w7;
+    src  += NORBOOT_COPY_BLOCK_WORDS;
+    dest += NORBOOT_COPY_BLOCK_WORDS;
+    numWords -= NORBOOT_COPY_BLOCK_WORDS;
+  }
+
+  while (numWords > 0)
+  {
+    *dest++ = *src++;
+    numWords--;
+  }
+}
+
 
 /************************************************************
 * End file                                                  *
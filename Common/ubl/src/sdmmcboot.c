@@ -26,6 +26,9 @@
 // This module's header file
 #include "sdmmcboot.h"
 
+// FAT filesystem boot
+#include "sdmmcfat.h"
+
 // Device specific file
 #include "device_sdmmc.h"
 
@@ -73,6 +76,7 @@ Uint8 SDMMCBOOT(SDMMC_InfoHandle hSDMMCInfo);
 Uint32 SDMMCBOOT_copy()
 {
   SDMMC_InfoHandle hSDMMCInfo;
+  void *heapPtr;
 
   DEBUG_printString("Starting SDMMC Copy...\r\n");
   
@@ -81,8 +85,15 @@ Uint32 SDMMCBOOT_copy()
   if (hSDMMCInfo == NULL)
     return E_FAIL;
 
-   if( SDMMCBOOT(hSDMMCInfo) != E_PASS)
-	   return E_FAIL;
+  // Look for an image in the raw block area first, then fall back to
+  // u-boot.bin/uImage on a FAT partition
+  heapPtr = UTIL_getCurrMemPtr();
+  if( SDMMCBOOT(hSDMMCInfo) != E_PASS)
+  {
+    UTIL_setCurrMemPtr(heapPtr);
+    if (SDMMCFAT_boot(hSDMMCInfo) != E_PASS)
+      return E_FAIL;
+  }
 
   return E_PASS;
 }
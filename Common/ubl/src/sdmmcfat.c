@@ -0,0 +1,545 @@
+/* --------------------------------------------------------------------------
+  FILE        : sdmmcfat.c
+  PROJECT     : TI Booting and Flashing Utilities
+  DESC        : Read-only FAT16/FAT32 support for the SD/MMC UBL.  Finds
+                u-boot.bin (or a uImage) in the root directory of the first
+                FAT partition and streams it to its load address, one
+                multi-block read per contiguous run of clusters.
+----------------------------------------------------------------------------- */
+
+#ifdef UBL_SD_MMC
+
+// General type include
+#include "tistdtypes.h"
+
+// Debug I/O module
+#include "debug.h"
+
+// Misc utility module
+#include "util.h"
+
+// Main UBL module
+#include "ubl.h"
+
+// SD/MMC driver functions
+#include "sdmmc.h"
+
+// This module's header file
+#include "sdmmcfat.h"
+
+// Device specific file
+#include "device_sdmmc.h"
+
+
+/************************************************************
+* Explicit External Declarations                            *
+************************************************************/
+
+extern __FAR__ Uint32 EXTERNAL_RAM_START;
+extern __FAR__ Uint32 DDRSize;
+
+// Entrypoint for application we are loading from the card
+extern Uint32 gEntryPoint;
+
+extern Uint8 SDMMCSingleBlkRead(SDMMC_InfoHandle hSDMMCInfo, Uint32 cardMemAddr, Uint32 *dest, Uint32 blkLength);
+extern Uint8 SDMMCMultipleBlkRead(SDMMC_InfoHandle hSDMMCInfo, Uint32 cardMemAddr, Uint32 *dest, Uint32 dataLength);
+
+
+/************************************************************
+* Local Macro Declarations                                  *
+************************************************************/
+
+// Results of scanning a buffer of directory entries
+#define SDMMCFAT_DIR_MORE     (0)
+#define SDMMCFAT_DIR_END      (1)
+
+#define SDMMCFAT_IMAGE_TYPES  (2)
+
+
+/************************************************************
+* Local Typedef Declarations                                *
+************************************************************/
+
+typedef struct _SDMMCFAT_FILE_
+{
+  Uint32 found;
+  Uint32 cluster;
+  Uint32 size;
+}
+SDMMCFAT_FileObj;
+
+
+/************************************************************
+* Local Function Declarations                               *
+************************************************************/
+
+static Uint32 LOCAL_get16(Uint8 *p);
+static Uint32 LOCAL_get32(Uint8 *p);
+static Uint32 LOCAL_getBE32(Uint8 *p);
+static Uint32 LOCAL_readSectors(SDMMCFAT_InfoHandle hFatInfo, Uint32 sector, Uint32 sectorCnt, Uint8 *dest);
+static Uint32 LOCAL_isBootSector(Uint8 *buf);
+static Uint32 LOCAL_mount(SDMMCFAT_InfoHandle hFatInfo);
+static Uint32 LOCAL_clusterToSector(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster);
+static Uint32 LOCAL_isValidCluster(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster);
+static Uint32 LOCAL_getNextCluster(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster, Uint32 *next);
+static Uint32 LOCAL_scanDir(Uint8 *buf, Uint32 numBytes, SDMMCFAT_FileObj *files);
+static Uint32 LOCAL_findImages(SDMMCFAT_InfoHandle hFatInfo, SDMMCFAT_FileObj *files);
+static Uint32 LOCAL_loadFile(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster, Uint32 byteCnt, Uint8 *dest);
+
+
+/************************************************************
+* Local Variable Definitions                                *
+************************************************************/
+
+// 8.3 directory names of the images we boot, in order of preference
+static const Uint8 LOCAL_imageNames[SDMMCFAT_IMAGE_TYPES][SDMMCFAT_NAME_LEN] =
+{
+  {'U','-','B','O','O','T',' ',' ','B','I','N'},
+  {'U','I','M','A','G','E',' ',' ',' ',' ',' '}
+};
+
+
+/************************************************************
+* Global Variable Definitions                               *
+************************************************************/
+
+
+/************************************************************
+* Global Function Definitions                               *
+************************************************************/
+
+// Find a boot image on a FAT partition and copy it to RAM
+Uint32 SDMMCFAT_boot(SDMMC_InfoHandle hSDMMCInfo)
+{
+  SDMMCFAT_InfoObj  fatInfo;
+  SDMMCFAT_FileObj  files[SDMMCFAT_IMAGE_TYPES];
+  Uint32            heapPtr, retVal = E_FAIL;
+  Uint32            i, ldAddress, loadEnd, entryPoint, byteCnt;
+  Uint8             *hdr;
+
+  // Scratch buffers are released again before returning
+  heapPtr = (Uint32) UTIL_getCurrMemPtr();
+
+  fatInfo.hSDMMCInfo = hSDMMCInfo;
+  if (LOCAL_mount(&fatInfo) != E_PASS)
+    goto SDMMCFAT_exit;
+
+  for (i = 0; i < SDMMCFAT_IMAGE_TYPES; i++)
+    files[i].found = FALSE;
+
+  if (LOCAL_findImages(&fatInfo, files) != E_PASS)
+    goto SDMMCFAT_exit;
+
+  for (i = 0; i < SDMMCFAT_IMAGE_TYPES; i++)
+  {
+    if (files[i].found)
+      break;
+  }
+  if (i == SDMMCFAT_IMAGE_TYPES)
+  {
+    DEBUG_printString("No boot image in FAT root directory.\r\n");
+    goto SDMMCFAT_exit;
+  }
+
+  byteCnt = files[i].size;
+  if ((byteCnt == 0) || (byteCnt > APP_IMAGE_SIZE) || !LOCAL_isValidCluster(&fatInfo, files[i].cluster))
+  {
+    DEBUG_printString("Invalid boot image in FAT root directory.\r\n");
+    goto SDMMCFAT_exit;
+  }
+
+  if (i == 0)
+  {
+    // Raw u-boot.bin has no header, it runs where the device expects it
+    ldAddress  = DEVICE_SDMMC_FAT_LOAD_ADDR;
+    entryPoint = DEVICE_SDMMC_FAT_ENTRY_POINT;
+    DEBUG_printString("Loading u-boot.bin");
+  }
+  else
+  {
+    // Peek at the uImage header, then load the whole file so that the
+    // payload lands on the header's load address
+    hdr = fatInfo.sectorBuf;
+    if (LOCAL_readSectors(&fatInfo, LOCAL_clusterToSector(&fatInfo, files[i].cluster), 1, hdr) != E_PASS)
+      goto SDMMCFAT_exit;
+
+    if ((LOCAL_getBE32(&hdr[0]) != SDMMCFAT_UIMAGE_MAGIC) ||
+        ((LOCAL_getBE32(&hdr[12]) + SDMMCFAT_UIMAGE_HEADER_SIZE) > byteCnt))
+    {
+      DEBUG_printString("Invalid uImage header.\r\n");
+      goto SDMMCFAT_exit;
+    }
+    ldAddress  = LOCAL_getBE32(&hdr[16]) - SDMMCFAT_UIMAGE_HEADER_SIZE;
+    entryPoint = LOCAL_getBE32(&hdr[20]);
+    DEBUG_printString("Loading uImage");
+  }
+  DEBUG_printString(" from FAT");
+  DEBUG_printString(fatInfo.fat32 ? "32" : "16");
+  DEBUG_printString(", size = ");
+  DEBUG_printHexInt(byteCnt);
+  DEBUG_printString("\r\n");
+
+  // Whole sectors are read, so the tail of the last one lands past the file.
+  // Keep the FAT cache out of the way of all of it.
+  loadEnd = ldAddress + ((byteCnt + SDMMCFAT_SECTOR_SIZE - 1) & ~(SDMMCFAT_SECTOR_SIZE - 1));
+  if ( ((Uint32)fatInfo.fatCache < loadEnd) &&
+       (((Uint32)fatInfo.fatCache + (SDMMCFAT_FAT_CACHE_SECTORS << SDMMCFAT_SECTOR_SHIFT)) > ldAddress) )
+  {
+    UTIL_setCurrMemPtr((void *)(loadEnd - ((Uint32)&EXTERNAL_RAM_START)));
+    fatInfo.fatCache = (Uint8 *) UTIL_allocMem(SDMMCFAT_FAT_CACHE_SECTORS << SDMMCFAT_SECTOR_SHIFT);
+    fatInfo.fatCacheCnt = 0;
+    if (fatInfo.fatCache == NULL)
+      goto SDMMCFAT_exit;
+  }
+
+  if (LOCAL_loadFile(&fatInfo, files[i].cluster, byteCnt, (Uint8 *)ldAddress) != E_PASS)
+  {
+    DEBUG_printString("FAT image read failed.\r\n");
+    goto SDMMCFAT_exit;
+  }
+
+  gEntryPoint = entryPoint;
+  retVal = E_PASS;
+
+SDMMCFAT_exit:
+  UTIL_setCurrMemPtr((void *)heapPtr);
+  return retVal;
+}
+
+
+/************************************************************
+* Local Function Definitions                                *
+************************************************************/
+
+// On-disk structures are little-endian and not necessarily aligned
+static Uint32 LOCAL_get16(Uint8 *p)
+{
+  return ((Uint32)p[0]) | (((Uint32)p[1]) << 8);
+}
+
+static Uint32 LOCAL_get32(Uint8 *p)
+{
+  return ((Uint32)p[0]) | (((Uint32)p[1]) << 8) | (((Uint32)p[2]) << 16) | (((Uint32)p[3]) << 24);
+}
+
+static Uint32 LOCAL_getBE32(Uint8 *p)
+{
+  return (((Uint32)p[0]) << 24) | (((Uint32)p[1]) << 16) | (((Uint32)p[2]) << 8) | ((Uint32)p[3]);
+}
+
+// Read whole sectors, using as few commands as the controller allows
+static Uint32 LOCAL_readSectors(SDMMCFAT_InfoHandle hFatInfo, Uint32 sector, Uint32 sectorCnt, Uint8 *dest)
+{
+  Uint32 cnt;
+
+  if ((sector >= SDMMCFAT_MAX_SECTOR) || (sectorCnt > (SDMMCFAT_MAX_SECTOR - sector)))
+    return E_FAIL;
+
+  while (sectorCnt > 0)
+  {
+    cnt = (sectorCnt > SDMMCFAT_MAX_READ_SECTORS) ? SDMMCFAT_MAX_READ_SECTORS : sectorCnt;
+
+    if (cnt == 1)
+    {
+      if (SDMMCSingleBlkRead(hFatInfo->hSDMMCInfo, sector << SDMMCFAT_SECTOR_SHIFT, (Uint32 *)dest, SDMMCFAT_SECTOR_SIZE) != E_PASS)
+        return E_FAIL;
+    }
+    else
+    {
+      if (SDMMCMultipleBlkRead(hFatInfo->hSDMMCInfo, sector << SDMMCFAT_SECTOR_SHIFT, (Uint32 *)dest, cnt << SDMMCFAT_SECTOR_SHIFT) != E_PASS)
+        return E_FAIL;
+    }
+
+    sector    += cnt;
+    sectorCnt -= cnt;
+    dest      += (cnt << SDMMCFAT_SECTOR_SHIFT);
+  }
+
+  return E_PASS;
+}
+
+// Check for a FAT boot sector with a BIOS parameter block we can use
+static Uint32 LOCAL_isBootSector(Uint8 *buf)
+{
+  Uint32 secPerClus = buf[13];
+
+  if ((buf[510] != 0x55) || (buf[511] != 0xAA))
+    return FALSE;
+  if ((buf[0] != 0xEB) && (buf[0] != 0xE9))
+    return FALSE;
+  if (LOCAL_get16(&buf[11]) != SDMMCFAT_SECTOR_SIZE)
+    return FALSE;
+  if ((secPerClus == 0) || ((secPerClus & (secPerClus - 1)) != 0))
+    return FALSE;
+  if ((LOCAL_get16(&buf[14]) == 0) || (buf[16] == 0))
+    return FALSE;
+
+  return TRUE;
+}
+
+// Locate the first FAT partition and work out its layout
+static Uint32 LOCAL_mount(SDMMCFAT_InfoHandle hFatInfo)
+{
+  Uint8   *buf, *part;
+  Uint32  i, partStart, numFATs, totSectors, metaSectors;
+
+  buf = (Uint8 *) UTIL_allocMem(SDMMCFAT_SECTOR_SIZE);
+  hFatInfo->sectorBuf = buf;
+  if (buf == NULL)
+    return E_FAIL;
+
+  if (LOCAL_readSectors(hFatInfo, 0, 1, buf) != E_PASS)
+    return E_FAIL;
+
+  // Either a superfloppy (no partition table) or an MBR
+  partStart = 0;
+  if (!LOCAL_isBootSector(buf))
+  {
+    if ((buf[510] != 0x55) || (buf[511] != 0xAA))
+      return E_FAIL;
+
+    for (i = 0; i < 4; i++)
+    {
+      part = &buf[446 + (i << 4)];
+      if ((part[4] == 0x04) || (part[4] == 0x06) || (part[4] == 0x0E) ||
+          (part[4] == 0x0B) || (part[4] == 0x0C))
+      {
+        partStart = LOCAL_get32(&part[8]);
+        break;
+      }
+    }
+    if ((i == 4) || (partStart == 0))
+      return E_FAIL;
+
+    if (LOCAL_readSectors(hFatInfo, partStart, 1, buf) != E_PASS)
+      return E_FAIL;
+    if (!LOCAL_isBootSector(buf))
+      return E_FAIL;
+  }
+
+  hFatInfo->clusterShift = 0;
+  while ((1u << hFatInfo->clusterShift) != buf[13])
+    hFatInfo->clusterShift++;
+
+  numFATs = buf[16];
+  hFatInfo->fatSectors = LOCAL_get16(&buf[22]);
+  if (hFatInfo->fatSectors == 0)
+    hFatInfo->fatSectors = LOCAL_get32(&buf[36]);
+  totSectors = LOCAL_get16(&buf[19]);
+  if (totSectors == 0)
+    totSectors = LOCAL_get32(&buf[32]);
+
+  hFatInfo->fatStart    = partStart + LOCAL_get16(&buf[14]);
+  hFatInfo->rootStart   = hFatInfo->fatStart + (numFATs * hFatInfo->fatSectors);
+  hFatInfo->rootSectors = ((LOCAL_get16(&buf[17]) << SDMMCFAT_DIR_ENTRY_SHIFT) + SDMMCFAT_SECTOR_SIZE - 1) >> SDMMCFAT_SECTOR_SHIFT;
+  hFatInfo->dataStart   = hFatInfo->rootStart + hFatInfo->rootSectors;
+
+  metaSectors = hFatInfo->dataStart - partStart;
+  if ((hFatInfo->fatSectors == 0) || (totSectors <= metaSectors))
+    return E_FAIL;
+  hFatInfo->clusterCnt = (totSectors - metaSectors) >> hFatInfo->clusterShift;
+
+  // FAT type is defined by the cluster count alone; FAT12 is not supported
+  if (hFatInfo->clusterCnt < 4085)
+    return E_FAIL;
+  hFatInfo->fat32 = (hFatInfo->clusterCnt >= 65525);
+  if (hFatInfo->fat32)
+  {
+    hFatInfo->rootCluster = LOCAL_get32(&buf[44]) & 0x0FFFFFFF;
+    if ((hFatInfo->rootSectors != 0) || !LOCAL_isValidCluster(hFatInfo, hFatInfo->rootCluster))
+      return E_FAIL;
+  }
+  else if (hFatInfo->rootSectors == 0)
+  {
+    return E_FAIL;
+  }
+
+  hFatInfo->clusterBuf = (Uint8 *) UTIL_allocMem(SDMMCFAT_SECTOR_SIZE << hFatInfo->clusterShift);
+  hFatInfo->fatCache = (Uint8 *) UTIL_allocMem(SDMMCFAT_FAT_CACHE_SECTORS << SDMMCFAT_SECTOR_SHIFT);
+  hFatInfo->fatCacheCnt = 0;
+  if ((hFatInfo->clusterBuf == NULL) || (hFatInfo->fatCache == NULL))
+    return E_FAIL;
+
+  return E_PASS;
+}
+
+static Uint32 LOCAL_clusterToSector(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster)
+{
+  return hFatInfo->dataStart + ((cluster - 2) << hFatInfo->clusterShift);
+}
+
+static Uint32 LOCAL_isValidCluster(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster)
+{
+  return ((cluster >= 2) && (cluster < (hFatInfo->clusterCnt + 2)));
+}
+
+// Look up the FAT entry for a cluster, refilling the cached window of FAT
+// sectors only when the entry falls outside it
+static Uint32 LOCAL_getNextCluster(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster, Uint32 *next)
+{
+  Uint32 offset, sector, cnt;
+  Uint8  *entry;
+
+  offset = hFatInfo->fat32 ? (cluster << 2) : (cluster << 1);
+  sector = offset >> SDMMCFAT_SECTOR_SHIFT;
+  if (sector >= hFatInfo->fatSectors)
+    return E_FAIL;
+
+  if ((hFatInfo->fatCacheCnt == 0) ||
+      (sector < hFatInfo->fatCacheSector) ||
+      (sector >= (hFatInfo->fatCacheSector + hFatInfo->fatCacheCnt)))
+  {
+    cnt = hFatInfo->fatSectors - sector;
+    if (cnt > SDMMCFAT_FAT_CACHE_SECTORS)
+      cnt = SDMMCFAT_FAT_CACHE_SECTORS;
+
+    hFatInfo->fatCacheCnt = 0;
+    if (LOCAL_readSectors(hFatInfo, hFatInfo->fatStart + sector, cnt, hFatInfo->fatCache) != E_PASS)
+      return E_FAIL;
+    hFatInfo->fatCacheSector = sector;
+    hFatInfo->fatCacheCnt = cnt;
+  }
+
+  entry = &hFatInfo->fatCache[((sector - hFatInfo->fatCacheSector) << SDMMCFAT_SECTOR_SHIFT) + (offset & (SDMMCFAT_SECTOR_SIZE - 1))];
+  if (hFatInfo->fat32)
+    *next = LOCAL_get32(entry) & 0x0FFFFFFF;
+  else
+    *next = LOCAL_get16(entry);
+
+  return E_PASS;
+}
+
+// Match directory entries against the boot image names
+static Uint32 LOCAL_scanDir(Uint8 *buf, Uint32 numBytes, SDMMCFAT_FileObj *files)
+{
+  Uint32 i, j, k;
+  Uint8  *entry;
+
+  for (i = 0; i < numBytes; i += SDMMCFAT_DIR_ENTRY_SIZE)
+  {
+    entry = &buf[i];
+
+    // A zero first byte marks the end of the directory
+    if (entry[0] == 0x00)
+      return SDMMCFAT_DIR_END;
+
+    // Skip deleted entries, long name entries, volume labels and directories
+    if ((entry[0] == 0xE5) || ((entry[11] & 0x0F) == 0x0F) || ((entry[11] & 0x18) != 0))
+      continue;
+
+    for (j = 0; j < SDMMCFAT_IMAGE_TYPES; j++)
+    {
+      for (k = 0; k < SDMMCFAT_NAME_LEN; k++)
+      {
+        if (entry[k] != LOCAL_imageNames[j][k])
+          break;
+      }
+      if ((k == SDMMCFAT_NAME_LEN) && !files[j].found)
+      {
+        files[j].found   = TRUE;
+        files[j].cluster = (LOCAL_get16(&entry[20]) << 16) | LOCAL_get16(&entry[26]);
+        files[j].size    = LOCAL_get32(&entry[28]);
+      }
+    }
+
+    // Nothing better can turn up once the preferred image is found
+    if (files[0].found)
+      return SDMMCFAT_DIR_END;
+  }
+
+  return SDMMCFAT_DIR_MORE;
+}
+
+// Scan the root directory a cluster at a time
+static Uint32 LOCAL_findImages(SDMMCFAT_InfoHandle hFatInfo, SDMMCFAT_FileObj *files)
+{
+  Uint32 sector, cnt, remaining, cluster, clusterSectors;
+
+  clusterSectors = 1 << hFatInfo->clusterShift;
+
+  if (!hFatInfo->fat32)
+  {
+    // FAT16 root directory is a fixed region ahead of the data area
+    sector    = hFatInfo->rootStart;
+    remaining = hFatInfo->rootSectors;
+    while (remaining > 0)
+    {
+      cnt = (remaining > clusterSectors) ? clusterSectors : remaining;
+      if (LOCAL_readSectors(hFatInfo, sector, cnt, hFatInfo->clusterBuf) != E_PASS)
+        return E_FAIL;
+      if (LOCAL_scanDir(hFatInfo->clusterBuf, cnt << SDMMCFAT_SECTOR_SHIFT, files) == SDMMCFAT_DIR_END)
+        break;
+      sector    += cnt;
+      remaining -= cnt;
+    }
+    return E_PASS;
+  }
+
+  // FAT32 root directory is an ordinary cluster chain
+  cluster = hFatInfo->rootCluster;
+  cnt = 0;
+  while (LOCAL_isValidCluster(hFatInfo, cluster))
+  {
+    // Guard against a looped chain
+    if (cnt++ > hFatInfo->clusterCnt)
+      return E_FAIL;
+
+    if (LOCAL_readSectors(hFatInfo, LOCAL_clusterToSector(hFatInfo, cluster), clusterSectors, hFatInfo->clusterBuf) != E_PASS)
+      return E_FAIL;
+    if (LOCAL_scanDir(hFatInfo->clusterBuf, clusterSectors << SDMMCFAT_SECTOR_SHIFT, files) == SDMMCFAT_DIR_END)
+      break;
+    if (LOCAL_getNextCluster(hFatInfo, cluster, &cluster) != E_PASS)
+      return E_FAIL;
+  }
+
+  return E_PASS;
+}
+
+// Stream a file straight to its destination, issuing one read per run of
+// consecutive clusters rather than one per cluster
+static Uint32 LOCAL_loadFile(SDMMCFAT_InfoHandle hFatInfo, Uint32 cluster, Uint32 byteCnt, Uint8 *dest)
+{
+  Uint32 remaining, runStart, runClusters, runSectors, next = 0;
+
+  remaining = (byteCnt + SDMMCFAT_SECTOR_SIZE - 1) >> SDMMCFAT_SECTOR_SHIFT;
+
+  while (remaining > 0)
+  {
+    if (!LOCAL_isValidCluster(hFatInfo, cluster))
+      return E_FAIL;
+
+    // Extend the run while the chain stays contiguous and more data is needed
+    runStart    = cluster;
+    runClusters = 1;
+    while ((runClusters << hFatInfo->clusterShift) < remaining)
+    {
+      if (LOCAL_getNextCluster(hFatInfo, cluster, &next) != E_PASS)
+        return E_FAIL;
+      if (next != (cluster + 1))
+        break;
+      cluster = next;
+      runClusters++;
+    }
+
+    runSectors = runClusters << hFatInfo->clusterShift;
+    if (runSectors > remaining)
+      runSectors = remaining;
+
+    if (LOCAL_readSectors(hFatInfo, LOCAL_clusterToSector(hFatInfo, runStart), runSectors, dest) != E_PASS)
+      return E_FAIL;
+
+    dest      += (runSectors << SDMMCFAT_SECTOR_SHIFT);
+    remaining -= runSectors;
+
+    // The run only ends early at a discontinuity, so next is the new start
+    cluster = next;
+  }
+
+  return E_PASS;
+}
+
+
+/***********************************************************
+* End file                                                 *
+***********************************************************/
+#endif  // #ifdef UBL_SD_MMC
@@ -26,6 +26,12 @@ extern far "c" {
 
 #define DEVICE_SDMMC_MAX_BYTES_PER_OP       (512)   // Max Bytes per operation 
 
+// MMCCLK dividers once the card is identified: MMC_CLK = fclk / (2 * (CLKRT + 1)).
+// The MMC/SD functional clock is at most 170 MHz across the PLL settings in
+// device.c, so these stay within the 20/25 MHz default and 50 MHz high speed limits.
+#define DEVICE_SDMMC_CLKRT_DEFAULT          (4)
+#define DEVICE_SDMMC_CLKRT_HIGHSPEED        (1)
+
 // Defines which SDMMC blocks the RBL will search in for a UBL image
 #define DEVICE_SDMMC_RBL_SEARCH_START_BLOCK     (1)
 #define DEVICE_SDMMC_RBL_SEARCH_END_BLOCK       (24)
@@ -34,6 +40,10 @@ extern far "c" {
 #define DEVICE_SDMMC_UBL_SEARCH_START_BLOCK     (25)
 #define DEVICE_SDMMC_UBL_SEARCH_END_BLOCK       (50)
 
+// Load address and entry point of a u-boot.bin found on a FAT partition
+#define DEVICE_SDMMC_FAT_LOAD_ADDR          (0x81080000u)
+#define DEVICE_SDMMC_FAT_ENTRY_POINT        (0x81080000u)
+
 // Used by UBL when doing UART boot, UBL Nor Boot, NAND boot or MMC_SD boot
 #define UBL_MAGIC_BIN_IMG           (0xA1ACED66)		/* Execute in place supported*/
 
@@ -433,6 +433,7 @@ DEVICE_UartRegs;
 
 #define DEVICE_UART0_DESIRED_BAUD   (115200)
 #define DEVICE_UART0_OVERSAMPLE_CNT (16)
+#define DEVICE_UART0_CLK_FREQ       (24000000u)   // UART runs from AUXCLK, not the 27MHz OSC
 
 // Timer Register structure - See sprue26.pdf for more details.
 typedef struct _DEVICE_TIMER_REGS_
@@ -1,6 +1,6 @@
 // FormUartHost.cs ------------------------------------------------------------------------------
 //
-// Implements GUI wrapper to run UART boot using AIS_Parser class (in AIS_Util namespace).
+// Implements GUI wrapper to run UART boot using AISUartHost class (in AISGenLib namespace).
 //
 // Written by Joe Coombs, 2009-02-20
 //
@@ -19,6 +19,7 @@ using System.IO;
 using System.IO.Ports;
 using System.Threading;
 using AIS_Util;
+using AISGenLib;
 
 namespace UartHost
 {
@@ -58,54 +59,15 @@ namespace UartHost
             richTextBoxLog.Clear();
         }
 
-        private int UTIL_uartRead(byte[] rcvBuf, int index, int rcvSize, int timeout)
-        {
-            int bytesRead = 0;
-
-            myUART.ReadTimeout = timeout;
-            try
-            {
-                // note: this is necessary because the SerialPort.Read method likes to return
-                // after reading only one byte, regardless of the specified count
-                while (bytesRead < rcvSize)
-                    bytesRead += myUART.Read(rcvBuf, index + bytesRead, rcvSize - bytesRead);
-            }
-            catch (Exception ex)
-            {
-                // log using invoke since this will be called by other thread
-                UTIL_log_INVOKE("(Serial Port): Read error! (" + ex.Message + ")");
-                return -1;
-            }
-
-            return 0;
-        }
-
-        private int UTIL_uartWrite(byte[] xmtBuf, int index, int xmtSize, int timeout)
-        {
-            myUART.WriteTimeout = timeout;
-            try
-            {
-                myUART.Write(xmtBuf, index, xmtSize);
-            }
-            catch (Exception ex)
-            {
-                // log using invoke since this will be called by other thread
-                UTIL_log_INVOKE("(Serial Port): Write error! (" + ex.Message + ")");
-                return -1;
-            }
-
-            return 0;
-        }
-
         private void UTIL_boot()
         {
-            // create and run AIS parser
-            AIS_Parser parser = new AIS_Parser(AIS_Parser.AIS_UART, this.UTIL_log_INVOKE, this.UTIL_uartRead, this.UTIL_uartWrite);
-            parser.waitBOOTME = checkBoxWaitForBootme.Checked;
+            // create and run binary AIS UART host
+            AISUartHost host = new AISUartHost(myUART, this.UTIL_log_INVOKE);
+            host.WaitForBOOTME = checkBoxWaitForBootme.Checked;
 
             try
             {
-                parser.boot(ais);
+                host.Boot(ais);
 
                 // reset form when done (use invoke)
                 UTIL_close_boot_INVOKE();